@@ -5,6 +5,8 @@
 #include "FurSplines.h"
 #include "FurData.h"
 #include "FurMorphObject.h"
+#include "FurMorphRemap.h"
+#include "FurSubsystem.h"
 #include "Engine/Engine.h"
 #include "Runtime/Engine/Classes/PhysicsEngine/BodySetup.h"
 #include "Runtime/Engine/Public/DynamicMeshBuilder.h"
@@ -21,6 +23,9 @@
 #include "Runtime\Engine\Classes\Engine\SkinnedAssetCommon.h"
 #include "Runtime/Engine/Classes/Components/SkinnedMeshComponent.h"
 #include "Runtime/Engine/Classes/Components/SkeletalMeshComponent.h"
+#include "UObject/ObjectSaveContext.h"
+#include "Misc/ScopeExit.h"
+#include "Algo/BinarySearch.h"
 
 #include "PrimitiveSceneProxy.h"
 
@@ -35,6 +40,59 @@
 #include "RayTracingInstance.h"
 #endif
 
+static TAutoConsoleVariable<int32> CVarFurPhysicsThrottle(
+	TEXT("gFur.PhysicsThrottle"),
+	0,
+	TEXT("Reduces the simulation rate of fur physics or freezes it for distant, insignificant or offscreen fur.\n")
+	TEXT(" 0: simulate every frame (default)\n")
+	TEXT(" 1: throttle"));
+
+static TAutoConsoleVariable<float> CVarFurPhysicsThrottleOffscreenTime(
+	TEXT("gFur.PhysicsThrottle.OffscreenTime"),
+	1.0f,
+	TEXT("Seconds without being rendered after which fur physics freezes, negative value disables freezing."));
+
+static TAutoConsoleVariable<float> CVarFurPhysicsThrottleReducedDistance(
+	TEXT("gFur.PhysicsThrottle.ReducedDistance"),
+	3000.0f,
+	TEXT("Distance to the closest view from which fur physics runs at the reduced rate, 0 disables."));
+
+static TAutoConsoleVariable<float> CVarFurPhysicsThrottleFrozenDistance(
+	TEXT("gFur.PhysicsThrottle.FrozenDistance"),
+	10000.0f,
+	TEXT("Distance to the closest view from which fur physics freezes, 0 disables."));
+
+static TAutoConsoleVariable<float> CVarFurPhysicsThrottleReducedRate(
+	TEXT("gFur.PhysicsThrottle.ReducedRate"),
+	15.0f,
+	TEXT("Steps per second of fur physics in the reduced mode, offsets are interpolated between the steps."));
+
+static TAutoConsoleVariable<float> CVarFurPhysicsThrottleReducedSignificance(
+	TEXT("gFur.PhysicsThrottle.ReducedSignificance"),
+	0.5f,
+	TEXT("Significance below which fur physics runs at the reduced rate. Significance comes from UGFurSubsystem::SetSignificanceFunction."));
+
+static TAutoConsoleVariable<float> CVarFurPhysicsThrottleFrozenSignificance(
+	TEXT("gFur.PhysicsThrottle.FrozenSignificance"),
+	0.1f,
+	TEXT("Significance below which fur physics freezes."));
+
+static TAutoConsoleVariable<int32> CVarFurMasterReferenceToLocal(
+	TEXT("gFur.MasterReferenceToLocal"),
+	1,
+	TEXT("Whether skinning matrices of fur following a master pose component are copied from the skeletal mesh object of the master.\n")
+	TEXT(" 0: compute them on the game thread from component space transforms of the master\n")
+	TEXT(" 1: copy them on the render thread when fur bones are bound like the bones of the master (default)"));
+
+static TAutoConsoleVariable<int32> CVarFurBatchedRenderUpdate(
+	TEXT("gFur.BatchedRenderUpdate"),
+	1,
+	TEXT("Whether fur components send their dynamic data to the render thread together.\n")
+	TEXT(" 0: every component enqueues its own render command\n")
+	TEXT(" 1: UGFurSubsystem submits one render command for all components when the frame starts rendering (default)"));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fur Render Updates"), STAT_FurRenderUpdates, STATGROUP_GFur);
+
 /** Scene proxy */
 class FFurSceneProxy : public FPrimitiveSceneProxy
 {
@@ -421,10 +479,12 @@ UGFurComponent::UGFurComponent(const FObjectInitializer& ObjectInitializer)
 	ReferenceHairBias = 0.8f;
 	HairLengthForceUniformity = 0.75f;
 	MaxPhysicsOffsetLength = FLT_MAX;
+	MaxPhysicsRegions = 0;
 	NoiseStrength = 0.0f;
 	CastShadow = false;
 	PrimaryComponentTick.bCanEverTick = true;
 	DisableMorphTargets = false;
+	CookMorphRemapTables = false;
 
 	StreamingDistanceMultiplier = 1.0f;
 
@@ -659,24 +719,46 @@ int32 UGFurComponent::GetNumMaterials() const
 }
 
 
+/** Creates fur data of a component, fur data being built in a task is added to OutPending and a stand-in is returned meanwhile. */
+template<typename FurDataType>
+static FurDataType* CreateComponentFurData(int32 InFurLayerCount, int32 InLod, UGFurComponent* InFurComponent, bool InAsync, TArray<FFurData*>& OutPending)
+{
+	if (!InAsync)
+		return FurDataType::CreateFurData(InFurLayerCount, InLod, InFurComponent);
+
+	FFurData* Pending = nullptr;
+	FurDataType* Data = FurDataType::CreateFurDataAsync(InFurLayerCount, InLod, InFurComponent, Pending);
+	if (Pending)
+		OutPending.Add(Pending);
+	return Data;
+}
+
+static void DestroyComponentFurData(const TArray<FFurData*>& InFurData, bool InSkeletal)
+{
+	if (InFurData.Num() == 0)
+		return;
+	if (InSkeletal)
+		FFurSkinData::DestroyFurData(InFurData);
+	else
+		FFurStaticData::DestroyFurData(InFurData);
+}
+
 FPrimitiveSceneProxy* UGFurComponent::CreateSceneProxy()
 {
+	// fur data held since the previous proxy is released once the new proxy references its own
+	TArray<FFurData*> PrevHeldFurData = MoveTemp(HeldFurData);
+	const bool PrevHeldFurDataSkeletal = HeldFurDataSkeletal;
+	HeldFurData.Reset();
+	HeldFurDataSkeletal = SkeletalGrowMesh != nullptr;
+	const bool AsyncBuild = UseAsyncFurDataBuild();
+
+	FPrimitiveSceneProxy* Proxy = nullptr;
 //	ERHIFeatureLevel::Type FeatureLevel = GetWorld()->FeatureLevel;
 //	if (FeatureLevel >= ERHIFeatureLevel::ES3_1)
 	{
-		TArray<USceneComponent*> parents;
-		GetParentComponents(parents);
-		for (USceneComponent* Comp : parents)
-		{
-			if (Comp->IsA(USkeletalMeshComponent::StaticClass()))
-			{
-				MasterPoseComponent = (USkinnedMeshComponent*)Comp;//5.1
-
-				//Deprecated for SkinnedMeshComponent;
-				//MasterPoseComponent = (USkeletalMeshComponent*)Comp; //5.0
-				break;
-			}
-		}
+		if (USkinnedMeshComponent* Comp = FindMasterPoseComponent())
+			MasterPoseComponent = Comp;
+		UpdateMasterTickPrerequisite();
 
 		MorphRemapTables.Reset();
 
@@ -696,7 +778,7 @@ FPrimitiveSceneProxy* UGFurComponent::CreateSceneProxy()
 			//bool UseMorphTargets = !DisableMorphTargets && MasterPoseComponent.IsValid() && MasterPoseComponent->SkeletalMesh->GetMorphTargets().Num() > 0;
 
 			{
-				auto Data = FFurSkinData::CreateFurData(FMath::Max(LayerCount, 1), 0, this);
+				auto Data = CreateComponentFurData<FFurSkinData>(FMath::Max(LayerCount, 1), 0, this, AsyncBuild, HeldFurData);
 				FurArray.Add(Data);
 				MorphObjects.Add(UseMorphTargets ? new FFurMorphObject(Data) : NULL);
 				if (UseMorphTargets)
@@ -704,7 +786,7 @@ FPrimitiveSceneProxy* UGFurComponent::CreateSceneProxy()
 			}
 			for (FFurLod& lod : LODs)
 			{
-				auto Data = FFurSkinData::CreateFurData(FMath::Max(lod.LayerCount, 1), FMath::Min(NumLods - 1, lod.Lod), this);
+				auto Data = CreateComponentFurData<FFurSkinData>(FMath::Max(lod.LayerCount, 1), FMath::Min(NumLods - 1, lod.Lod), this, AsyncBuild, HeldFurData);
 				if (!lod.DisableMorphTargets && UseMorphTargets)
 					CreateMorphRemapTable(FMath::Min(NumLods - 1, lod.Lod));
 				FurArray.Add(Data);
@@ -712,29 +794,93 @@ FPrimitiveSceneProxy* UGFurComponent::CreateSceneProxy()
 			}
 
 			FurData = FurArray;
+			UpdateSimulatedBones();
 
-			return new FFurSceneProxy(this, FurData, LODs, FurMaterials, OverrideMaterials, MorphObjects, CastShadow, PhysicsEnabled, GetWorld()->GetFeatureLevel());
+			Proxy = new FFurSceneProxy(this, FurData, LODs, FurMaterials, OverrideMaterials, MorphObjects, CastShadow, PhysicsEnabled, GetWorld()->GetFeatureLevel());
 		}
 		else if (StaticGrowMesh && StaticGrowMesh->GetRenderData())
 		{
-			FurArray.Add(FFurStaticData::CreateFurData(FMath::Max(LayerCount, 1), 0, this));
+			FurArray.Add(CreateComponentFurData<FFurStaticData>(FMath::Max(LayerCount, 1), 0, this, AsyncBuild, HeldFurData));
 			MorphObjects.Add(NULL);
 			for (FFurLod& lod : LODs)
 			{
-				FurArray.Add(FFurStaticData::CreateFurData(FMath::Max(lod.LayerCount, 1), FMath::Min(StaticGrowMesh->GetRenderData()->LODResources.Num() - 1, lod.Lod), this));
+				FurArray.Add(CreateComponentFurData<FFurStaticData>(FMath::Max(lod.LayerCount, 1), FMath::Min(StaticGrowMesh->GetRenderData()->LODResources.Num() - 1, lod.Lod), this, AsyncBuild, HeldFurData));
 				MorphObjects.Add(NULL);
 			}
 
 			FurData = FurArray;
-			return new FFurSceneProxy(this, FurData, LODs, FurMaterials, OverrideMaterials, MorphObjects, CastShadow, PhysicsEnabled, GetWorld()->GetFeatureLevel());
+			Proxy = new FFurSceneProxy(this, FurData, LODs, FurMaterials, OverrideMaterials, MorphObjects, CastShadow, PhysicsEnabled, GetWorld()->GetFeatureLevel());
 		}
 	}
-	return nullptr;
+
+	DestroyComponentFurData(PrevHeldFurData, PrevHeldFurDataSkeletal);
+
+	// the render state is recreated with the new fur data once all of it is built
+	if (HeldFurDataTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(HeldFurDataTickerHandle);
+		HeldFurDataTickerHandle.Reset();
+	}
+	if (HeldFurData.Num())
+	{
+		HeldFurDataTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float DeltaTime)
+		{
+			for (const FFurData* Data : HeldFurData)
+			{
+				if (!Data->IsBuilt())
+					return true;
+			}
+			HeldFurDataTickerHandle.Reset();
+			MarkRenderStateDirty();
+			return false;
+		}));
+	}
+	return Proxy;
+}
+
+bool UGFurComponent::UseAsyncFurDataBuild() const
+{
+	const UWorld* World = GetWorld();
+	return GIsEditor && World && !World->IsGameWorld() && FFurData::IsAsyncBuildEnabled();
+}
+
+void UGFurComponent::ReleaseHeldFurData()
+{
+	if (HeldFurDataTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(HeldFurDataTickerHandle);
+		HeldFurDataTickerHandle.Reset();
+	}
+	DestroyComponentFurData(HeldFurData, HeldFurDataSkeletal);
+	HeldFurData.Empty();
+}
+
+
+void UGFurComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (UGFurSubsystem* FurSubsystem = UWorld::GetSubsystem<UGFurSubsystem>(GetWorld()))
+		FurSubsystem->Register(this);
+}
+
+
+void UGFurComponent::OnUnregister()
+{
+	if (UGFurSubsystem* FurSubsystem = UWorld::GetSubsystem<UGFurSubsystem>(GetWorld()))
+		FurSubsystem->Unregister(this);
+	PhysicsPending = false;
+	if (USkinnedMeshComponent* Master = TickPrerequisiteMaster.Get())
+		RemoveTickPrerequisiteComponent(Master);
+	TickPrerequisiteMaster.Reset();
+
+	Super::OnUnregister();
 }
 
 
 void UGFurComponent::CreateRenderState_Concurrent(FRegisterComponentContext* Context)
 {
+	WaitForPhysics();
 //	ERHIFeatureLevel::Type FeatureLevel = GetWorld()->FeatureLevel;
 //	if (FeatureLevel >= ERHIFeatureLevel::ES3_1)
 	{
@@ -768,6 +914,7 @@ void UGFurComponent::SendRenderDynamicData_Concurrent()
 
 void UGFurComponent::DestroyRenderState_Concurrent()
 {
+	WaitForPhysics();
 	Super::DestroyRenderState_Concurrent();
 
 //	ERHIFeatureLevel::Type FeatureLevel = GetWorld()->FeatureLevel;
@@ -777,7 +924,16 @@ void UGFurComponent::DestroyRenderState_Concurrent()
 			mat->RemoveFromRoot();
 		FurMaterials.Reset();
 
-		if (SkeletalGrowMesh)
+		// edited components keep their fur data as a stand-in until fur data of the new parameters is built
+		const bool Skeletal = SkeletalGrowMesh != nullptr;
+		if (FurData.Num() && (Skeletal || StaticGrowMesh) && UseAsyncFurDataBuild())
+		{
+			if (HeldFurData.Num() && HeldFurDataSkeletal != Skeletal)
+				ReleaseHeldFurData();
+			HeldFurData.Append(FurData);
+			HeldFurDataSkeletal = Skeletal;
+		}
+		else if (SkeletalGrowMesh)
 			FFurSkinData::DestroyFurData(FurData);
 		else if (StaticGrowMesh)
 			FFurStaticData::DestroyFurData(FurData);
@@ -789,6 +945,7 @@ void UGFurComponent::DestroyRenderState_Concurrent()
 void UGFurComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	LastDeltaTime = DeltaTime;
+	PhysicsPending = true;
 
 	MarkRenderDynamicDataDirty();
 }
@@ -831,63 +988,160 @@ void UGFurComponent::updateFur()
 	if (!SceneProxy || (!SkeletalGrowMesh && !StaticGrowMesh))
 		return;
 
+	// physics is normally batched with other components by UGFurSubsystem, simulate it here if that didn't happen this frame
+	WaitForPhysics();
+	if (!PhysicsSimulated)
+		SimulatePhysics();
+	PhysicsSimulated = false;
+
+	// We prepare the next frame but still have the value from the last one
+	FFurRenderUpdate Update;
+	Update.FurComponent = this;
+	Update.DynamicDataSubmission = FurDynamicData.GetSubmission();
+	Update.DynamicData = FurDynamicData.Submit();
+
+	uint32 RevisionNumber = MasterPoseComponent.IsValid() ? MasterPoseComponent->GetBoneTransformRevisionNumber() : 0;
+	Update.Discontinuous = RevisionNumber - LastRevisionNumber > 1;
+	if (UseMasterReferenceToLocal)
+	{
+		// skinning matrices aren't compared on the game thread, a new pose of the master is a new revision
+		Update.UseMasterReferenceToLocal = true;
+		Update.MasterMeshObject = MasterPoseComponent.IsValid() ? MasterPoseComponent->MeshObject : nullptr;
+		if (RevisionNumber != LastRevisionNumber)
+			BoneDataRevision++;
+	}
+	LastRevisionNumber = RevisionNumber;
+	Update.BoneDataRevision = BoneDataRevision;
+
+	// only weights of active morph targets are sent, in frame memory which is moved to the render command
+	const USkinnedMeshComponent* MasterComp = MasterPoseComponent.Get();
+	if (MasterComp && SkeletalGrowMesh && !DisableMorphTargets)
+	{
+		Update.ActiveMorphTargets.Reserve(MasterComp->ActiveMorphTargets.Num());
+		for (const auto& Pair : MasterComp->ActiveMorphTargets)
+		{
+			if (MasterComp->MorphTargetWeights.IsValidIndex(Pair.Value))
+				Update.ActiveMorphTargets.Add({ Pair.Key, MasterComp->MorphTargetWeights[Pair.Value] });
+		}
+	}
+
+	// the subsystem submits updates of all components in one render command
+	UGFurSubsystem* FurSubsystem = UWorld::GetSubsystem<UGFurSubsystem>(GetWorld());
+	if (FurSubsystem && CVarFurBatchedRenderUpdate.GetValueOnAnyThread())
+	{
+		FurSubsystem->QueueRenderUpdate(MoveTemp(Update));
+		return;
+	}
+
+	// queue a call to update this data
+	INC_DWORD_STAT(STAT_FurRenderCommands);
+	ENQUEUE_RENDER_COMMAND(SkelMeshObjectUpdateDataCommand)(
+		[this, Update = MoveTemp(Update)](FRHICommandListImmediate& RHICmdList)
+	{
+		UpdateFur_RenderThread(RHICmdList, Update);
+	}
+	);
+}
+
+void UGFurComponent::SimulatePhysics()
+{
+	const UGFurSubsystem* FurSubsystem = UWorld::GetSubsystem<UGFurSubsystem>(GetWorld());
+	BeginPhysics(FurSubsystem ? FurSubsystem->GetSignificance(this) : 1.0f);
+	if (!GatherPhysics())
+		return;
+	if (IntegratePhysics)
+		PhysicsState.Integrate(PhysicsParameters, 0, PhysicsState.NumBlocks());
+	FinishPhysics();
+}
+
+void UGFurComponent::BeginPhysics(float Significance)
+{
+	PhysicsToWorld = GetComponentTransform().ToMatrixNoScale();
+
+	const USkinnedMeshComponent* MasterComp = MasterPoseComponent.Get();
+	// Only batched updates are submitted after the end of frame updates of all components, so only then the master has
+	// already enqueued the update of its skeletal mesh object and its matrices are of this frame.
+	UseMasterReferenceToLocal = SkeletalGrowMesh && MasterBindPoseMatches && MasterComp && MasterComp->MeshObject
+		&& CVarFurMasterReferenceToLocal.GetValueOnAnyThread() != 0 && CVarFurBatchedRenderUpdate.GetValueOnAnyThread() != 0
+		&& UWorld::GetSubsystem<UGFurSubsystem>(GetWorld());
+
+	FFurPhysicsThrottleSettings Settings;
+	Settings.OffscreenTime = -1.0f;
+	if (CVarFurPhysicsThrottle.GetValueOnAnyThread())
+	{
+		Settings.OffscreenTime = CVarFurPhysicsThrottleOffscreenTime.GetValueOnAnyThread();
+		Settings.ReducedDistance = CVarFurPhysicsThrottleReducedDistance.GetValueOnAnyThread();
+		Settings.FrozenDistance = CVarFurPhysicsThrottleFrozenDistance.GetValueOnAnyThread();
+		Settings.ReducedSignificance = CVarFurPhysicsThrottleReducedSignificance.GetValueOnAnyThread();
+		Settings.FrozenSignificance = CVarFurPhysicsThrottleFrozenSignificance.GetValueOnAnyThread();
+		Settings.ReducedInterval = 1.0f / FMath::Max(CVarFurPhysicsThrottleReducedRate.GetValueOnAnyThread(), 1.0f);
+	}
+
+	float TimeSinceRendered = -1.0f;
+	float Distance = 0.0f;
+	if (const UWorld* World = GetWorld())
+	{
+		// the engine initializes the render time far in the past, fur which was never rendered yet isn't offscreen
+		const float LastRenderTime = GetLastRenderTimeOnScreen();
+		if (LastRenderTime > -1000.0f)
+			TimeSinceRendered = World->GetTimeSeconds() - LastRenderTime;
+		if (World->ViewLocationsRenderedLastFrame.Num())
+		{
+			double MinDistanceSquared = DBL_MAX;
+			const FVector Location = GetComponentLocation();
+			for (const FVector& ViewLocation : World->ViewLocationsRenderedLastFrame)
+				MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(ViewLocation, Location));
+			Distance = (float)FMath::Sqrt(MinDistanceSquared);
+		}
+	}
+
+	PhysicsStep = PhysicsThrottle.Update(Settings, LastDeltaTime, TimeSinceRendered, Distance, Significance);
+
+	// gathering may run on a worker thread, the snapshot is picked here
+	BeginDynamicData();
+}
+
+void UGFurComponent::WaitForPhysics()
+{
+	if (PhysicsEvent.IsValid())
+	{
+		PhysicsEvent->Wait();
+		PhysicsEvent = nullptr;
+	}
+}
+
+bool UGFurComponent::GatherPhysics()
+{
+	PhysicsPending = false;
+	if (!SceneProxy || (!SkeletalGrowMesh && !StaticGrowMesh))
+		return false;
+
 	FFurSceneProxy* Scene = (FFurSceneProxy*)SceneProxy;
 	int32 FurLodLevel = Scene->GetCurrentFurLodLevel();
 
+	FFurDynamicData& Data = FurDynamicData.GetCurrent();
+	const FFurDynamicData& PrevData = GetPreviousDynamicData();
+
 	bool LodPhysicsEnabled = PhysicsEnabled && (FurLodLevel == 0 || LODs[FurLodLevel - 1].PhysicsEnabled);
 
-	float DeltaTime = fminf(LastDeltaTime, 1.0f);
+	float DeltaTime = fminf(PhysicsThrottle.GetStepDeltaTime(), 1.0f);
 	float ReferenceFurLength = FMath::Max(0.00001f, Scene->GetFurData(true)->GetCurrentMaxFurLength() * ReferenceHairBias + Scene->GetFurData(true)->GetCurrentMinFurLength() * (1.0f - ReferenceHairBias));
 	//	float ForceFactor = 1.0f / (powf(ReferenceFurLength, FurForcePower) * fmaxf(FurStiffness, 0.000001f));
 	float ForceFactor = 1.0f / powf(ReferenceFurLength, ForceDistribution);
 	float DampingClamped = fmaxf(Damping, 0.000001f);
-	float DampingFactor = powf(1.0f - (DampingClamped / (DampingClamped + 1.0f)), DeltaTime);
 	float MaxForceFinal = (MaxForce * ReferenceFurLength) / powf(ReferenceFurLength, ForceDistribution);
-	float MaxTorque = MaxForceTorqueFactor * MaxForceFinal / Scene->GetFurData(true)->GetMaxVertexBoneDistance();
-	//	FVector FurForceFinal = FurForce * (fmaxf(FurWeight, 0.000001f) * ForceFactor);
-	FVector FurForceFinal = ConstantForce * ReferenceFurLength * ForceFactor / Stiffness;
-
 	float x = DeltaTime * Stiffness;
 
-	FMatrix ToWorld = GetComponentTransform().ToMatrixNoScale();
-
-	auto Physics = [&](const FMatrix& NewTransformation, FMatrix& Transformation, FVector& LinearOffset, FVector& LinearVelocity
-		, FVector& AngularOffset, FVector& AngularVelocity) {
-		FVector d = (NewTransformation.GetOrigin() - Transformation.GetOrigin());
-		d *= ForceFactor;
-		LinearOffset -= d;
-
-		FVector force;
-		FVector newOffset = (LinearVelocity * FMath::Sin(x) + (LinearOffset - FurForceFinal) * FMath::Cos(x)) * DampingFactor + FurForceFinal;
-		FVector newVelocity = (LinearVelocity * FMath::Cos(x) - (LinearOffset - FurForceFinal) * FMath::Sin(x)) * DampingFactor;
-		check(newOffset.X == newOffset.X && newOffset.Y == newOffset.Y && newOffset.Z == newOffset.Z);
-		check(newVelocity.X == newVelocity.X && newVelocity.Y == newVelocity.Y && newVelocity.Z == newVelocity.Z);
-		LinearOffset = newOffset;
-		LinearVelocity = newVelocity;
-		if (LinearOffset.Size() > MaxForceFinal)
-		{
-			LinearOffset *= MaxForceFinal / LinearOffset.Size();
-			float k = FVector::DotProduct(LinearOffset, LinearVelocity) / FVector::DotProduct(LinearOffset, LinearOffset);
-			if (k > 0.0f)
-				LinearVelocity -= LinearOffset * k;
-		}
+	PhysicsParameters.ForceFactor = ForceFactor;
+	PhysicsParameters.SinX = FMath::Sin(x);
+	PhysicsParameters.CosX = FMath::Cos(x);
+	PhysicsParameters.DampingFactor = powf(1.0f - (DampingClamped / (DampingClamped + 1.0f)), DeltaTime);
+	PhysicsParameters.MaxForce = MaxForceFinal;
+	PhysicsParameters.MaxTorque = MaxForceTorqueFactor * MaxForceFinal / Scene->GetFurData(true)->GetMaxVertexBoneDistance();
+	//	FVector FurForceFinal = FurForce * (fmaxf(FurWeight, 0.000001f) * ForceFactor);
+	PhysicsParameters.ConstantForce = FVector3f(ConstantForce * ReferenceFurLength * ForceFactor / Stiffness);
 
-		FQuat rdiff = NewTransformation.ToQuat() * Transformation.ToQuat().Inverse();
-		float angle;
-		rdiff.ToAxisAndAngle(d, angle);
-		if (angle > PI)
-			angle -= 2 * PI;
-		d *= -angle * ForceFactor;
-		AngularOffset -= d;
-		newOffset = (AngularVelocity * FMath::Sin(x) + AngularOffset * FMath::Cos(x)) * DampingFactor;
-		newVelocity = (AngularVelocity * FMath::Cos(x) - AngularOffset * FMath::Sin(x)) * DampingFactor;
-		AngularOffset = newOffset;
-		AngularVelocity = newVelocity;
-		if (AngularOffset.Size() > MaxTorque)
-			AngularOffset *= MaxTorque / AngularOffset.Size();
-
-		Transformation = NewTransformation;
-	};
+	const FMatrix& ToWorld = PhysicsToWorld;
 
 	if (SkeletalGrowMesh)
 	{
@@ -896,30 +1150,33 @@ void UGFurComponent::updateFur()
 		const USkinnedAsset* const MasterCompMesh = MasterComp ? MasterComp->GetSkinnedAsset() : nullptr;
 		const auto& LOD = SkeletalGrowMesh->GetResourceForRendering()->LODRenderData[Scene->GetCurrentMeshLodLevel()];
 
-		TArray<FMatrix, TInlineAllocator<256>> TempMatrices;
-		TArray<bool, TInlineAllocator<256>> ValidTempMatrices;
+		TArray<FMatrix>& TempMatrices = GatheredMatrices;
+		TArray<bool>& ValidTempMatrices = ValidGatheredMatrices;
 		const auto& RefSkeleton = ThisMesh->GetRefSkeleton();
 		const auto& RefBasesInvMatrix = ThisMesh->GetRefBasesInvMatrix();
 		check(RefBasesInvMatrix.Num() != 0);
-		if (ReferenceToLocal.Num() != RefBasesInvMatrix.Num())
+		if (Data.ReferenceToLocal.Num() != RefBasesInvMatrix.Num())
 		{
-			Transformations.Reset();
-			Transformations.AddUninitialized(RefBasesInvMatrix.Num());
-			ReferenceToLocal.Reset();
-			ReferenceToLocal.AddUninitialized(RefBasesInvMatrix.Num());
-			LinearVelocities.Reset();
-			LinearVelocities.AddUninitialized(RefBasesInvMatrix.Num());
-			AngularVelocities.Reset();
-			AngularVelocities.AddUninitialized(RefBasesInvMatrix.Num());
-			LinearOffsets.Reset();
-			LinearOffsets.AddUninitialized(RefBasesInvMatrix.Num());
-			AngularOffsets.Reset();
-			AngularOffsets.AddUninitialized(RefBasesInvMatrix.Num());
+			// bones not driving fur keep identity
+			Data.ReferenceToLocal.Reset();
+			Data.ReferenceToLocal.Init(FMatrix::Identity, RefBasesInvMatrix.Num());
+		}
+		if (PrevData.ReferenceToLocal.Num() != Data.ReferenceToLocal.Num())
+			OldPositionValid = false;
+		const bool PrevValid = PrevData.Generation == FurDynamicDataGeneration && PrevData.ReferenceToLocal.Num() == Data.ReferenceToLocal.Num();
+		if (!PrevValid)
+			BoneDataChanged = true;
+		if (PhysicsState.Num() != PhysicsRegionBones.Num())
+		{
+			PhysicsState.SetNum(PhysicsRegionBones.Num());
 			OldPositionValid = false;
 		}
+		SimulatedBonePositions.SetNumUninitialized(SimulatedBones.Num());
 
-		ValidTempMatrices.AddDefaulted(ReferenceToLocal.Num());
-		TempMatrices.AddUninitialized(ReferenceToLocal.Num());
+		ValidTempMatrices.Reset();
+		TempMatrices.Reset();
+		ValidTempMatrices.AddDefaulted(Data.ReferenceToLocal.Num());
+		TempMatrices.AddUninitialized(Data.ReferenceToLocal.Num());
 
 		int32 SyncLODLevel = 0;
 		if (MasterComp && MasterComp->GetSkinnedAsset() && MasterComp->MeshObject)
@@ -954,6 +1211,8 @@ void UGFurComponent::updateFur()
 			for (int32 BoneIndex = 0; BoneIndex < RequiredBoneIndices.Num(); BoneIndex++)
 			{
 				const int32 ThisBoneIndex = RequiredBoneIndices[BoneIndex];
+				if (!GatheredBones.IsValidIndex(ThisBoneIndex) || !GatheredBones[ThisBoneIndex])
+					continue;
 				if (ThisBoneIndex >= ValidTempMatrices.Num())
 				{
 					auto Count = ThisBoneIndex - ValidTempMatrices.Num() + 1;
@@ -1008,91 +1267,207 @@ void UGFurComponent::updateFur()
 			}
 		}
 
-		if (OldPositionValid && LodPhysicsEnabled)
+		for (int32 Index = 0; Index < SimulatedBones.Num(); ++Index)
 		{
-			for (int32 ThisBoneIndex = 0; ThisBoneIndex < ReferenceToLocal.Num(); ++ThisBoneIndex)
+			const int32 ThisBoneIndex = SimulatedBones[Index];
+			const bool ComputeReferenceToLocal = !UseMasterReferenceToLocal || (MasterUnmappedBones.IsValidIndex(ThisBoneIndex) && MasterUnmappedBones[ThisBoneIndex]);
+			FMatrix NewTransformation = FMatrix::Identity;
+			FMatrix NewReferenceToLocal = FMatrix::Identity;
+			if (ValidTempMatrices[ThisBoneIndex])
 			{
-				FMatrix NewTransformation;
-				if (ValidTempMatrices[ThisBoneIndex])
-				{
-					ReferenceToLocal[ThisBoneIndex] = FMatrix(RefBasesInvMatrix[ThisBoneIndex]) * TempMatrices[ThisBoneIndex];
-					NewTransformation = TempMatrices[ThisBoneIndex] * ToWorld;
-					NewTransformation.RemoveScaling();
-				}
-				else
-				{
-					ReferenceToLocal[ThisBoneIndex] = FMatrix::Identity;
-					NewTransformation = FMatrix::Identity;
-				}
-
-				Physics(NewTransformation, Transformations[ThisBoneIndex], LinearOffsets[ThisBoneIndex], LinearVelocities[ThisBoneIndex]
-					, AngularOffsets[ThisBoneIndex], AngularVelocities[ThisBoneIndex]);
+				// the master already computed skinning matrices for its own render data, they are copied on the render thread
+				if (ComputeReferenceToLocal)
+					NewReferenceToLocal = FMatrix(RefBasesInvMatrix[ThisBoneIndex]) * TempMatrices[ThisBoneIndex];
+				NewTransformation = TempMatrices[ThisBoneIndex] * ToWorld;
+				NewTransformation.RemoveScaling();
 			}
-		}
-		else
-		{
-			for (int32 ThisBoneIndex = 0; ThisBoneIndex < ReferenceToLocal.Num(); ++ThisBoneIndex)
+			if (ComputeReferenceToLocal)
 			{
-				if (ValidTempMatrices[ThisBoneIndex])
-				{
-					ReferenceToLocal[ThisBoneIndex] = FMatrix(RefBasesInvMatrix[ThisBoneIndex]) * TempMatrices[ThisBoneIndex];
-					Transformations[ThisBoneIndex] = TempMatrices[ThisBoneIndex] * ToWorld;
-					Transformations[ThisBoneIndex].RemoveScaling();
-				}
-				else
-				{
-					ReferenceToLocal[ThisBoneIndex] = FMatrix::Identity;
-					Transformations[ThisBoneIndex] = FMatrix::Identity;
-				}
-
-				LinearOffsets[ThisBoneIndex].Set(0.0f, 0.0f, 0.0f);
-				AngularOffsets[ThisBoneIndex].Set(0.0f, 0.0f, 0.0f);
-
-				LinearVelocities[ThisBoneIndex].Set(0.0f, 0.0f, 0.0f);
-				AngularVelocities[ThisBoneIndex].Set(0.0f, 0.0f, 0.0f);
+				if (!PrevValid || PrevData.ReferenceToLocal[ThisBoneIndex] != NewReferenceToLocal)
+					BoneDataChanged = true;
+				Data.ReferenceToLocal[ThisBoneIndex] = NewReferenceToLocal;
 			}
-			OldPositionValid = true;
+			SimulatedBonePositions[Index] = FVector3f(NewTransformation.GetOrigin());
+			const int32 Region = SimulatedBoneRegions[Index];
+			if (PhysicsRegionBones[Region] == Index)
+				PhysicsState.SetNewTransform(Region, SimulatedBonePositions[Index], FQuat4f(NewTransformation.ToQuat()));
 		}
 	}
 	else
 	{
 		check(StaticGrowMesh);
-		if (OldPositionValid && LodPhysicsEnabled)
+		if (PhysicsState.Num() != 1)
 		{
-			Physics(ToWorld, StaticTransformation, StaticLinearOffset, StaticLinearVelocity, StaticAngularOffset, StaticAngularVelocity);
+			PhysicsState.SetNum(1);
+			OldPositionValid = false;
 		}
-		else
+		PhysicsState.SetNewTransform(0, FVector3f(ToWorld.GetOrigin()), FQuat4f(ToWorld.ToQuat()));
+	}
+
+	IntegratePhysics = OldPositionValid && LodPhysicsEnabled && PhysicsStep;
+	PhysicsHold = false;
+	if (!OldPositionValid || !LodPhysicsEnabled)
+	{
+		PhysicsState.Reset();
+		PhysicsThrottle.ResetInterpolation();
+		OldPositionValid = true;
+	}
+	else if (IntegratePhysics)
+	{
+		// bones moved while physics was frozen, catch up with them without a pop
+		if (PhysicsThrottle.IsResuming())
+			PhysicsState.Teleport();
+
+		if (PhysicsThrottle.GetMode() == EFurPhysicsMode::Reduced)
 		{
-			StaticTransformation = ToWorld;
+			const int32 Num = PhysicsState.Num();
+			PrevLinearOffsets.SetNumUninitialized(Num);
+			PrevAngularOffsets.SetNumUninitialized(Num);
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				PrevLinearOffsets[Index] = PhysicsState.GetLinearOffset(Index);
+				PrevAngularOffsets[Index] = PhysicsState.GetAngularOffset(Index);
+			}
+		}
+	}
+	else
+	{
+		PhysicsHold = PhysicsThrottle.GetMode() == EFurPhysicsMode::Frozen;
+	}
+	return true;
+}
+
+void UGFurComponent::BeginDynamicData()
+{
+	FFurDynamicData& Data = FurDynamicData.Begin();
+	if (Data.Generation != FurDynamicDataGeneration)
+	{
+		Data.ReferenceToLocal.Reset();
+		Data.LinearOffsets.Reset();
+		Data.AngularOffsets.Reset();
+		Data.BonePositions.Reset();
+		Data.Generation = FurDynamicDataGeneration;
+	}
+	Data.ForceDistribution = ForceDistribution;
+	Data.MaxPhysicsOffsetLength = MaxPhysicsOffsetLength;
+}
 
-			StaticLinearOffset.Set(0.0f, 0.0f, 0.0f);
-			StaticAngularOffset.Set(0.0f, 0.0f, 0.0f);
+FFurDynamicDataRing::FFurDynamicDataRing()
+{
+	// one snapshot written, one read and one submitted in between is the steady state with one submission per frame
+	for (int32 SnapshotIndex = 0; SnapshotIndex < 3; SnapshotIndex++)
+		Snapshots.Add(new FFurDynamicData());
+}
 
-			StaticLinearVelocity.Set(0.0f, 0.0f, 0.0f);
-			StaticAngularVelocity.Set(0.0f, 0.0f, 0.0f);
+FFurDynamicData& FFurDynamicDataRing::Begin()
+{
+	// an unsubmitted snapshot is written again
+	if (Submitted)
+	{
+		Submitted = false;
+		Submission++;
+		PreviousIndex = Index;
 
-			OldPositionValid = true;
+		int32 NextIndex = INDEX_NONE;
+		for (int32 Offset = 1; Offset < Snapshots.Num(); Offset++)
+		{
+			const int32 Candidate = (Index + Offset) % Snapshots.Num();
+			if (!Snapshots[Candidate].InFlight.load(std::memory_order_acquire))
+			{
+				NextIndex = Candidate;
+				break;
+			}
 		}
+		if (NextIndex == INDEX_NONE)
+			NextIndex = Snapshots.Add(new FFurDynamicData());
+		Index = NextIndex;
 	}
 
-	// We prepare the next frame but still have the value from the last one
-	uint32 RevisionNumber = MasterPoseComponent.IsValid() ? MasterPoseComponent->GetBoneTransformRevisionNumber() : 0;
-	bool Discontinuous = RevisionNumber - LastRevisionNumber > 1;
-	LastRevisionNumber = RevisionNumber;
+	FFurDynamicData& Data = Snapshots[Index];
+	Data.Submission.store(Submission, std::memory_order_release);
+	return Data;
+}
 
-	// queue a call to update this data
-	FMorphTargetWeightMap ActiveMorphTargets = MasterPoseComponent->ActiveMorphTargets;
-	TArray<float> MorphTargetWeights = MasterPoseComponent->MorphTargetWeights;
-	ENQUEUE_RENDER_COMMAND(SkelMeshObjectUpdateDataCommand)(
-		[this, Discontinuous, ActiveMorphTargets, MorphTargetWeights](FRHICommandListImmediate& RHICmdList)
+const FFurDynamicData* FFurDynamicDataRing::Submit()
+{
+	FFurDynamicData& Data = Snapshots[Index];
+	Data.InFlight.store(true, std::memory_order_relaxed);
+	Submitted = true;
+	return &Data;
+}
+
+void UGFurComponent::FinishPhysics()
+{
+	// offsets are rendered per skeleton bone, bones that don't drive fur stay at rest
+	const bool Skeletal = SkeletalGrowMesh != nullptr;
+	const int32 Num = Skeletal ? SimulatedBones.Num() : PhysicsState.Num();
+	FFurDynamicData& Data = FurDynamicData.GetCurrent();
+	const FFurDynamicData& PrevData = GetPreviousDynamicData();
+	const int32 NumBones = Skeletal ? Data.ReferenceToLocal.Num() : Num;
+	if (Data.LinearOffsets.Num() != NumBones)
 	{
-		UpdateFur_RenderThread(RHICmdList, Discontinuous, ActiveMorphTargets, MorphTargetWeights);
+		Data.LinearOffsets.SetNumZeroed(NumBones);
+		Data.AngularOffsets.SetNumZeroed(NumBones);
+		Data.BonePositions.SetNumZeroed(NumBones);
 	}
-	);
+	const bool PrevValid = PrevData.Generation == FurDynamicDataGeneration && PrevData.LinearOffsets.Num() == NumBones;
+	if (!PrevValid)
+		BoneDataChanged = true;
+
+	// frozen physics keeps the offsets shown last
+	const bool UpdateOffsets = !PhysicsHold || !PrevValid;
+	const float Alpha = PhysicsThrottle.GetInterpolationAlpha();
+	const bool Interpolate = Alpha < 1.0f && PrevLinearOffsets.Num() == PhysicsState.Num();
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		const int32 BoneIndex = Skeletal ? (int32)SimulatedBones[Index] : Index;
+		const int32 Region = Skeletal ? SimulatedBoneRegions[Index] : Index;
+		const FVector3f BonePosition = Skeletal ? SimulatedBonePositions[Index] : PhysicsState.GetNewPosition(Index);
+		FVector3f LinearOffset = PrevValid ? PrevData.LinearOffsets[BoneIndex] : FVector3f::ZeroVector;
+		FVector3f AngularOffset = PrevValid ? PrevData.AngularOffsets[BoneIndex] : FVector3f::ZeroVector;
+		if (UpdateOffsets)
+		{
+			if (Interpolate)
+			{
+				LinearOffset = FMath::Lerp(PrevLinearOffsets[Region], PhysicsState.GetLinearOffset(Region), Alpha);
+				AngularOffset = FMath::Lerp(PrevAngularOffsets[Region], PhysicsState.GetAngularOffset(Region), Alpha);
+			}
+			else
+			{
+				LinearOffset = PhysicsState.GetLinearOffset(Region);
+				AngularOffset = PhysicsState.GetAngularOffset(Region);
+			}
+		}
+
+		if (!PrevValid || PrevData.BonePositions[BoneIndex] != BonePosition || PrevData.LinearOffsets[BoneIndex] != LinearOffset || PrevData.AngularOffsets[BoneIndex] != AngularOffset)
+			BoneDataChanged = true;
+		Data.BonePositions[BoneIndex] = BonePosition;
+		Data.LinearOffsets[BoneIndex] = LinearOffset;
+		Data.AngularOffsets[BoneIndex] = AngularOffset;
+	}
+
+	// render thread skips the bone upload while the revision stays the same
+	if (BoneDataChanged)
+	{
+		BoneDataRevision++;
+		BoneDataChanged = false;
+	}
+	PhysicsSimulated = true;
 }
 
-void UGFurComponent::UpdateFur_RenderThread(FRHICommandListImmediate& RHICmdList, bool Discontinuous, const FMorphTargetWeightMap& ActiveMorphTargets, const TArray<float>& MorphTargetWeights)
+void UGFurComponent::UpdateFur_RenderThread(FRHICommandListImmediate& RHICmdList, const FFurRenderUpdate& Update)
 {
+	const bool Discontinuous = Update.Discontinuous;
+	FSkeletalMeshObject* MasterMeshObject = Update.MasterMeshObject;
+	INC_DWORD_STAT(STAT_FurRenderUpdates);
+
+	const FFurDynamicData& Data = *Update.DynamicData;
+	ensureMsgf(Data.Submission.load(std::memory_order_acquire) == Update.DynamicDataSubmission, TEXT("Fur dynamic data was overwritten before the render thread used it."));
+	ON_SCOPE_EXIT
+	{
+		FFurDynamicDataRing::Release(&Data);
+	};
+
 	FFurSceneProxy* FurProxy = (FFurSceneProxy*)SceneProxy;
 
 	if (FurProxy)
@@ -1104,16 +1479,57 @@ void UGFurComponent::UpdateFur_RenderThread(FRHICommandListImmediate& RHICmdList
 		{
 			const auto& LOD = SkeletalGrowMesh->GetResourceForRendering()->LODRenderData[FurProxy->GetCurrentMeshLodLevel()];
 			const auto& Sections = LOD.RenderSections;
-			for (int32 SectionIdx = 0; SectionIdx < Sections.Num(); SectionIdx++)
+			if (Sections.Num())
 			{
-				FurProxy->GetVertexFactory(SectionIdx, true)->UpdateSkeletonShaderData(ForceDistribution, MaxPhysicsOffsetLength, ReferenceToLocal, LinearOffsets, AngularOffsets, Transformations,
-					Sections[SectionIdx].BoneMap, Discontinuous || CurrentLOD != LastLOD, SceneFeatureLevel);
+				// one upload per bone map, usually a single one for the whole LOD as section vertex factories share the bone buffers
+				const auto* SkinData = static_cast<FFurSkinData*>(FurProxy->GetFurData(true));
+				const TArray<TArray<FBoneIndexType>>& BoneMaps = SkinData->GetBoneMaps_RenderThread();
+				const TArray<FMatrix>* SkinningMatrices = &Data.ReferenceToLocal;
+
+				int32 NumBones = 0;
+				for (const TArray<FBoneIndexType>& BoneMap : BoneMaps)
+				{
+					for (FBoneIndexType BoneIndex : BoneMap)
+						NumBones = FMath::Max(NumBones, BoneIndex + 1);
+				}
+
+				// Batched updates are submitted after the master enqueued the update of its skeletal mesh object, so its matrices
+				// are of this frame. Bones the master doesn't have use ReferenceToLocal from the reference pose, and without dynamic
+				// data of the master the last copied pose stays, which starts as the bind pose the master itself renders then.
+				if (Update.UseMasterReferenceToLocal && NumBones)
+				{
+					const bool MasterValid = MasterMeshObject && MasterMeshObject->HaveValidDynamicData() && MasterBoneMap_RenderThread.Num();
+					const TArray<FMatrix44f>* MasterReferenceToLocal = MasterValid ? &MasterMeshObject->GetReferenceToLocalMatrices() : nullptr;
+					const TArray<int32>* BoneMap = MasterValid ? &MasterBoneMap_RenderThread[FMath::Clamp(MasterMeshObject->GetLOD(), 0, MasterBoneMap_RenderThread.Num() - 1)] : nullptr;
+					for (int32 BoneIndex = MasterReferenceToLocal_RenderThread.Num(); BoneIndex < NumBones; BoneIndex++)
+						MasterReferenceToLocal_RenderThread.Add(FMatrix::Identity);
+					for (const TArray<FBoneIndexType>& MappedBones : BoneMaps)
+					{
+						for (FBoneIndexType BoneIndex : MappedBones)
+						{
+							const int32 MasterBoneIndex = BoneMap && BoneMap->IsValidIndex(BoneIndex) ? (*BoneMap)[BoneIndex] : INDEX_NONE;
+							if (MasterReferenceToLocal && MasterReferenceToLocal->IsValidIndex(MasterBoneIndex))
+								MasterReferenceToLocal_RenderThread[BoneIndex] = FMatrix((*MasterReferenceToLocal)[MasterBoneIndex]);
+							else if (MasterValid && Data.ReferenceToLocal.IsValidIndex(BoneIndex))
+								MasterReferenceToLocal_RenderThread[BoneIndex] = Data.ReferenceToLocal[BoneIndex];
+						}
+					}
+					SkinningMatrices = &MasterReferenceToLocal_RenderThread;
+				}
+
+				for (int32 BoneMapIndex = 0; BoneMapIndex < BoneMaps.Num(); BoneMapIndex++)
+				{
+					FurProxy->GetVertexFactory(BoneMapIndex, true)->GetSkinBoneData()->Update(RHICmdList, *SkinningMatrices, Data.LinearOffsets, Data.AngularOffsets, Data.BonePositions,
+						BoneMaps[BoneMapIndex], Update.BoneDataRevision, Discontinuous || CurrentLOD != LastLOD);
+				}
 			}
+			for (int32 SectionIdx = 0; SectionIdx < Sections.Num(); SectionIdx++)
+				FurProxy->GetVertexFactory(SectionIdx, true)->UpdateSkeletonShaderData(Data.ForceDistribution, Data.MaxPhysicsOffsetLength);
 			if (!DisableMorphTargets && MasterPoseComponent.IsValid() && FurProxy->GetMorphObject(true))
 			{
-				int32 FurLodLevel = FurProxy->GetCurrentFurLodLevel();
-				if (FurLodLevel == 0 || !LODs[FurLodLevel - 1].DisableMorphTargets){}
-					FurProxy->GetMorphObject(true)->Update_RenderThread(RHICmdList, ActiveMorphTargets, MorphTargetWeights, MorphRemapTables, FurProxy->GetCurrentMeshLodLevel());
+				const auto& MorphRemapTable = MorphRemapTables[FurProxy->GetCurrentMeshLodLevel()];
+				if (MorphRemapTable.IsValid())
+					FurProxy->GetMorphObject(true)->Update_RenderThread(RHICmdList, Update.ActiveMorphTargets, *MorphRemapTable, FurProxy->GetCurrentMeshLodLevel());
 			}
 		}
 		else if (StaticGrowMesh)
@@ -1122,14 +1538,70 @@ void UGFurComponent::UpdateFur_RenderThread(FRHICommandListImmediate& RHICmdList
 			const auto& Sections = LOD.Sections;
 			for (int32 SectionIdx = 0; SectionIdx < Sections.Num(); SectionIdx++)
 			{
-				FurProxy->GetVertexFactory(SectionIdx, true)->UpdateStaticShaderData(ForceDistribution, StaticLinearOffset, StaticAngularOffset,
-					StaticTransformation.GetOrigin(), Discontinuous || CurrentLOD != LastLOD, SceneFeatureLevel);
+				FurProxy->GetVertexFactory(SectionIdx, true)->UpdateStaticShaderData(Data.ForceDistribution, FVector(Data.LinearOffsets[0]), FVector(Data.AngularOffsets[0]),
+					FVector(Data.BonePositions[0]), Discontinuous || CurrentLOD != LastLOD, SceneFeatureLevel);
 			}
 		}
 		LastLOD = CurrentLOD;
 	}
 }
 
+void UGFurComponent::UpdateSimulatedBones()
+{
+	const FReferenceSkeleton& RefSkeleton = SkeletalGrowMesh->GetRefSkeleton();
+
+	// union of bones driving fur in all LODs, gathered bones include their ancestors for hidden and reference pose bones
+	TBitArray<> FurBones(false, RefSkeleton.GetNum());
+	for (FFurData* Data : FurData)
+	{
+		for (FBoneIndexType BoneIndex : static_cast<FFurSkinData*>(Data)->GetFurBones())
+		{
+			if (FurBones.IsValidIndex(BoneIndex))
+				FurBones[BoneIndex] = true;
+		}
+	}
+
+	SimulatedBones.Reset();
+	GatheredBones.Init(false, RefSkeleton.GetNum());
+	for (TConstSetBitIterator<> It(FurBones); It; ++It)
+	{
+		SimulatedBones.Add(It.GetIndex());
+		for (int32 BoneIndex = It.GetIndex(); BoneIndex != INDEX_NONE && !GatheredBones[BoneIndex]; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+			GatheredBones[BoneIndex] = true;
+	}
+
+	// regions are cached by the fur data of the most detailed LOD, bones driving fur only in other LODs are regions of their own
+	const int32 NumSimulatedBones = SimulatedBones.Num();
+	TArray<int32> LodBoneRegions;
+	TArray<int32> LodRegionBones;
+	FFurSkinData* LodData = FurData.Num() ? static_cast<FFurSkinData*>(FurData[0]) : nullptr;
+	if (MaxPhysicsRegions > 0 && NumSimulatedBones > MaxPhysicsRegions && LodData && LodData->GetPhysicsRegions(MaxPhysicsRegions, LodBoneRegions, LodRegionBones))
+	{
+		const TArray<FBoneIndexType>& LodBones = LodData->GetFurBones();
+		PhysicsRegionBones.Reset(LodRegionBones.Num());
+		for (int32 LodBoneIndex : LodRegionBones)
+			PhysicsRegionBones.Add(Algo::BinarySearch(SimulatedBones, LodBones[LodBoneIndex]));
+
+		SimulatedBoneRegions.SetNumUninitialized(NumSimulatedBones);
+		for (int32 Index = 0; Index < NumSimulatedBones; Index++)
+		{
+			const int32 LodBoneIndex = Algo::BinarySearch(LodBones, SimulatedBones[Index]);
+			SimulatedBoneRegions[Index] = LodBoneIndex != INDEX_NONE ? LodBoneRegions[LodBoneIndex] : PhysicsRegionBones.Add(Index);
+		}
+	}
+	else
+	{
+		SimulatedBoneRegions.SetNumUninitialized(NumSimulatedBones);
+		PhysicsRegionBones.SetNumUninitialized(NumSimulatedBones);
+		for (int32 Index = 0; Index < NumSimulatedBones; Index++)
+			SimulatedBoneRegions[Index] = PhysicsRegionBones[Index] = Index;
+	}
+
+	// bones may have changed, snapshots are cleared when physics writes them next time so that bones not driving fur anymore
+	// are at rest, the render thread may still be reading them now
+	FurDynamicDataGeneration++;
+}
+
 void UGFurComponent::UpdateMasterBoneMap()
 {
 	MasterBoneMap.Empty();
@@ -1177,135 +1649,134 @@ void UGFurComponent::UpdateMasterBoneMap()
 					MasterBoneMap[LODIndex][BoneIndex] = -1;
 			}
 		}
+
+		// bones missing in any LOD of the master fall back to the reference pose like when gathered on the game thread
+		MasterUnmappedBones.Init(false, CurrentMasterBoneMap.Num());
+		for (const TArray<int32>& LodBoneMap : MasterBoneMap)
+		{
+			for (int32 i = 0; i < LodBoneMap.Num(); i++)
+			{
+				if (LodBoneMap[i] == INDEX_NONE)
+					MasterUnmappedBones[i] = true;
+			}
+		}
+
+		// skinning matrices of the master fit fur bones bound the same way
+		const auto& RefBasesInvMatrix = SkeletalGrowMesh->GetRefBasesInvMatrix();
+		const auto& ParentRefBasesInvMatrix = ParentMesh->GetRefBasesInvMatrix();
+		MasterBindPoseMatches = true;
+		for (int32 i = 0; i < MasterBoneMap[0].Num() && MasterBindPoseMatches; i++)
+		{
+			const int32 ParentBoneIndex = MasterBoneMap[0][i];
+			if (ParentBoneIndex == INDEX_NONE)
+				continue;
+			MasterBindPoseMatches = RefBasesInvMatrix.IsValidIndex(i) && ParentRefBasesInvMatrix.IsValidIndex(ParentBoneIndex)
+				&& RefBasesInvMatrix[i].Equals(ParentRefBasesInvMatrix[ParentBoneIndex], 1.e-4f);
+		}
 	}
+	else
+	{
+		MasterBindPoseMatches = false;
+		MasterUnmappedBones.Reset();
+	}
+
+	ENQUEUE_RENDER_COMMAND(UpdateMasterBoneMapCommand)([this, NewMasterBoneMap = MasterBoneMap](FRHICommandListImmediate& RHICmdList) {
+		MasterBoneMap_RenderThread = NewMasterBoneMap;
+	});
 }
 
-void UGFurComponent::CreateMorphRemapTable(int32 InLod)
+void UGFurComponent::UpdateMasterTickPrerequisite()
 {
-	auto& MorphRemapTable = MorphRemapTables[InLod];
-	if (MorphRemapTable.Num() > 0)
+	// the master ticks first, its pose of the frame is final when fur reads it
+	USkinnedMeshComponent* Master = MasterPoseComponent.Get();
+	if (TickPrerequisiteMaster.Get() == Master)
 		return;
+	if (USkinnedMeshComponent* OldMaster = TickPrerequisiteMaster.Get())
+		RemoveTickPrerequisiteComponent(OldMaster);
+	if (Master)
+		AddTickPrerequisiteComponent(Master);
+	TickPrerequisiteMaster = Master;
+}
 
-	auto* MasterMesh = MasterPoseComponent->GetSkinnedAsset()->GetResourceForRendering();
-	check(MasterMesh);
-
-	const auto& MasterLodModel = MasterMesh->LODRenderData[FMath::Min(InLod, MasterMesh->LODRenderData.Num() - 1)];
-	const auto& MasterPositions = MasterLodModel.StaticVertexBuffers.PositionVertexBuffer;
-	const auto& MasterSkinWeights = MasterLodModel.SkinWeightVertexBuffer;
-	const auto& MasterVertices = MasterLodModel.StaticVertexBuffers.StaticMeshVertexBuffer;
-
-	auto* Mesh = SkeletalGrowMesh->GetResourceForRendering();
-	const auto& LodModel = Mesh->LODRenderData[InLod];
-	const auto& Positions = LodModel.StaticVertexBuffers.PositionVertexBuffer;
-	const auto& SkinWeights = LodModel.SkinWeightVertexBuffer;
-	const auto& Vertices = LodModel.StaticVertexBuffers.StaticMeshVertexBuffer;
+USkinnedMeshComponent* UGFurComponent::FindMasterPoseComponent() const
+{
+	TArray<USceneComponent*> parents;
+	GetParentComponents(parents);
+	for (USceneComponent* Comp : parents)
+	{
+		if (Comp->IsA(USkeletalMeshComponent::StaticClass()))
+		{
+			return (USkinnedMeshComponent*)Comp;//5.1
 
-	MorphRemapTable.AddUninitialized(MasterPositions.GetNumVertices());
-	for (int i = 0, c = MasterPositions.GetNumVertices(); i < c; i++)
-		MorphRemapTable[i] = -1;
+			//Deprecated for SkinnedMeshComponent;
+			//return (USkeletalMeshComponent*)Comp; //5.0
+		}
+	}
+	return nullptr;
+}
 
-	uint32 UVCount = FMath::Min(MasterVertices.GetNumTexCoords(), Vertices.GetNumTexCoords());
+void UGFurComponent::CreateMorphRemapTable(int32 InLod)
+{
+	auto& MorphRemapTable = MorphRemapTables[InLod];
+	if (MorphRemapTable.IsValid())
+		return;
 
-	FVector Min(FLT_MAX);
-	FVector Max(-FLT_MAX);
-	for (const auto& Section : LodModel.RenderSections)
+	const USkinnedAsset* MasterMesh = MasterPoseComponent->GetSkinnedAsset();
+	const TArray<int32>* CookedRemapTable = nullptr;
+	for (const FFurMorphRemapTableData& CookedTable : CookedMorphRemapTables)
 	{
-		for (uint32 i = Section.BaseVertexIndex; i < Section.BaseVertexIndex + Section.NumVertices; i++)
+		if (CookedTable.MasterMesh == MasterMesh && CookedTable.GrowMesh == SkeletalGrowMesh && CookedTable.Lod == InLod)
 		{
-			const auto& Position = Positions.VertexPosition(i);
-			if (Position.X < Min.X)
-				Min.X = Position.X;
-			if (Position.Y < Min.Y)
-				Min.Y = Position.Y;
-			if (Position.Z < Min.Z)
-				Min.Z = Position.Z;
-			if (Position.X > Max.X)
-				Max.X = Position.X;
-			if (Position.Y > Max.Y)
-				Max.Y = Position.Y;
-			if (Position.Z > Max.Z)
-				Max.Z = Position.Z;
+			CookedRemapTable = &CookedTable.RemapTable;
+			break;
 		}
 	}
 
+	MorphRemapTable = FFurMorphRemapCache::FindOrBuild(MasterMesh, SkeletalGrowMesh, InLod, CookedRemapTable);
+}
+
+void UGFurComponent::BeginDestroy()
+{
+	ReleaseHeldFurData();
 
-	auto Hash = [&Min, &Max](const FVector& Position) {
-		FVector V = (Position - Min) / (Max - Min);
-		return (uint16)(V.X * (64 * 1024) + V.Y * (64 * 1024) + V.Y * (64 * 1024));
-	};
+	Super::BeginDestroy();
+}
 
-	TArray<FHashTable> HashTables;
-	for (const auto& Section : LodModel.RenderSections)
+#if WITH_EDITOR
+void UGFurComponent::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	if (!ObjectSaveContext.IsCooking())
+		return;
+
+	CookedMorphRemapTables.Reset();
+
+	USkinnedMeshComponent* Master = FindMasterPoseComponent();
+	if (!CookMorphRemapTables || DisableMorphTargets || !SkeletalGrowMesh || !SkeletalGrowMesh->GetResourceForRendering() || !Master || !Master->GetSkinnedAsset()
+		|| Master->GetSkinnedAsset()->GetMorphTargets().Num() == 0)
+		return;
+
+	int32 NumLods = SkeletalGrowMesh->GetResourceForRendering()->LODRenderData.Num();
+	TArray<int32, TInlineAllocator<8>> MorphLods;
+	MorphLods.Add(0);
+	for (const FFurLod& lod : LODs)
 	{
-		HashTables.Add(FHashTable(64 * 1024, Section.NumVertices));
-		FHashTable& hashTable = HashTables[HashTables.Num() - 1];
-		for (uint32 i = Section.BaseVertexIndex; i < Section.BaseVertexIndex + Section.NumVertices; i++)
-		{
-			const auto& Position = Positions.VertexPosition(i);
-			hashTable.Add(Hash(FVector(Position)), i);
-		}
+		if (!lod.DisableMorphTargets)
+			MorphLods.AddUnique(FMath::Min(NumLods - 1, lod.Lod));
 	}
 
-	for (const auto& MasterSection : MasterLodModel.RenderSections)
+	for (int32 Lod : MorphLods)
 	{
-		for (int32 SectionIndex = 0; SectionIndex < LodModel.RenderSections.Num(); SectionIndex++)
+		FFurMorphRemapTablePtr RemapTable = FFurMorphRemapCache::FindOrBuild(Master->GetSkinnedAsset(), SkeletalGrowMesh, Lod);
+		if (RemapTable.IsValid())
 		{
-			const auto& Section = LodModel.RenderSections[SectionIndex];
-			if (MasterSection.MaterialIndex == Section.MaterialIndex)
-			{
-				const FHashTable& hashTable = HashTables[SectionIndex];
-				for (uint32 i = MasterSection.BaseVertexIndex; i < MasterSection.BaseVertexIndex + MasterSection.NumVertices; i++)
-				{
-					const auto& MasterPosition = MasterPositions.VertexPosition(i);
-					const auto& MasterTangentX = MasterVertices.VertexTangentX(i);
-					const auto& MasterTangentY = MasterVertices.VertexTangentY(i);
-					const auto& MasterTangentZ = MasterVertices.VertexTangentZ(i);
-
-					auto Compare = [&](uint32 Index) {
-						const auto& Position = Positions.VertexPosition(Index);
-						const auto& TangentX = Vertices.VertexTangentX(Index);
-						const auto& TangentY = Vertices.VertexTangentY(Index);
-						const auto& TangentZ = Vertices.VertexTangentZ(Index);
-						if (MasterPosition == Position && MasterTangentX == TangentX && MasterTangentY == TangentY && MasterTangentZ == TangentZ)
-						{
-							for (uint32 k = 0; k < UVCount; k++)
-							{
-								if (MasterVertices.GetVertexUV(i, k) != Vertices.GetVertexUV(Index, k))
-									return false;
-							}
-							MorphRemapTable[i] = Index;
-							return true;
-						}
-						return false;
-					};
-
-					for (uint32 Idx = hashTable.First(Hash(FVector(MasterPosition))); hashTable.IsValid(Idx); Idx = hashTable.Next(Idx))
-					{
-						if (Compare(Idx))
-							break;
-					}
-
-/*
-					bool Found = false;
-					for (uint32 j = FMath::Max(i, Section.BaseVertexIndex); j < Section.BaseVertexIndex + Section.NumVertices; j++)
-					{
-						if (Compare(j))
-						{
-							Found = true;
-							break;
-						}
-					}
-
-					if (!Found)
-					{
-						for (uint32 j = Section.BaseVertexIndex, e = FMath::Min(i, Section.BaseVertexIndex + Section.NumVertices); j < e; j++)
-						{
-							if (Compare(j))
-								break;
-						}
-					}*/
-				}
-			}
+			FFurMorphRemapTableData& CookedTable = CookedMorphRemapTables.AddDefaulted_GetRef();
+			CookedTable.MasterMesh = Master->GetSkinnedAsset();
+			CookedTable.GrowMesh = SkeletalGrowMesh;
+			CookedTable.Lod = Lod;
+			CookedTable.RemapTable = *RemapTable;
 		}
 	}
 }
+#endif
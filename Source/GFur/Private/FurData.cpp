@@ -4,6 +4,18 @@
 
 
 #include "FurComponent.h"
+#include "GFur.h"
+
+static TAutoConsoleVariable<int32> CVarFurAsyncCombRebuild(
+	TEXT("gFur.AsyncCombRebuild"),
+	1,
+	TEXT("Whether fur of combed vertices and fur of parameters edited in the editor is rebuilt in task graph tasks.\n")
+	TEXT(" 0: rebuild on the game thread with every comb stroke and parameter change\n")
+	TEXT(" 1: rebuild in a task, strokes made while it runs are merged into the next rebuild and edited components keep\n")
+	TEXT("    rendering fur of the previous parameters until their fur is built (default)"));
+
+DECLARE_CYCLE_STAT(TEXT("Fur Comb Rebuild"), STAT_FurCombRebuild, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fur Comb Rebuild Vertices"), STAT_FurCombRebuildVertices, STATGROUP_GFur);
 
 /** Fur Vertex Buffer */
 FFurVertexBuffer::~FFurVertexBuffer()
@@ -118,6 +130,10 @@ const int32 FFurData::MinimalFurLayerCount = 1;
 const int32 FFurData::MaximalFurLayerCount = 128;
 const float FFurData::MinimalFurLength = 0.001f;
 
+FCriticalSection FFurData::BuildFurCS;
+TArray<FFurData*> FFurData::BuildFurQueue;
+FTSTicker::FDelegateHandle FFurData::BuildFurTickerHandle;
+
 FFurData::FFurData()
 {
 	RefCount = 1;
@@ -179,35 +195,29 @@ bool FFurData::Similar(int InLod, class UGFurComponent* InFurComponent)
 	return Lod == InLod && FurSplinesAssigned == InFurComponent->FurSplines && RemoveFacesWithoutSplines == InFurComponent->RemoveFacesWithoutSplines;
 }
 
-void FFurData::GenerateSplineMap(const FPositionVertexBuffer& InPositions)
+/** Uniform grid over first control points of splines in the XY plane, finds the spline a vertex grows from. */
+class FFurSplineRootGrid
 {
-	SplineMap.Reset();
-	VertexRemap.Reset();
-	if (FurSplinesUsed)
+public:
+	/** Grid of splines from InFirstSpline to the last one. */
+	FFurSplineRootGrid(const UFurSplines* InSplines, int32 InFirstSpline)
+		: Splines(InSplines)
 	{
-		uint32 SourceVertexCount = InPositions.GetNumVertices();
-		int32 SplineCount = FurSplinesUsed->SplineCount();
-
-		uint32 ValidVertexCount = 0;
-		float MinLenSquared = FLT_MAX;
-		float MaxLenSquared = -FLT_MAX;
-		SplineMap.AddUninitialized(SourceVertexCount);
+		int32 SplineCount = Splines->SplineCount();
+		IsEmpty = InFirstSpline >= SplineCount;
 
-		const int32 Size = 64;
-		TArray<int32> Cells;
-		TArray<int32> NextIndex;
 		Cells.AddUninitialized(Size * Size);
 		for (int32 i = 0; i < Size * Size; i++)
 			Cells[i] = -1;
 		NextIndex.AddUninitialized(SplineCount);
 
-		float MinX = FLT_MAX;
-		float MinY = FLT_MAX;
+		MinX = FLT_MAX;
+		MinY = FLT_MAX;
 		float MaxX = -FLT_MAX;
 		float MaxY = -FLT_MAX;
-		for (int32 i = 0; i < SplineCount; i++)
+		for (int32 i = InFirstSpline; i < SplineCount; i++)
 		{
-			FVector p = FurSplinesUsed->GetFirstControlPoint(i);
+			FVector p = Splines->GetFirstControlPoint(i);
 			if (p.X < MinX)
 				MinX = p.X;
 			if (p.Y < MinY)
@@ -221,12 +231,12 @@ void FFurData::GenerateSplineMap(const FPositionVertexBuffer& InPositions)
 		MinY -= 1.0f;
 		MaxX += 1.0f;
 		MaxY += 1.0f;
-		float FactorWidth = Size / (MaxX - MinX);
-		float FactorHeight = Size / (MaxY - MinY);
+		FactorWidth = Size / (MaxX - MinX);
+		FactorHeight = Size / (MaxY - MinY);
 
-		for (int32 i = 0; i < SplineCount; i++)
+		for (int32 i = InFirstSpline; i < SplineCount; i++)
 		{
-			FVector p = FurSplinesUsed->GetFirstControlPoint(i);
+			FVector p = Splines->GetFirstControlPoint(i);
 			uint32 X = FMath::FloorToInt((p.X - MinX) * FactorWidth);
 			uint32 Y = FMath::FloorToInt((p.Y - MinY) * FactorHeight);
 			check(X < Size && Y < Size);
@@ -244,65 +254,79 @@ void FFurData::GenerateSplineMap(const FPositionVertexBuffer& InPositions)
 				NextIndex[i] = -1;
 			}
 		}
+	}
 
-
-		for (uint32 i = 0; i < SourceVertexCount; i++)
+	/** Closest spline within the threshold of the splines growing out of the surface, -1 if there's none. */
+	int32 FindClosestSpline(const FVector& p, const FVector& Normal, float MinFurLength) const
+	{
+		if (IsEmpty)
+			return -1;
+
+		const float Epsilon = Splines->Threshold;
+		const float EpsilonSquared = Epsilon * Epsilon;
+		int32 BeginX = FMath::Max(FMath::FloorToInt((p.X - Epsilon - MinX) * FactorWidth), 0);
+		int32 BeginY = FMath::Max(FMath::FloorToInt((p.Y - Epsilon - MinY) * FactorHeight), 0);
+		int32 EndX = FMath::Min(FMath::FloorToInt((p.X + Epsilon - MinX) * FactorWidth), Size - 1);
+		int32 EndY = FMath::Min(FMath::FloorToInt((p.Y + Epsilon - MinY) * FactorHeight), Size - 1);
+		float ClosestDistanceSquared = FLT_MAX;
+		int32 ClosestIndex = -1;
+		for (int32 Y = BeginY; Y <= EndY; Y++)
 		{
-			const float Epsilon = FurSplinesUsed->Threshold;
-			const float EpsilonSquared = Epsilon * Epsilon;
-			FVector p = FVector(InPositions.VertexPosition(i));
-			int32 BeginX = FMath::Max(FMath::FloorToInt((p.X - Epsilon - MinX) * FactorWidth), 0);
-			int32 BeginY = FMath::Max(FMath::FloorToInt((p.Y - Epsilon - MinY) * FactorHeight), 0);
-			int32 EndX = FMath::Min(FMath::FloorToInt((p.X + Epsilon - MinX) * FactorWidth), Size - 1);
-			int32 EndY = FMath::Min(FMath::FloorToInt((p.Y + Epsilon - MinY) * FactorHeight), Size - 1);
-			SplineMap[i] = -1;
-			float ClosestDistanceSquared = FLT_MAX;
-			int32 ClosestIndex = -1;
-			for (int32 Y = BeginY; Y <= EndY; Y++)
+			for (int32 X = BeginX; X <= EndX; X++)
 			{
-				for (int32 X = BeginX; X <= EndX; X++)
+				if (X < Size && Y < Size)
 				{
-					if (X < Size && Y < Size)
+					int32 Idx = Cells[Y * Size + X];
+					while (Idx != -1)
 					{
-						int32 Idx = Cells[Y * Size + X];
-						while (Idx != -1)
+						FVector s = Splines->GetFirstControlPoint(Idx);
+						float DistanceSquared = FVector::DistSquared(s, p);
+						if (DistanceSquared <= EpsilonSquared)
 						{
-							FVector s = FurSplinesUsed->GetFirstControlPoint(Idx);
-							float DistanceSquared = FVector::DistSquared(s, p);
-							if (DistanceSquared <= EpsilonSquared)
+							FVector s2 = Splines->GetLastControlPoint(Idx);
+							if (FVector::DotProduct(s2 - s, Normal) > 0.0f || MinFurLength > 0.0f)
 							{
-								FVector s2 = FurSplinesUsed->GetLastControlPoint(Idx);
-								if (FVector::DotProduct(s2 - s, Normals[i]) > 0.0f || MinFurLength > 0.0f)
+								if (DistanceSquared < ClosestDistanceSquared)
 								{
-									if (DistanceSquared < ClosestDistanceSquared)
-									{
-										ClosestDistanceSquared = DistanceSquared;
-										ClosestIndex = Idx;
-									}
+									ClosestDistanceSquared = DistanceSquared;
+									ClosestIndex = Idx;
 								}
 							}
-							Idx = NextIndex[Idx];
 						}
+						Idx = NextIndex[Idx];
 					}
 				}
 			}
-			SplineMap[i] = ClosestIndex;
-			if (ClosestIndex != -1)
-			{
-				FVector s = FurSplinesUsed->GetFirstControlPoint(ClosestIndex);
-				FVector s2 = FurSplinesUsed->GetLastControlPoint(ClosestIndex);
-				float SizeSquared = (s2 - s).SizeSquared();
-				if (SizeSquared < MinLenSquared)
-					MinLenSquared = SizeSquared;
-				if (SizeSquared > MaxLenSquared)
-					MaxLenSquared = SizeSquared;
-				ValidVertexCount++;
-			}
 		}
-		CurrentMinFurLength = FMath::Sqrt(MinLenSquared) * FurLength;
-		if (CurrentMinFurLength < MinFurLength)
-			CurrentMinFurLength = MinFurLength;
-		CurrentMaxFurLength = FMath::Sqrt(MaxLenSquared) * FurLength;
+		return ClosestIndex;
+	}
+
+private:
+	static const int32 Size = 64;
+
+	const UFurSplines* Splines;
+	TArray<int32> Cells;
+	TArray<int32> NextIndex;
+	float MinX;
+	float MinY;
+	float FactorWidth;
+	float FactorHeight;
+	bool IsEmpty;
+};
+
+void FFurData::GenerateSplineMap(const FPositionVertexBuffer& InPositions)
+{
+	SplineMap.Reset();
+	VertexRemap.Reset();
+	if (FurSplinesUsed)
+	{
+		uint32 SourceVertexCount = InPositions.GetNumVertices();
+		SplineMap.AddUninitialized(SourceVertexCount);
+
+		FFurSplineRootGrid Grid(FurSplinesUsed, 0);
+		for (uint32 i = 0; i < SourceVertexCount; i++)
+			SplineMap[i] = Grid.FindClosestSpline(FVector(InPositions.VertexPosition(i)), Normals[i], MinFurLength);
+		uint32 ValidVertexCount = UpdateFurLengthRange();
 
 		if (RemoveFacesWithoutSplines)
 		{
@@ -320,6 +344,93 @@ void FFurData::GenerateSplineMap(const FPositionVertexBuffer& InPositions)
 	}
 }
 
+uint32 FFurData::UpdateFurLengthRange()
+{
+	return CalcFurLengthRange(CurrentMinFurLength, CurrentMaxFurLength);
+}
+
+uint32 FFurData::CalcFurLengthRange(float& OutMinFurLength, float& OutMaxFurLength) const
+{
+	uint32 ValidVertexCount = 0;
+	float MinLenSquared = FLT_MAX;
+	float MaxLenSquared = -FLT_MAX;
+	for (int32 SplineIndex : SplineMap)
+	{
+		if (SplineIndex != -1)
+		{
+			FVector s = FurSplinesUsed->GetFirstControlPoint(SplineIndex);
+			FVector s2 = FurSplinesUsed->GetLastControlPoint(SplineIndex);
+			float SizeSquared = (s2 - s).SizeSquared();
+			if (SizeSquared < MinLenSquared)
+				MinLenSquared = SizeSquared;
+			if (SizeSquared > MaxLenSquared)
+				MaxLenSquared = SizeSquared;
+			ValidVertexCount++;
+		}
+	}
+	OutMinFurLength = FMath::Sqrt(MinLenSquared) * FurLength;
+	if (OutMinFurLength < MinFurLength)
+		OutMinFurLength = MinFurLength;
+	OutMaxFurLength = FMath::Sqrt(MaxLenSquared) * FurLength;
+	return ValidVertexCount;
+}
+
+bool FFurData::UpdateSplineMap(const FPositionVertexBuffer& InPositions, const TArray<int32>& InRemovedSplines, int32 InAddedSplineCount, TArray<uint32>& OutAffectedVertices)
+{
+	// removed faces change vertex and index buffers, generated splines don't follow the assigned ones
+	if (!FurSplinesUsed || FurSplinesUsed != FurSplinesAssigned || RemoveFacesWithoutSplines || (uint32)SplineMap.Num() != InPositions.GetNumVertices())
+		return false;
+
+	int32 SplineCount = FurSplinesUsed->SplineCount();
+	int32 FirstAddedSpline = SplineCount - InAddedSplineCount;
+
+	// splines following removed ones moved down
+	TArray<int32> SplineRemap;
+	if (InRemovedSplines.Num())
+	{
+		SplineRemap.AddUninitialized(FirstAddedSpline + InRemovedSplines.Num());
+		for (int32 OldIndex = 0, RemovedIndex = 0; OldIndex < SplineRemap.Num(); OldIndex++)
+		{
+			if (RemovedIndex < InRemovedSplines.Num() && InRemovedSplines[RemovedIndex] == OldIndex)
+			{
+				SplineRemap[OldIndex] = -1;
+				RemovedIndex++;
+			}
+			else
+			{
+				SplineRemap[OldIndex] = OldIndex - RemovedIndex;
+			}
+		}
+	}
+
+	// only vertices which lost their spline or have a new one in reach look for the closest spline again
+	FFurSplineRootGrid Grid(FurSplinesUsed, 0);
+	FFurSplineRootGrid AddedGrid(FurSplinesUsed, FirstAddedSpline);
+	OutAffectedVertices.Reset();
+	for (uint32 i = 0, SourceVertexCount = SplineMap.Num(); i < SourceVertexCount; i++)
+	{
+		FVector p = FVector(InPositions.VertexPosition(i));
+		bool Affected = false;
+		if (SplineRemap.Num() && SplineMap[i] != -1)
+		{
+			SplineMap[i] = SplineRemap[SplineMap[i]];
+			Affected = SplineMap[i] == -1;
+		}
+		if (!Affected && AddedGrid.FindClosestSpline(p, Normals[i], MinFurLength) != -1)
+			Affected = true;
+		if (Affected)
+		{
+			SplineMap[i] = Grid.FindClosestSpline(p, Normals[i], MinFurLength);
+			OutAffectedVertices.Add(i);
+		}
+	}
+
+	// the length range scales texture coordinates of all vertices, running rebuilds of combed vertices read it too
+	float NewMinFurLength, NewMaxFurLength;
+	CalcFurLengthRange(NewMinFurLength, NewMaxFurLength);
+	return NewMinFurLength == CurrentMinFurLength && NewMaxFurLength == CurrentMaxFurLength;
+}
+
 FFurData::FFurGenLayerData FFurData::CalcFurGenLayerData(int32 Layer)
 {
 	FFurGenLayerData Data;
@@ -340,24 +451,203 @@ FFurData::FFurGenLayerData FFurData::CalcFurGenLayerData(int32 Layer)
 	return Data;
 }
 
-void FFurData::GenerateFurLengths(TArray<float>& FurLengths)
+void FFurData::ScheduleBuildFur(const TArray<uint32>& InVertexSet)
 {
-	if (FurSplinesUsed)
+	if (CVarFurAsyncCombRebuild.GetValueOnGameThread() == 0)
 	{
-		int32 ControlPointCount = FurSplinesUsed->ControlPointCount;
-		FurLengths.AddUninitialized(FurSplinesUsed->SplineCount());
-		for (int32 SplineIndex = 0, SplineCount = FurSplinesUsed->SplineCount(); SplineIndex < SplineCount; SplineIndex++)
+		WaitForFullBuild();
+		// a rebuild launched before the switch is submitted first
+		WaitForBuildFur(false);
+		WaitForRenderThreadDataSubmission();
+
+		FScopeLock Lock(&BuildFurCS);
+		PendingCombedVertices.Append(InVertexSet);
+		GatherCombedVertices();
+		{
+			SCOPE_CYCLE_COUNTER(STAT_FurCombRebuild);
+			BuildFur(CombedVertices);
+		}
+		CombedVertices = FCombedVertices();
+		SubmitVertexBuffer();
+		return;
+	}
+
+	FScopeLock Lock(&BuildFurCS);
+	PendingCombedVertices.Append(InVertexSet);
+	BuildFurQueue.AddUnique(this);
+	if (!BuildFurTickerHandle.IsValid())
+		BuildFurTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FFurData::TickBuildFur));
+}
+
+bool FFurData::IsAsyncBuildEnabled()
+{
+	return CVarFurAsyncCombRebuild.GetValueOnAnyThread() != 0;
+}
+
+void FFurData::WaitForFullBuild() const
+{
+	if (FullBuildEvent.IsValid())
+		FullBuildEvent->Wait();
+}
+
+void FFurData::WaitForBuildFur(bool InDiscard)
+{
+	FScopeLock Lock(&BuildFurCS);
+
+	if (CombBuildEvent.IsValid())
+	{
+		CombBuildEvent->Wait();
+		CombBuildEvent = nullptr;
+		CombedVertices = FCombedVertices();
+		if (!InDiscard)
+			SubmitVertexBuffer();
+	}
+
+	if (InDiscard)
+	{
+		PendingCombedVertices.Reset();
+		BuildFurQueue.Remove(this);
+	}
+}
+
+void FFurData::GatherCombedVertices()
+{
+	// sorted vertices walk the sections of skeletal meshes in order
+	CombedVertices.Vertices = PendingCombedVertices.Array();
+	CombedVertices.Vertices.Sort();
+	PendingCombedVertices.Reset();
+	SET_DWORD_STAT(STAT_FurCombRebuildVertices, CombedVertices.Vertices.Num());
+
+	CombedVertices.VertexSplines.Reset();
+	CombedVertices.ControlPoints.Reset();
+	CombedVertices.Lengths.Reset();
+	if (!FurSplinesUsed)
+		return;
+
+	// only splines of the combed vertices are copied, the comb keeps editing the splines while the task runs
+	TMap<int32, int32> SplineSlots;
+	CombedVertices.VertexSplines.Reserve(CombedVertices.Vertices.Num());
+	for (uint32 VertexIndex : CombedVertices.Vertices)
+	{
+		int32 SplineIndex = SplineMap[VertexIndex];
+		int32 Slot = -1;
+		if (SplineIndex >= 0)
 		{
-			float Length = 0.0f;
-			FVector Prev = FurSplinesUsed->Vertices[SplineIndex * ControlPointCount];
-			for (int32 ControlPointIndex = 1; ControlPointIndex < ControlPointCount; ControlPointIndex++)
+			if (const int32* ExistingSlot = SplineSlots.Find(SplineIndex))
+			{
+				Slot = *ExistingSlot;
+			}
+			else
 			{
-				FVector Point = FurSplinesUsed->Vertices[SplineIndex * ControlPointCount + ControlPointIndex];
-				Length += FVector::Dist(Point, Prev);
-				Prev = Point;
+				const FVector* ControlPoints = GetSplineControlPoints(SplineIndex);
+				Slot = CombedVertices.Lengths.Add(CalcSplineFurLength(ControlPoints));
+				CombedVertices.ControlPoints.Append(ControlPoints, FurSplinesUsed->ControlPointCount);
+				SplineSlots.Add(SplineIndex, Slot);
 			}
-			FurLengths[SplineIndex] = FMath::Max(Length * FurLength, MinFurLength);
 		}
+		CombedVertices.VertexSplines.Add(Slot);
+	}
+}
+
+void FFurData::SubmitVertexBuffer()
+{
+	VertexBuffer.Unlock();
+	SubmitRenderThreadData();
+}
+
+void FFurData::SubmitRenderThreadData()
+{
+	FGraphEventRef Submission = FGraphEvent::CreateGraphEvent();
+	{
+		FScopeLock Lock(&RenderThreadDataSubmissionCS);
+		RenderThreadDataSubmission = Submission;
+	}
+	ENQUEUE_RENDER_COMMAND(UpdateDataCommand)([Submission](FRHICommandListImmediate& RHICmdList) {
+		Submission->DispatchSubsequents();
+	});
+}
+
+FGraphEventRef FFurData::GetRenderThreadDataSubmission()
+{
+	FScopeLock Lock(&RenderThreadDataSubmissionCS);
+	return RenderThreadDataSubmission;
+}
+
+void FFurData::WaitForRenderThreadDataSubmission()
+{
+	FGraphEventRef Submission = GetRenderThreadDataSubmission();
+	if (Submission.IsValid())
+		Submission->Wait();
+}
+
+bool FFurData::TickBuildFur(float DeltaTime)
+{
+	FScopeLock Lock(&BuildFurCS);
+
+	for (int32 Index = BuildFurQueue.Num() - 1; Index >= 0; Index--)
+	{
+		FFurData* Data = BuildFurQueue[Index];
+		// released data is left alone until it's either reused or destroyed, data still being built is combed afterwards
+		if (Data->RefCount == 0 || !Data->IsBuilt())
+			continue;
+
+		if (Data->CombBuildEvent.IsValid())
+		{
+			if (!Data->CombBuildEvent->IsComplete())
+				continue;
+			Data->CombBuildEvent = nullptr;
+			Data->CombedVertices = FCombedVertices();
+			Data->SubmitVertexBuffer();
+		}
+
+		if (Data->PendingCombedVertices.Num() == 0)
+		{
+			BuildFurQueue.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// the vertex buffer is written again once the render thread copied the previous rebuild
+		FGraphEventArray Prerequisites;
+		FGraphEventRef Submission = Data->GetRenderThreadDataSubmission();
+		if (Submission.IsValid() && !Submission->IsComplete())
+			Prerequisites.Add(Submission);
+
+		Data->GatherCombedVertices();
+		Data->CombBuildEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Data]()
+		{
+			SCOPE_CYCLE_COUNTER(STAT_FurCombRebuild);
+			Data->BuildFur(Data->CombedVertices);
+		}, TStatId(), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+	}
+
+	if (BuildFurQueue.Num() == 0)
+	{
+		BuildFurTickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+float FFurData::CalcSplineFurLength(const FVector* InControlPoints) const
+{
+	float Length = 0.0f;
+	FVector Prev = InControlPoints[0];
+	for (int32 ControlPointIndex = 1; ControlPointIndex < FurSplinesUsed->ControlPointCount; ControlPointIndex++)
+	{
+		FVector Point = InControlPoints[ControlPointIndex];
+		Length += FVector::Dist(Point, Prev);
+		Prev = Point;
+	}
+	return FMath::Max(Length * FurLength, MinFurLength);
+}
+
+void FFurData::GenerateFurLengths(TArray<float>& FurLengths)
+{
+	if (FurSplinesUsed)
+	{
+		FurLengths.AddUninitialized(FurSplinesUsed->SplineCount());
+		for (int32 SplineIndex = 0, SplineCount = FurSplinesUsed->SplineCount(); SplineIndex < SplineCount; SplineIndex++)
+			FurLengths[SplineIndex] = CalcSplineFurLength(GetSplineControlPoints(SplineIndex));
 	}
 }
 
@@ -387,19 +677,19 @@ void FFurData::GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVe
 	OutUv3.X = Lod;
 }
 
-void FFurData::GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVector2f& OutUv2, FVector2f& OutUv3, const FVector3f& InTangentZ, float InFurLength, const FFurGenLayerData& InGenLayerData, int32 InSplineIndex)
+void FFurData::GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVector2f& OutUv2, FVector2f& OutUv3, const FVector3f& InTangentZ, float InFurLength, const FFurGenLayerData& InGenLayerData, const FVector* InControlPoints)
 {
-	if (InSplineIndex >= 0)
+	if (InControlPoints)
 	{
 		int32 Count = FurSplinesUsed->ControlPointCount;
-		int32 Beginning = InSplineIndex * Count;
+		const FVector* Beginning = InControlPoints;
 
 		float Bias = InGenLayerData.NonLinearFactor * (Count - 1);
 		int Bottom = (int)Bias;
 		int Top = (int)ceilf(Bias);
 		float Height = Bias - Bottom;
 
-		FVector Spline = FurSplinesUsed->Vertices[Beginning + Count - 1] - FurSplinesUsed->Vertices[Beginning];
+		FVector Spline = Beginning[Count - 1] - Beginning[0];
 		float SplineLength = Spline.Size() * FurLength;
 		if (FVector::DotProduct(FVector(InTangentZ), Spline) <= 0.0f)
 		{
@@ -410,8 +700,8 @@ void FFurData::GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVe
 			if (SplineLength >= 0.0001f)
 			{
 				float k = MinFurLength / SplineLength;
-				FVector p = FurSplinesUsed->Vertices[Beginning + Bottom] * (1.0f - Height) + FurSplinesUsed->Vertices[Beginning + Top] * Height;
-				OutFurOffset = FVector3f((p - FurSplinesUsed->Vertices[Beginning]) * FurLength * k);
+				FVector p = Beginning[Bottom] * (1.0f - Height) + Beginning[Top] * Height;
+				OutFurOffset = FVector3f((p - Beginning[0]) * FurLength * k);
 			}
 			else
 			{
@@ -421,8 +711,8 @@ void FFurData::GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVe
 		}
 		else
 		{
-			OutFurOffset = FVector3f(FurSplinesUsed->Vertices[Beginning + Bottom] * (1.0f - Height) + FurSplinesUsed->Vertices[Beginning + Top] * Height);
-			OutFurOffset = FVector3f((FVector(OutFurOffset) - FurSplinesUsed->Vertices[Beginning]) * FurLength);
+			OutFurOffset = FVector3f(Beginning[Bottom] * (1.0f - Height) + Beginning[Top] * Height);
+			OutFurOffset = FVector3f((FVector(OutFurOffset) - Beginning[0]) * FurLength);
 		}
 		if (InGenLayerData.LayerNoiseStrength != 0)
 		{
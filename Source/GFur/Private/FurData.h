@@ -13,6 +13,8 @@
 #include "BoneIndices.h"
 
 #include "Async/AsyncWork.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
 
 #include "FurSplines.h"
 
@@ -106,9 +108,8 @@ public:
 	{
 	}
 
-	virtual void UpdateSkeletonShaderData(float InFurOffsetPower, float InMaxPhysicsOffsetLength, const TArray<FMatrix>& InReferenceToLocal, const TArray<FVector>& InLinearOffsets,
-		const TArray<FVector>& InAngularOffsets, const TArray<FMatrix>& InTransformations, const TArray<FBoneIndexType>& InBoneMap, bool InDiscontinuous,
-		ERHIFeatureLevel::Type InFeatureLevel) {}
+	virtual void UpdateSkeletonShaderData(float InFurOffsetPower, float InMaxPhysicsOffsetLength) {}
+	virtual class FFurSkinBoneData* GetSkinBoneData() const { return nullptr; }
 	virtual void UpdateStaticShaderData(float InFurOffsetPower, const FVector& InLinearOffset, const FVector& InAngularOffset,
 		const FVector& InPosition, bool InDiscontinuous, ERHIFeatureLevel::Type InFeatureLevel) {}
 };
@@ -139,6 +140,11 @@ public:
 	float GetCurrentMaxFurLength() const { return CurrentMaxFurLength; }
 	float GetMaxVertexBoneDistance() const { return MaxVertexBoneDistance; }
 	int32 GetFurLayerCount() const { return FurLayerCount; }
+	/** False while the full build of fur data created for edited parameters runs in a task. */
+	bool IsBuilt() const { return !FullBuildEvent.IsValid() || FullBuildEvent->IsComplete(); }
+
+	/** Whether combed vertices and fur data of edited parameters are built in tasks, see gFur.AsyncCombRebuild. */
+	static bool IsAsyncBuildEnabled();
 
 	const TArray<int32>& GetSplineMap() const { return SplineMap; }
 	const TArray<FVector>& GetVertexNormals() const { return Normals; }
@@ -164,6 +170,17 @@ protected:
 		float LayerNoiseStrength;
 	};
 
+	/** Combed vertices with copies of their splines, fur of the vertices is rebuilt from it without touching the splines. */
+	struct FCombedVertices
+	{
+		TArray<uint32> Vertices;
+		/** Spline of every vertex indexing Lengths, -1 for vertices without a spline. */
+		TArray<int32> VertexSplines;
+		/** ControlPointCount control points of every spline. */
+		TArray<FVector> ControlPoints;
+		TArray<float> Lengths;
+	};
+
 	int32 RefCount;
 
 	// set
@@ -200,7 +217,21 @@ protected:
 	int32 OldFurLayerCount = 0;
 	bool OldRemoveFacesWithoutSplines = false;
 
-	volatile bool RenderThreadDataSubmissionPending = false;
+	/** Completed by the render thread once it took over the data of the last build, the buffers are written again after it. */
+	FGraphEventRef RenderThreadDataSubmission;
+	FCriticalSection RenderThreadDataSubmissionCS;
+
+	/** Combed vertices waiting for a rebuild, merged until the running rebuild is done. */
+	TSet<uint32> PendingCombedVertices;
+	/** Vertices rebuilt by the running rebuild. */
+	FCombedVertices CombedVertices;
+	FGraphEventRef CombBuildEvent;
+	/** Full build of fur data created by CreateFurDataAsync, the data is used only once it is done. */
+	FGraphEventRef FullBuildEvent;
+
+	static FCriticalSection BuildFurCS;
+	static TArray<FFurData*> BuildFurQueue;
+	static FTSTicker::FDelegateHandle BuildFurTickerHandle;
 
 	FFurData();
 	virtual ~FFurData();
@@ -213,11 +244,34 @@ protected:
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
 	void UnpackNormals(const FStaticMeshVertexBuffer& InVertices);
 	void GenerateSplineMap(const FPositionVertexBuffer& InPositions);
+	/** Updates bindings of vertices to splines after splines were removed and appended, returns false if the whole fur has to be rebuilt, which includes changes of the fur length range. */
+	bool UpdateSplineMap(const FPositionVertexBuffer& InPositions, const TArray<int32>& InRemovedSplines, int32 InAddedSplineCount, TArray<uint32>& OutAffectedVertices);
+	uint32 UpdateFurLengthRange();
+	uint32 CalcFurLengthRange(float& OutMinFurLength, float& OutMaxFurLength) const;
+
+	/** Queues a rebuild of fur of combed vertices on a worker thread, the result is submitted on the game thread when done. */
+	void ScheduleBuildFur(const TArray<uint32>& InVertexSet);
+	/** Waits for the running rebuild of combed vertices, discarded rebuilds are not submitted. */
+	void WaitForBuildFur(bool InDiscard);
+	/** Waits for the full build of data created by CreateFurDataAsync, never called from the build itself. */
+	void WaitForFullBuild() const;
+	void GatherCombedVertices();
+	void SubmitVertexBuffer();
+	/** Enqueues the render command taking over the data of a build. */
+	void SubmitRenderThreadData();
+	FGraphEventRef GetRenderThreadDataSubmission();
+	/** Waits until the render thread took over the data of the last build, must not be called with BuildFurCS held. */
+	void WaitForRenderThreadDataSubmission();
+	virtual void BuildFur(const FCombedVertices& InCombed) = 0;
+	static bool TickBuildFur(float DeltaTime);
+
+	const FVector* GetSplineControlPoints(int32 SplineIndex) const { return SplineIndex >= 0 ? &FurSplinesUsed->Vertices[SplineIndex * FurSplinesUsed->ControlPointCount] : nullptr; }
 
 	FFurGenLayerData CalcFurGenLayerData(int32 Layer);
+	float CalcSplineFurLength(const FVector* InControlPoints) const;
 	void GenerateFurLengths(TArray<float>& FurLengths);
 	void GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVector2f& OutUv2, FVector2f& OutUv3, const FVector3f& InTangentZ, float FurLength, const FFurGenLayerData& InGenLayerData);
-	void GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVector2f& OutUv2, FVector2f& OutUv3, const FVector3f& InTangentZ, float FurLength, const FFurGenLayerData& InGenLayerData, int32 InSplineIndex);
+	void GenerateFurVertex(FVector3f& OutFurOffset, FVector2f& OutUv1, FVector2f& OutUv2, FVector2f& OutUv3, const FVector3f& InTangentZ, float FurLength, const FFurGenLayerData& InGenLayerData, const FVector* InControlPoints);
 
 	template<typename VertexTypeT, typename VertexBlitterT>
 	uint32 GenerateFurVertices(uint32 SrcVertexIndexBegin, uint32 SrcVertexIndexEnd, VertexTypeT* Vertices, const VertexBlitterT& VertexBlitter);
@@ -272,7 +326,7 @@ inline uint32 FFurData::GenerateFurVertices(uint32 SrcVertexIndexBegin, uint32 S
 				auto& Vertex = Vertices[DstVertexIndex];
 				VertexBlitter.Blit(Vertex, SrcVertexIndex);
 				float Length = SplineIndex >= 0 ? FurLengths[SplineIndex] : FurLength;
-				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, SplineIndex);
+				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, GetSplineControlPoints(SplineIndex));
 			}
 			else
 			{
@@ -303,7 +357,7 @@ inline uint32 FFurData::GenerateFurVertices(uint32 SrcVertexIndexBegin, uint32 S
 				auto& Vertex = Vertices[DstVertexIndex];
 				VertexBlitter.Blit(Vertex, SrcVertexIndex);
 				float Length = SplineIndex >= 0 ? FurLengths[SplineIndex] : FurLength;
-				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, SplineIndex);
+				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, GetSplineControlPoints(SplineIndex));
 			}
 			else
 			{
@@ -7,6 +7,10 @@
 #include "Runtime/Engine/Classes/Components/SkinnedMeshComponent.h"
 #include "Runtime/Engine/Classes/Animation/MorphTarget.h"
 #include "ShaderParameterUtils.h"
+#include "GFur.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
 
 void FFurMorphVertexBuffer::InitRHI(FRHICommandListBase& RHICmdList)
 {
@@ -34,6 +38,186 @@ void FFurMorphVertexBuffer::ReleaseRHI()
 	VertexBufferRHI.SafeRelease();
 }
 
+/** Morph Accumulation */
+static TAutoConsoleVariable<int32> CVarFurParallelMorphAccumulation(
+	TEXT("gFur.ParallelMorphAccumulation"),
+	1,
+	TEXT("Accumulates fur morph target deltas on worker threads, every worker owns a range of vertices.\n")
+	TEXT(" 0: accumulate on the render thread only\n")
+	TEXT(" 1: accumulate in parallel when there are enough deltas (default)"),
+	ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<int32> CVarFurParallelMorphAccumulationMinDeltas(
+	TEXT("gFur.ParallelMorphAccumulation.MinDeltas"),
+	8192,
+	TEXT("Minimal number of active morph target deltas needed to accumulate them in parallel."),
+	ECVF_RenderThreadSafe);
+
+DECLARE_CYCLE_STAT(TEXT("Morph Target Accumulation"), STAT_FurMorphAccumulation, STATGROUP_GFur);
+
+static const int32 MinVerticesPerMorphRange = 1024;
+
+typedef FFurMorphObject::FActiveMorph FActiveMorph;
+typedef FFurMorphObject::FMorphRangeDelta FMorphRangeDelta;
+
+static void NormalizeMorphTangents(FMorphGPUSkinVertex* Buffer, const float* AccumulatedWeights, int32 VertexBegin, int32 VertexEnd)
+{
+	for (int32 iVertex = VertexBegin; iVertex < VertexEnd; ++iVertex)
+	{
+		FMorphGPUSkinVertex& DestVertex = Buffer[iVertex];
+		float AccumulatedWeight = AccumulatedWeights[iVertex];
+
+		// if accumulated weight is >1.f
+		// previous code was applying the weight again in GPU if less than 1, but it doesn't make sense to do so
+		// so instead, we just divide by AccumulatedWeight if it's more than 1.
+		// now DeltaTangentZ isn't FPackedNormal, so you can apply any value to it. 
+		if (AccumulatedWeight > 1.f)
+		{
+			DestVertex.DeltaTangentZ /= AccumulatedWeight;
+		}
+	}
+}
+
+static int32 GetNumMorphAccumulationRanges(int32 NumVertices, int32 NumActiveDeltas)
+{
+	if (CVarFurParallelMorphAccumulation.GetValueOnRenderThread() == 0 || !FApp::ShouldUseThreadingForPerformance())
+		return 1;
+	if (NumActiveDeltas < CVarFurParallelMorphAccumulationMinDeltas.GetValueOnRenderThread())
+		return 1;
+	int32 MaxRanges = FMath::Max(NumVertices / MinVerticesPerMorphRange, 1);
+	return FMath::Min(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, MaxRanges);
+}
+
+/** Accumulates deltas of all active morph targets into vertices [VertexBegin, VertexEnd), serially in the order of ActiveMorphs. */
+static void AccumulateMorphDeltas(TArrayView<const FActiveMorph> ActiveMorphs, const TArray<int32>& MorphRemapTable, FMorphGPUSkinVertex* Buffer, float* AccumulatedWeights, int32 VertexBegin, int32 VertexEnd)
+{
+	// iterate over all active morph targets and accumulate their vertex deltas
+	for (const FActiveMorph& ActiveMorph : ActiveMorphs)
+	{
+		// iterate over the vertices that this lod model has changed
+		for (int32 MorphVertIdx = 0; MorphVertIdx < ActiveMorph.NumDeltas; MorphVertIdx++)
+		{
+			const FMorphTargetDelta& MorphVertex = ActiveMorph.Deltas[MorphVertIdx];
+
+			// @TODO FIXMELH : temp hack until we fix importing issue
+			if (MorphVertex.SourceIdx < (uint32)MorphRemapTable.Num())
+			{
+				int RemappedIndex = MorphRemapTable[MorphVertex.SourceIdx];
+				if (RemappedIndex == -1)
+					continue;
+				FMorphGPUSkinVertex& DestVertex = Buffer[RemappedIndex];
+
+				DestVertex.DeltaPosition += MorphVertex.PositionDelta * ActiveMorph.Weight;
+				DestVertex.DeltaTangentZ += MorphVertex.TangentZDelta * ActiveMorph.Weight;
+				// accumulate the weight so we can normalized it later
+				AccumulatedWeights[RemappedIndex] += ActiveMorph.AbsWeight;
+			}
+		} // for all vertices
+	} // for all morph targets
+
+	NormalizeMorphTangents(Buffer, AccumulatedWeights, VertexBegin, VertexEnd);
+}
+
+/**
+ * Same result as AccumulateMorphDeltas, bit for bit. Deltas are first bucketed by the vertex range they land in, then every range
+ * is accumulated by one worker, walking morph targets and their deltas in the serial order, so no atomics are needed.
+ */
+static void AccumulateMorphDeltasParallel(TArrayView<const FActiveMorph> ActiveMorphs, const TArray<int32>& MorphRemapTable, FMorphGPUSkinVertex* Buffer, float* AccumulatedWeights, int32 NumVertices, int32 NumRanges,
+	TArray<int32>& BucketCounts, TArray<int32>& BucketOffsets, TArray<FMorphRangeDelta>& RangeDeltas)
+{
+	const int32 NumMorphs = ActiveMorphs.Num();
+	const int32 RangeSize = FMath::DivideAndRoundUp(NumVertices, NumRanges);
+
+	// count deltas of every morph target per range
+	BucketCounts.SetNumUninitialized(NumMorphs * NumRanges, EAllowShrinking::No);
+	FMemory::Memzero(BucketCounts.GetData(), sizeof(int32) * BucketCounts.Num());
+	ParallelFor(NumMorphs, [&](int32 MorphIndex)
+	{
+		const FActiveMorph& ActiveMorph = ActiveMorphs[MorphIndex];
+		int32* Counts = BucketCounts.GetData() + MorphIndex * NumRanges;
+		for (int32 MorphVertIdx = 0; MorphVertIdx < ActiveMorph.NumDeltas; MorphVertIdx++)
+		{
+			uint32 SourceIdx = ActiveMorph.Deltas[MorphVertIdx].SourceIdx;
+			if (SourceIdx < (uint32)MorphRemapTable.Num() && MorphRemapTable[SourceIdx] != -1)
+				Counts[MorphRemapTable[SourceIdx] / RangeSize]++;
+		}
+	});
+
+	// buckets are laid out range by range, morph targets keep their order inside of a range
+	BucketOffsets.SetNumUninitialized(NumMorphs * NumRanges, EAllowShrinking::No);
+	int32 NumBucketedDeltas = 0;
+	for (int32 RangeIndex = 0; RangeIndex < NumRanges; RangeIndex++)
+	{
+		for (int32 MorphIndex = 0; MorphIndex < NumMorphs; MorphIndex++)
+		{
+			BucketOffsets[MorphIndex * NumRanges + RangeIndex] = NumBucketedDeltas;
+			NumBucketedDeltas += BucketCounts[MorphIndex * NumRanges + RangeIndex];
+		}
+	}
+
+	RangeDeltas.SetNumUninitialized(NumBucketedDeltas, EAllowShrinking::No);
+	ParallelFor(NumMorphs, [&](int32 MorphIndex)
+	{
+		const FActiveMorph& ActiveMorph = ActiveMorphs[MorphIndex];
+		TArray<int32, TInlineAllocator<32>> WriteOffsets(BucketOffsets.GetData() + MorphIndex * NumRanges, NumRanges);
+		for (int32 MorphVertIdx = 0; MorphVertIdx < ActiveMorph.NumDeltas; MorphVertIdx++)
+		{
+			uint32 SourceIdx = ActiveMorph.Deltas[MorphVertIdx].SourceIdx;
+			if (SourceIdx < (uint32)MorphRemapTable.Num() && MorphRemapTable[SourceIdx] != -1)
+			{
+				int32 RemappedIndex = MorphRemapTable[SourceIdx];
+				FMorphRangeDelta& RangeDelta = RangeDeltas[WriteOffsets[RemappedIndex / RangeSize]++];
+				RangeDelta.VertexIndex = RemappedIndex;
+				RangeDelta.DeltaIndex = MorphVertIdx;
+			}
+		}
+	});
+
+	ParallelFor(NumRanges, [&](int32 RangeIndex)
+	{
+		for (int32 MorphIndex = 0; MorphIndex < NumMorphs; MorphIndex++)
+		{
+			const FActiveMorph& ActiveMorph = ActiveMorphs[MorphIndex];
+			const int32 BucketIndex = MorphIndex * NumRanges + RangeIndex;
+			const FMorphRangeDelta* RangeDelta = RangeDeltas.GetData() + BucketOffsets[BucketIndex];
+			const FMorphRangeDelta* RangeDeltaEnd = RangeDelta + BucketCounts[BucketIndex];
+			for (; RangeDelta < RangeDeltaEnd; RangeDelta++)
+			{
+				const FMorphTargetDelta& MorphVertex = ActiveMorph.Deltas[RangeDelta->DeltaIndex];
+				FMorphGPUSkinVertex& DestVertex = Buffer[RangeDelta->VertexIndex];
+
+				DestVertex.DeltaPosition += MorphVertex.PositionDelta * ActiveMorph.Weight;
+				DestVertex.DeltaTangentZ += MorphVertex.TangentZDelta * ActiveMorph.Weight;
+				AccumulatedWeights[RangeDelta->VertexIndex] += ActiveMorph.AbsWeight;
+			}
+		}
+
+		int32 VertexBegin = RangeIndex * RangeSize;
+		NormalizeMorphTangents(Buffer, AccumulatedWeights, VertexBegin, FMath::Min(VertexBegin + RangeSize, NumVertices));
+	});
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+void FFurMorphObject::AccumulateForTest(TArrayView<const FActiveMorph> InActiveMorphs, const TArray<int32>& InMorphRemapTable, int32 NumVertices, int32 NumRanges, TArray<FMorphGPUSkinVertex>& OutDeltas)
+{
+	TArray<float> Weights;
+	Weights.SetNumZeroed(NumVertices);
+	OutDeltas.SetNumUninitialized(NumVertices);
+	FMemory::Memzero(OutDeltas.GetData(), sizeof(FMorphGPUSkinVertex) * NumVertices);
+	if (NumRanges > 1)
+	{
+		TArray<int32> Counts;
+		TArray<int32> Offsets;
+		TArray<FMorphRangeDelta> Deltas;
+		AccumulateMorphDeltasParallel(InActiveMorphs, InMorphRemapTable, OutDeltas.GetData(), Weights.GetData(), NumVertices, NumRanges, Counts, Offsets, Deltas);
+	}
+	else
+	{
+		AccumulateMorphDeltas(InActiveMorphs, InMorphRemapTable, OutDeltas.GetData(), Weights.GetData(), 0, NumVertices);
+	}
+}
+#endif // WITH_DEV_AUTOMATION_TESTS
+
 /** Fur Morph Vertex Buffer */
 FFurMorphObject::FFurMorphObject(FFurSkinData* InFurData)
 {
@@ -48,7 +232,7 @@ FFurMorphObject::~FFurMorphObject()
 		VertexBuffer.ReleaseResource();
 }
 
-void FFurMorphObject::Update_RenderThread(FRHICommandListImmediate& RHICmdList, const FMorphTargetWeightMap& ActiveMorphTargets, const TArray<float>& MorphTargetWeights, const TArray<TArray<int32>>& InMorphRemapTables, int InMeshLod)
+void FFurMorphObject::Update_RenderThread(FRHICommandListImmediate& RHICmdList, TArrayView<const FFurActiveMorphTarget> ActiveMorphTargets, const TArray<int32>& InMorphRemapTable, int InMeshLod)
 {
 	int32 NumFurVertices = FurData->GetNumVertices_RenderThread();
 	int32 NumVertices = NumFurVertices / FurData->GetFurLayerCount();
@@ -58,78 +242,37 @@ void FFurMorphObject::Update_RenderThread(FRHICommandListImmediate& RHICmdList,
 
 		uint32 Size = NumVertices * sizeof(FMorphGPUSkinVertex);
 
-		TArray<float> MorphAccumulatedWeightArray;
-		FMorphGPUSkinVertex* Buffer = (FMorphGPUSkinVertex*)FMemory::Malloc(Size);
-
-		MorphAccumulatedWeightArray.AddUninitialized(NumVertices);
-		FMemory::Memzero(MorphAccumulatedWeightArray.GetData(), sizeof(float) * NumVertices);
+		// scratch arrays keep their allocations, they only grow with the vertex count, but are cleared every frame
+		AccumulatedWeights.SetNumUninitialized(NumVertices, EAllowShrinking::No);
+		AccumulatedDeltas.SetNumUninitialized(NumVertices, EAllowShrinking::No);
+		FMemory::Memzero(AccumulatedWeights.GetData(), sizeof(float) * NumVertices);
+		FMemory::Memzero(AccumulatedDeltas.GetData(), sizeof(FMorphGPUSkinVertex) * NumVertices);
+		FMorphGPUSkinVertex* Buffer = AccumulatedDeltas.GetData();
 
-		FMemory::Memzero(&Buffer[0], sizeof(FMorphGPUSkinVertex) * NumVertices);
+		const auto& MorphRemapTable = InMorphRemapTable;
 
-		const auto& MorphRemapTable = InMorphRemapTables[InMeshLod];
-		
-		
-		// iterate over all active morph targets and accumulate their vertex deltas
-		for (const auto& pair : ActiveMorphTargets)
+		// gather active morph targets in the order of the weight map, the accumulation order per vertex must not change
+		ActiveMorphs.Reset();
+		int32 NumActiveDeltas = 0;
+		for (const FFurActiveMorphTarget& ActiveMorphTarget : ActiveMorphTargets)
 		{
-			const UMorphTarget* ActiveMorphTarget = pair.Key;
-			const int32 WeightIndex = pair.Value;
-
-			checkSlow(ActiveMorphTarget != NULL);
-			//checkSlow(ActiveMorphTarget->HasDataForLOD(LODIndex));
-
-			const float MorphTargetWeight = MorphTargetWeights[WeightIndex];
-			const float MorphAbsWeight = FMath::Abs(MorphTargetWeight);
-
-			//checkSlow(MorphAbsWeight >= MinMorphTargetBlendWeight && MorphAbsWeight <= MaxMorphTargetBlendWeight);
-
-			// Get deltas
-			int32 NumDeltas;
-			const FMorphTargetDelta* Deltas = ActiveMorphTarget->GetMorphTargetDelta(InMeshLod, NumDeltas);
+			checkSlow(ActiveMorphTarget.MorphTarget != NULL);
 
-			// iterate over the vertices that this lod model has changed
-			for (int32 MorphVertIdx = 0; MorphVertIdx < NumDeltas; MorphVertIdx++)
-			{
-				const FMorphTargetDelta& MorphVertex = Deltas[MorphVertIdx];
-
-				// @TODO FIXMELH : temp hack until we fix importing issue
-				if (MorphVertex.SourceIdx < (uint32)MorphRemapTable.Num())
-				{
-					int RemappedIndex = MorphRemapTable[MorphVertex.SourceIdx];
-					if (RemappedIndex == -1)
-						continue;
-					FMorphGPUSkinVertex& DestVertex = Buffer[RemappedIndex];
-
-					DestVertex.DeltaPosition += MorphVertex.PositionDelta * MorphTargetWeight;
-
-					// todo: could be moved out of the inner loop to be more efficient
-//						if (bBlendTangentsOnCPU)
-					{
-						DestVertex.DeltaTangentZ += MorphVertex.TangentZDelta * MorphTargetWeight;
-						// accumulate the weight so we can normalized it later
-						MorphAccumulatedWeightArray[RemappedIndex] += MorphAbsWeight;
-					}
-				}
-			} // for all vertices
-		} // for all morph targets
+			FActiveMorph& ActiveMorph = ActiveMorphs.AddDefaulted_GetRef();
+			ActiveMorph.Weight = ActiveMorphTarget.Weight;
+			ActiveMorph.AbsWeight = FMath::Abs(ActiveMorph.Weight);
+			ActiveMorph.Deltas = ActiveMorphTarget.MorphTarget->GetMorphTargetDelta(InMeshLod, ActiveMorph.NumDeltas);
+			NumActiveDeltas += ActiveMorph.NumDeltas;
+		}
 
-//		if (bBlendTangentsOnCPU)
 		{
-			// copy back all the tangent values (can't use Memcpy, since we have to pack the normals)
-			for (int32 iVertex = 0; iVertex < NumVertices; ++iVertex)
-			{
-				FMorphGPUSkinVertex& DestVertex = Buffer[iVertex];
-				float AccumulatedWeight = MorphAccumulatedWeightArray[iVertex];
+			SCOPE_CYCLE_COUNTER(STAT_FurMorphAccumulation);
 
-				// if accumulated weight is >1.f
-				// previous code was applying the weight again in GPU if less than 1, but it doesn't make sense to do so
-				// so instead, we just divide by AccumulatedWeight if it's more than 1.
-				// now DeltaTangentZ isn't FPackedNormal, so you can apply any value to it. 
-				if (AccumulatedWeight > 1.f)
-				{
-					DestVertex.DeltaTangentZ /= AccumulatedWeight;
-				}
-			}
+			const int32 NumRanges = GetNumMorphAccumulationRanges(NumVertices, NumActiveDeltas);
+			if (NumRanges > 1)
+				AccumulateMorphDeltasParallel(ActiveMorphs, MorphRemapTable, Buffer, AccumulatedWeights.GetData(), NumVertices, NumRanges, BucketCounts, BucketOffsets, RangeDeltas);
+			else
+				AccumulateMorphDeltas(ActiveMorphs, MorphRemapTable, Buffer, AccumulatedWeights.GetData(), 0, NumVertices);
 		}
 
 		// Lock the real buffer.
@@ -162,7 +305,6 @@ void FFurMorphObject::Update_RenderThread(FRHICommandListImmediate& RHICmdList,
 				for (int i = 0; i < NumLayers; i++)
 					FMemory::Memcpy(SectionBuffer + NumLayerVertices * i, SourceBuffer, LayerSize);
 			}
-			FMemory::Free(Buffer);
 		}
 
 		{
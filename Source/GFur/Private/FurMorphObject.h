@@ -3,8 +3,10 @@
 #pragma once
 
 #include "Runtime/Engine/Classes/Components/SkinnedMeshComponent.h"
+#include "FurComponent.h"
 
 class FFurSkinData;
+struct FMorphGPUSkinVertex;
 
 /** Fur Morph Vertex Buffer */
 class FFurMorphVertexBuffer : public FVertexBuffer
@@ -38,11 +40,39 @@ public:
 	FFurMorphObject(FFurSkinData* InFurData);
 	~FFurMorphObject();
 
-	void Update_RenderThread(FRHICommandListImmediate& RHICmdList, const FMorphTargetWeightMap& ActiveMorphTargets, const TArray<float>& MorphTargetWeights, const TArray<TArray<int32>>& InMorphRemapTable, int InMeshLod);
+	void Update_RenderThread(FRHICommandListImmediate& RHICmdList, TArrayView<const FFurActiveMorphTarget> ActiveMorphTargets, const TArray<int32>& InMorphRemapTable, int InMeshLod);
 
 	FVertexBuffer* GetVertexBuffer() { return &VertexBuffer; }
 
+	struct FActiveMorph
+	{
+		const FMorphTargetDelta* Deltas;
+		int32 NumDeltas;
+		float Weight;
+		float AbsWeight;
+	};
+
+	/** Delta of one morph target which lands in a particular vertex range. */
+	struct FMorphRangeDelta
+	{
+		int32 VertexIndex;
+		int32 DeltaIndex;
+	};
+
+#if WITH_DEV_AUTOMATION_TESTS
+	/** Accumulates deltas like Update_RenderThread, split into NumRanges vertex ranges accumulated in parallel when more than one. */
+	static void AccumulateForTest(TArrayView<const FActiveMorph> InActiveMorphs, const TArray<int32>& InMorphRemapTable, int32 NumVertices, int32 NumRanges, TArray<FMorphGPUSkinVertex>& OutDeltas);
+#endif // WITH_DEV_AUTOMATION_TESTS
+
 private:
 	FFurSkinData* FurData;
 	FFurMorphVertexBuffer VertexBuffer;
+
+	/** Render thread scratch kept between frames, so that accumulation doesn't allocate in steady state. */
+	TArray<FMorphGPUSkinVertex> AccumulatedDeltas;
+	TArray<float> AccumulatedWeights;
+	TArray<FActiveMorph> ActiveMorphs;
+	TArray<int32> BucketCounts;
+	TArray<int32> BucketOffsets;
+	TArray<FMorphRangeDelta> RangeDeltas;
 };
@@ -0,0 +1,224 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurMorphRemap.h"
+#include "Runtime/Engine/Classes/Engine/SkeletalMesh.h"
+#include "Runtime/Engine/Classes/Engine/SkinnedAsset.h"
+#include "Runtime/Engine/Public/Rendering/SkeletalMeshRenderData.h"
+#include "Containers/HashTable.h"
+#include "UObject/ObjectKey.h"
+
+/** Morph Remap Cache */
+struct FFurMorphRemapKey
+{
+	TObjectKey<USkinnedAsset> MasterMesh;
+	TObjectKey<USkeletalMesh> GrowMesh;
+	int32 Lod;
+
+	bool operator==(const FFurMorphRemapKey& Other) const
+	{
+		return MasterMesh == Other.MasterMesh && GrowMesh == Other.GrowMesh && Lod == Other.Lod;
+	}
+
+	friend uint32 GetTypeHash(const FFurMorphRemapKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.MasterMesh), GetTypeHash(Key.GrowMesh)), GetTypeHash(Key.Lod));
+	}
+};
+
+struct FFurMorphRemapEntry
+{
+	/** Render data the table was built from, meshes rebuilt in the editor get new render data. */
+	const FSkeletalMeshRenderData* MasterRenderData;
+	const FSkeletalMeshRenderData* GrowRenderData;
+	FFurMorphRemapTablePtr RemapTable;
+};
+
+static TMap<FFurMorphRemapKey, FFurMorphRemapEntry> MorphRemapCache;
+static FCriticalSection MorphRemapCacheCS;
+
+static FFurMorphRemapTablePtr AddToCache(const FFurMorphRemapKey& Key, const FSkeletalMeshRenderData* MasterRenderData, const FSkeletalMeshRenderData* GrowRenderData, TArray<int32>&& RemapTable)
+{
+	FScopeLock lock(&MorphRemapCacheCS);
+
+	for (auto It = MorphRemapCache.CreateIterator(); It; ++It)
+	{
+		if (It.Key().MasterMesh.ResolveObjectPtr() == nullptr || It.Key().GrowMesh.ResolveObjectPtr() == nullptr)
+			It.RemoveCurrent();
+	}
+
+	FFurMorphRemapEntry& Entry = MorphRemapCache.FindOrAdd(Key);
+	Entry.MasterRenderData = MasterRenderData;
+	Entry.GrowRenderData = GrowRenderData;
+	Entry.RemapTable = MakeShared<const TArray<int32>, ESPMode::ThreadSafe>(MoveTemp(RemapTable));
+	return Entry.RemapTable;
+}
+
+const FSkeletalMeshLODRenderData* FFurMorphRemapCache::GetMasterLodModel(const USkinnedAsset* InMasterMesh, int32 InLod)
+{
+	const FSkeletalMeshRenderData* MasterRenderData = InMasterMesh ? const_cast<USkinnedAsset*>(InMasterMesh)->GetResourceForRendering() : nullptr;
+	if (!MasterRenderData || MasterRenderData->LODRenderData.Num() == 0)
+		return nullptr;
+	return &MasterRenderData->LODRenderData[FMath::Min(InLod, MasterRenderData->LODRenderData.Num() - 1)];
+}
+
+const FSkeletalMeshLODRenderData* FFurMorphRemapCache::GetLodModel(const USkeletalMesh* InGrowMesh, int32 InLod)
+{
+	const FSkeletalMeshRenderData* RenderData = InGrowMesh ? InGrowMesh->GetResourceForRendering() : nullptr;
+	if (!RenderData || !RenderData->LODRenderData.IsValidIndex(InLod))
+		return nullptr;
+	return &RenderData->LODRenderData[InLod];
+}
+
+static bool IsRemapTableValid(const TArray<int32>& InRemapTable, const FSkeletalMeshLODRenderData& InMasterLodModel, const FSkeletalMeshLODRenderData& InLodModel)
+{
+	if ((uint32)InRemapTable.Num() != InMasterLodModel.StaticVertexBuffers.PositionVertexBuffer.GetNumVertices())
+		return false;
+
+	const int32 NumVertices = InLodModel.StaticVertexBuffers.PositionVertexBuffer.GetNumVertices();
+	for (int32 Index : InRemapTable)
+	{
+		if (Index >= NumVertices)
+			return false;
+	}
+	return true;
+}
+
+FFurMorphRemapTablePtr FFurMorphRemapCache::FindOrBuild(const USkinnedAsset* InMasterMesh, const USkeletalMesh* InGrowMesh, int32 InLod, const TArray<int32>* InPrecomputedTable)
+{
+	const FSkeletalMeshLODRenderData* MasterLodModel = GetMasterLodModel(InMasterMesh, InLod);
+	const FSkeletalMeshLODRenderData* LodModel = GetLodModel(InGrowMesh, InLod);
+	if (!MasterLodModel || !LodModel)
+		return nullptr;
+
+	const FSkeletalMeshRenderData* MasterRenderData = const_cast<USkinnedAsset*>(InMasterMesh)->GetResourceForRendering();
+	const FSkeletalMeshRenderData* GrowRenderData = InGrowMesh->GetResourceForRendering();
+
+	FFurMorphRemapKey Key{ InMasterMesh, InGrowMesh, InLod };
+	{
+		FScopeLock lock(&MorphRemapCacheCS);
+		const FFurMorphRemapEntry* Entry = MorphRemapCache.Find(Key);
+		if (Entry && Entry->MasterRenderData == MasterRenderData && Entry->GrowRenderData == GrowRenderData)
+			return Entry->RemapTable;
+	}
+
+	if (InPrecomputedTable && IsRemapTableValid(*InPrecomputedTable, *MasterLodModel, *LodModel))
+	{
+		TArray<int32> RemapTable = *InPrecomputedTable;
+		return AddToCache(Key, MasterRenderData, GrowRenderData, MoveTemp(RemapTable));
+	}
+
+	return AddToCache(Key, MasterRenderData, GrowRenderData, Build(FFurMorphRemapMesh(*MasterLodModel), FFurMorphRemapMesh(*LodModel)));
+}
+
+FFurMorphRemapMesh::FFurMorphRemapMesh(const FSkeletalMeshLODRenderData& InLodModel)
+{
+	const auto& PositionBuffer = InLodModel.StaticVertexBuffers.PositionVertexBuffer;
+	const auto& VertexBuffer = InLodModel.StaticVertexBuffers.StaticMeshVertexBuffer;
+	const uint32 NumVertices = PositionBuffer.GetNumVertices();
+	NumTexCoords = VertexBuffer.GetNumTexCoords();
+
+	Positions.SetNumUninitialized(NumVertices);
+	TangentsX.SetNumUninitialized(NumVertices);
+	TangentsY.SetNumUninitialized(NumVertices);
+	TangentsZ.SetNumUninitialized(NumVertices);
+	UVs.SetNumUninitialized(NumVertices * NumTexCoords);
+	for (uint32 i = 0; i < NumVertices; i++)
+	{
+		Positions[i] = PositionBuffer.VertexPosition(i);
+		TangentsX[i] = VertexBuffer.VertexTangentX(i);
+		TangentsY[i] = VertexBuffer.VertexTangentY(i);
+		TangentsZ[i] = VertexBuffer.VertexTangentZ(i);
+		for (uint32 k = 0; k < NumTexCoords; k++)
+			UVs[i * NumTexCoords + k] = VertexBuffer.GetVertexUV(i, k);
+	}
+
+	for (const auto& Section : InLodModel.RenderSections)
+		Sections.Add({ Section.BaseVertexIndex, Section.NumVertices, Section.MaterialIndex });
+}
+
+TArray<int32> FFurMorphRemapCache::Build(const FFurMorphRemapMesh& InMaster, const FFurMorphRemapMesh& InGrow)
+{
+	TArray<int32> MorphRemapTable;
+	MorphRemapTable.Init(-1, InMaster.Positions.Num());
+
+	uint32 UVCount = FMath::Min(InMaster.NumTexCoords, InGrow.NumTexCoords);
+
+	// cells are twice the tolerance, so a position and its tolerance neighbourhood touch at most 2 cells per axis
+	const float CellSize = PositionTolerance * 2.0f;
+	auto Cell = [CellSize](float Coordinate) {
+		return FMath::FloorToInt32(Coordinate / CellSize);
+	};
+	auto CellHash = [](int32 X, int32 Y, int32 Z) {
+		return Murmur32({ (uint32)X, (uint32)Y, (uint32)Z });
+	};
+
+	TArray<FHashTable> HashTables;
+	for (const auto& Section : InGrow.Sections)
+	{
+		uint32 HashSize = FMath::RoundUpToPowerOfTwo(FMath::Clamp<uint32>(Section.NumVertices, 16, 64 * 1024));
+		FHashTable& HashTable = HashTables.Emplace_GetRef(HashSize, Section.BaseVertexIndex + Section.NumVertices);
+		for (uint32 i = Section.BaseVertexIndex; i < Section.BaseVertexIndex + Section.NumVertices; i++)
+		{
+			const FVector3f& Position = InGrow.Positions[i];
+			HashTable.Add(CellHash(Cell(Position.X), Cell(Position.Y), Cell(Position.Z)), i);
+		}
+	}
+
+	const float MaxDistSquared = FMath::Square(PositionTolerance);
+	for (const auto& MasterSection : InMaster.Sections)
+	{
+		for (uint32 i = MasterSection.BaseVertexIndex; i < MasterSection.BaseVertexIndex + MasterSection.NumVertices; i++)
+		{
+			const FVector3f& MasterPosition = InMaster.Positions[i];
+			const FVector4f& MasterTangentX = InMaster.TangentsX[i];
+			const FVector3f& MasterTangentY = InMaster.TangentsY[i];
+			const FVector4f& MasterTangentZ = InMaster.TangentsZ[i];
+
+			int32 BestIndex = -1;
+			float BestDistSquared = MaxDistSquared;
+			auto Compare = [&](uint32 Index) {
+				float DistSquared = FVector3f::DistSquared(MasterPosition, InGrow.Positions[Index]);
+				if (DistSquared > BestDistSquared || (BestIndex != -1 && DistSquared >= BestDistSquared))
+					return;
+				if (!MasterTangentX.Equals(InGrow.TangentsX[Index], TangentTolerance)
+					|| !MasterTangentY.Equals(InGrow.TangentsY[Index], TangentTolerance)
+					|| !MasterTangentZ.Equals(InGrow.TangentsZ[Index], TangentTolerance))
+					return;
+				for (uint32 k = 0; k < UVCount; k++)
+				{
+					if (!InMaster.UVs[i * InMaster.NumTexCoords + k].Equals(InGrow.UVs[Index * InGrow.NumTexCoords + k], UVTolerance))
+						return;
+				}
+				BestIndex = Index;
+				BestDistSquared = DistSquared;
+			};
+
+			const int32 MinX = Cell(MasterPosition.X - PositionTolerance), MaxX = Cell(MasterPosition.X + PositionTolerance);
+			const int32 MinY = Cell(MasterPosition.Y - PositionTolerance), MaxY = Cell(MasterPosition.Y + PositionTolerance);
+			const int32 MinZ = Cell(MasterPosition.Z - PositionTolerance), MaxZ = Cell(MasterPosition.Z + PositionTolerance);
+
+			for (int32 SectionIndex = 0; SectionIndex < InGrow.Sections.Num(); SectionIndex++)
+			{
+				if (MasterSection.MaterialIndex != InGrow.Sections[SectionIndex].MaterialIndex)
+					continue;
+
+				const FHashTable& HashTable = HashTables[SectionIndex];
+				for (int32 Z = MinZ; Z <= MaxZ; Z++)
+				{
+					for (int32 Y = MinY; Y <= MaxY; Y++)
+					{
+						for (int32 X = MinX; X <= MaxX; X++)
+						{
+							for (uint32 Idx = HashTable.First(CellHash(X, Y, Z)); HashTable.IsValid(Idx); Idx = HashTable.Next(Idx))
+								Compare(Idx);
+						}
+					}
+				}
+			}
+
+			MorphRemapTable[i] = BestIndex;
+		}
+	}
+
+	return MorphRemapTable;
+}
\ No newline at end of file
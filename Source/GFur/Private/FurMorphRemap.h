@@ -0,0 +1,58 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USkinnedAsset;
+class USkeletalMesh;
+class FSkeletalMeshLODRenderData;
+
+/** Maps vertices of the master mesh to vertices of the grow mesh, -1 for vertices without a counterpart. */
+typedef TSharedPtr<const TArray<int32>, ESPMode::ThreadSafe> FFurMorphRemapTablePtr;
+
+/** Vertex attributes of one LOD compared when matching vertices, sections only match sections of the same material. */
+struct FFurMorphRemapMesh
+{
+	struct FSection
+	{
+		uint32 BaseVertexIndex;
+		uint32 NumVertices;
+		int32 MaterialIndex;
+	};
+
+	FFurMorphRemapMesh() = default;
+	explicit FFurMorphRemapMesh(const FSkeletalMeshLODRenderData& InLodModel);
+
+	TArray<FVector3f> Positions;
+	TArray<FVector4f> TangentsX;
+	TArray<FVector3f> TangentsY;
+	TArray<FVector4f> TangentsZ;
+	/** NumTexCoords UVs per vertex. */
+	TArray<FVector2f> UVs;
+	uint32 NumTexCoords = 0;
+	TArray<FSection> Sections;
+};
+
+/** Fur Morph Remap Cache */
+class FFurMorphRemapCache
+{
+public:
+	/**
+	 * Returns the remap table of the grow mesh LOD. It's built only if it isn't cached yet, unless a table computed earlier
+	 * (e.g. serialized at cook time) is passed and still fits the meshes.
+	 */
+	static FFurMorphRemapTablePtr FindOrBuild(const USkinnedAsset* InMasterMesh, const USkeletalMesh* InGrowMesh, int32 InLod, const TArray<int32>* InPrecomputedTable = nullptr);
+
+	/** Matches vertices by position, tangents and UVs within tolerance, using a 3D spatial hash of the grow mesh vertices. */
+	static TArray<int32> Build(const FFurMorphRemapMesh& InMaster, const FFurMorphRemapMesh& InGrow);
+
+	/** Tolerances of the matching, also used by the tests. */
+	static constexpr float PositionTolerance = 0.01f;
+	static constexpr float TangentTolerance = 0.01f;
+	static constexpr float UVTolerance = 0.0001f;
+
+private:
+	static const FSkeletalMeshLODRenderData* GetMasterLodModel(const USkinnedAsset* InMasterMesh, int32 InLod);
+	static const FSkeletalMeshLODRenderData* GetLodModel(const USkeletalMesh* InGrowMesh, int32 InLod);
+};
\ No newline at end of file
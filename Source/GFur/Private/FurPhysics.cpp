@@ -0,0 +1,379 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurPhysics.h"
+#include "Math/VectorRegister.h"
+
+void FFurPhysicsState::SetNum(int32 InNum)
+{
+	NumElements = InNum;
+	NumPadded = Align(InNum, (int32)BlockSize);
+	Data.SetNumUninitialized(NumPadded * NumStreams);
+	for (int32 i = 0; i < NumPadded; i++)
+		SetNewTransform(i, FVector3f::ZeroVector, FQuat4f::Identity);
+	Reset();
+}
+
+void FFurPhysicsState::SetNewTransform(int32 Index, const FVector3f& InPosition, const FQuat4f& InRotation)
+{
+	Stream(NewPositionX)[Index] = InPosition.X;
+	Stream(NewPositionY)[Index] = InPosition.Y;
+	Stream(NewPositionZ)[Index] = InPosition.Z;
+	Stream(NewRotationX)[Index] = InRotation.X;
+	Stream(NewRotationY)[Index] = InRotation.Y;
+	Stream(NewRotationZ)[Index] = InRotation.Z;
+	Stream(NewRotationW)[Index] = InRotation.W;
+}
+
+void FFurPhysicsState::Reset()
+{
+	FMemory::Memcpy(Stream(PositionX), Stream(NewPositionX), sizeof(float) * NumPadded * 3);
+	FMemory::Memcpy(Stream(RotationX), Stream(NewRotationX), sizeof(float) * NumPadded * 4);
+	FMemory::Memzero(Stream(LinearOffsetX), sizeof(float) * NumPadded * 12);
+}
+
+void FFurPhysicsState::Teleport()
+{
+	FMemory::Memcpy(Stream(PositionX), Stream(NewPositionX), sizeof(float) * NumPadded * 3);
+	FMemory::Memcpy(Stream(RotationX), Stream(NewRotationX), sizeof(float) * NumPadded * 4);
+}
+
+void FFurPhysicsState::Integrate(const FFurPhysicsParameters& Params, int32 BeginBlock, int32 EndBlock)
+{
+	const VectorRegister4Float ForceFactor = VectorSetFloat1(Params.ForceFactor);
+	const VectorRegister4Float SinX = VectorSetFloat1(Params.SinX);
+	const VectorRegister4Float CosX = VectorSetFloat1(Params.CosX);
+	const VectorRegister4Float DampingFactor = VectorSetFloat1(Params.DampingFactor);
+	const VectorRegister4Float MaxForce = VectorSetFloat1(Params.MaxForce);
+	const VectorRegister4Float MaxTorque = VectorSetFloat1(Params.MaxTorque);
+	const VectorRegister4Float ForceX = VectorSetFloat1(Params.ConstantForce.X);
+	const VectorRegister4Float ForceY = VectorSetFloat1(Params.ConstantForce.Y);
+	const VectorRegister4Float ForceZ = VectorSetFloat1(Params.ConstantForce.Z);
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float One = VectorOneFloat();
+	const VectorRegister4Float Two = VectorSetFloat1(2.0f);
+	const VectorRegister4Float Pi = VectorSetFloat1(PI);
+	const VectorRegister4Float TwoPi = VectorSetFloat1(2.0f * PI);
+	const VectorRegister4Float SmallNumber = VectorSetFloat1(UE_SMALL_NUMBER);
+
+	for (int32 Block = BeginBlock; Block < EndBlock; Block++)
+	{
+		const int32 i = Block * BlockSize;
+		auto Load = [this, i](EStream InStream) { return VectorLoadAligned(Stream(InStream) + i); };
+		auto Store = [this, i](EStream InStream, const VectorRegister4Float& Value) { VectorStoreAligned(Value, Stream(InStream) + i); };
+
+		/** Linear */
+		const VectorRegister4Float NewPositionXV = Load(NewPositionX);
+		const VectorRegister4Float NewPositionYV = Load(NewPositionY);
+		const VectorRegister4Float NewPositionZV = Load(NewPositionZ);
+
+		VectorRegister4Float OffsetX = VectorNegateMultiplyAdd(VectorSubtract(NewPositionXV, Load(PositionX)), ForceFactor, Load(LinearOffsetX));
+		VectorRegister4Float OffsetY = VectorNegateMultiplyAdd(VectorSubtract(NewPositionYV, Load(PositionY)), ForceFactor, Load(LinearOffsetY));
+		VectorRegister4Float OffsetZ = VectorNegateMultiplyAdd(VectorSubtract(NewPositionZV, Load(PositionZ)), ForceFactor, Load(LinearOffsetZ));
+		VectorRegister4Float VelocityX = Load(LinearVelocityX);
+		VectorRegister4Float VelocityY = Load(LinearVelocityY);
+		VectorRegister4Float VelocityZ = Load(LinearVelocityZ);
+
+		// offset relative to the rest position under the constant force
+		const VectorRegister4Float RestX = VectorSubtract(OffsetX, ForceX);
+		const VectorRegister4Float RestY = VectorSubtract(OffsetY, ForceY);
+		const VectorRegister4Float RestZ = VectorSubtract(OffsetZ, ForceZ);
+
+		OffsetX = VectorMultiplyAdd(VectorMultiplyAdd(VelocityX, SinX, VectorMultiply(RestX, CosX)), DampingFactor, ForceX);
+		OffsetY = VectorMultiplyAdd(VectorMultiplyAdd(VelocityY, SinX, VectorMultiply(RestY, CosX)), DampingFactor, ForceY);
+		OffsetZ = VectorMultiplyAdd(VectorMultiplyAdd(VelocityZ, SinX, VectorMultiply(RestZ, CosX)), DampingFactor, ForceZ);
+		VelocityX = VectorMultiply(VectorNegateMultiplyAdd(RestX, SinX, VectorMultiply(VelocityX, CosX)), DampingFactor);
+		VelocityY = VectorMultiply(VectorNegateMultiplyAdd(RestY, SinX, VectorMultiply(VelocityY, CosX)), DampingFactor);
+		VelocityZ = VectorMultiply(VectorNegateMultiplyAdd(RestZ, SinX, VectorMultiply(VelocityZ, CosX)), DampingFactor);
+
+		// clamp the offset and remove the velocity going further out
+		{
+			const VectorRegister4Float LengthSquared = VectorMultiplyAdd(OffsetX, OffsetX, VectorMultiplyAdd(OffsetY, OffsetY, VectorMultiply(OffsetZ, OffsetZ)));
+			const VectorRegister4Float Length = VectorSqrt(LengthSquared);
+			const VectorRegister4Float Clamped = VectorCompareGT(Length, MaxForce);
+			const VectorRegister4Float Scale = VectorSelect(Clamped, VectorDivide(MaxForce, VectorMax(Length, SmallNumber)), One);
+			OffsetX = VectorMultiply(OffsetX, Scale);
+			OffsetY = VectorMultiply(OffsetY, Scale);
+			OffsetZ = VectorMultiply(OffsetZ, Scale);
+
+			const VectorRegister4Float Dot = VectorMultiplyAdd(OffsetX, VelocityX, VectorMultiplyAdd(OffsetY, VelocityY, VectorMultiply(OffsetZ, VelocityZ)));
+			const VectorRegister4Float ClampedLengthSquared = VectorMultiplyAdd(OffsetX, OffsetX, VectorMultiplyAdd(OffsetY, OffsetY, VectorMultiply(OffsetZ, OffsetZ)));
+			VectorRegister4Float K = VectorDivide(Dot, VectorMax(ClampedLengthSquared, SmallNumber));
+			K = VectorSelect(VectorBitwiseAnd(Clamped, VectorCompareGT(K, Zero)), K, Zero);
+			VelocityX = VectorNegateMultiplyAdd(OffsetX, K, VelocityX);
+			VelocityY = VectorNegateMultiplyAdd(OffsetY, K, VelocityY);
+			VelocityZ = VectorNegateMultiplyAdd(OffsetZ, K, VelocityZ);
+		}
+
+		Store(LinearOffsetX, OffsetX);
+		Store(LinearOffsetY, OffsetY);
+		Store(LinearOffsetZ, OffsetZ);
+		Store(LinearVelocityX, VelocityX);
+		Store(LinearVelocityY, VelocityY);
+		Store(LinearVelocityZ, VelocityZ);
+		Store(PositionX, NewPositionXV);
+		Store(PositionY, NewPositionYV);
+		Store(PositionZ, NewPositionZV);
+
+		/** Angular */
+		const VectorRegister4Float X1 = Load(NewRotationX);
+		const VectorRegister4Float Y1 = Load(NewRotationY);
+		const VectorRegister4Float Z1 = Load(NewRotationZ);
+		const VectorRegister4Float W1 = Load(NewRotationW);
+		const VectorRegister4Float X2 = Load(RotationX);
+		const VectorRegister4Float Y2 = Load(RotationY);
+		const VectorRegister4Float Z2 = Load(RotationZ);
+		const VectorRegister4Float W2 = Load(RotationW);
+
+		// NewRotation * Rotation.Inverse()
+		const VectorRegister4Float DiffX = VectorSubtract(VectorMultiply(W2, X1), VectorMultiplyAdd(W1, X2, VectorSubtract(VectorMultiply(Y1, Z2), VectorMultiply(Z1, Y2))));
+		const VectorRegister4Float DiffY = VectorSubtract(VectorMultiply(W2, Y1), VectorMultiplyAdd(W1, Y2, VectorSubtract(VectorMultiply(Z1, X2), VectorMultiply(X1, Z2))));
+		const VectorRegister4Float DiffZ = VectorSubtract(VectorMultiply(W2, Z1), VectorMultiplyAdd(W1, Z2, VectorSubtract(VectorMultiply(X1, Y2), VectorMultiply(Y1, X2))));
+		const VectorRegister4Float DiffW = VectorMultiplyAdd(W1, W2, VectorMultiplyAdd(X1, X2, VectorMultiplyAdd(Y1, Y2, VectorMultiply(Z1, Z2))));
+
+		// axis and angle in (-PI, PI], the axis is undefined for tiny rotations, they don't add any offset
+		const VectorRegister4Float SinHalfSquared = VectorMultiplyAdd(DiffX, DiffX, VectorMultiplyAdd(DiffY, DiffY, VectorMultiply(DiffZ, DiffZ)));
+		const VectorRegister4Float SinHalf = VectorSqrt(SinHalfSquared);
+		VectorRegister4Float Angle = VectorMultiply(Two, VectorATan2(SinHalf, DiffW));
+		Angle = VectorSelect(VectorCompareGT(Angle, Pi), VectorSubtract(Angle, TwoPi), Angle);
+		const VectorRegister4Float AxisScale = VectorSelect(VectorCompareLT(SinHalfSquared, SmallNumber), Zero,
+			VectorDivide(VectorMultiply(Angle, ForceFactor), VectorMax(SinHalf, SmallNumber)));
+
+		// the offset moves against the rotation, the original `AngularOffset -= Axis * -Angle * ForceFactor`
+		OffsetX = VectorMultiplyAdd(DiffX, AxisScale, Load(AngularOffsetX));
+		OffsetY = VectorMultiplyAdd(DiffY, AxisScale, Load(AngularOffsetY));
+		OffsetZ = VectorMultiplyAdd(DiffZ, AxisScale, Load(AngularOffsetZ));
+		VelocityX = Load(AngularVelocityX);
+		VelocityY = Load(AngularVelocityY);
+		VelocityZ = Load(AngularVelocityZ);
+
+		const VectorRegister4Float NewOffsetX = VectorMultiply(VectorMultiplyAdd(VelocityX, SinX, VectorMultiply(OffsetX, CosX)), DampingFactor);
+		const VectorRegister4Float NewOffsetY = VectorMultiply(VectorMultiplyAdd(VelocityY, SinX, VectorMultiply(OffsetY, CosX)), DampingFactor);
+		const VectorRegister4Float NewOffsetZ = VectorMultiply(VectorMultiplyAdd(VelocityZ, SinX, VectorMultiply(OffsetZ, CosX)), DampingFactor);
+		VelocityX = VectorMultiply(VectorNegateMultiplyAdd(OffsetX, SinX, VectorMultiply(VelocityX, CosX)), DampingFactor);
+		VelocityY = VectorMultiply(VectorNegateMultiplyAdd(OffsetY, SinX, VectorMultiply(VelocityY, CosX)), DampingFactor);
+		VelocityZ = VectorMultiply(VectorNegateMultiplyAdd(OffsetZ, SinX, VectorMultiply(VelocityZ, CosX)), DampingFactor);
+		OffsetX = NewOffsetX;
+		OffsetY = NewOffsetY;
+		OffsetZ = NewOffsetZ;
+
+		{
+			const VectorRegister4Float Length = VectorSqrt(VectorMultiplyAdd(OffsetX, OffsetX, VectorMultiplyAdd(OffsetY, OffsetY, VectorMultiply(OffsetZ, OffsetZ))));
+			const VectorRegister4Float Scale = VectorSelect(VectorCompareGT(Length, MaxTorque), VectorDivide(MaxTorque, VectorMax(Length, SmallNumber)), One);
+			OffsetX = VectorMultiply(OffsetX, Scale);
+			OffsetY = VectorMultiply(OffsetY, Scale);
+			OffsetZ = VectorMultiply(OffsetZ, Scale);
+		}
+
+		Store(AngularOffsetX, OffsetX);
+		Store(AngularOffsetY, OffsetY);
+		Store(AngularOffsetZ, OffsetZ);
+		Store(AngularVelocityX, VelocityX);
+		Store(AngularVelocityY, VelocityY);
+		Store(AngularVelocityZ, VelocityZ);
+		Store(RotationX, X1);
+		Store(RotationY, Y1);
+		Store(RotationZ, Z1);
+		Store(RotationW, W1);
+	}
+}
+void BuildFurPhysicsRegions(int32 MaxRegions, TArrayView<const FVector3f> BonePositions, TArrayView<const float> BoneWeights,
+	TFunctionRef<float(int32, int32)> GetSharedWeight, TArray<int32>& OutBoneRegions, TArray<int32>& OutRegionBones)
+{
+	const int32 NumBones = BonePositions.Num();
+	check(BoneWeights.Num() == NumBones);
+
+	struct FRegion
+	{
+		FVector3f Center;
+		float Weight;
+		int32 Bone;
+		int32 Parent;
+	};
+
+	// skin weights are shared by few bone pairs, every region keeps its own
+	TArray<FRegion> Regions;
+	Regions.SetNumUninitialized(NumBones);
+	TArray<TMap<int32, float>> SharedWeights;
+	SharedWeights.SetNum(NumBones);
+	for (int32 i = 0; i < NumBones; i++)
+	{
+		Regions[i] = { BonePositions[i], FMath::Max(BoneWeights[i], UE_SMALL_NUMBER), i, INDEX_NONE };
+		for (int32 j = 0; j < i; j++)
+		{
+			const float SharedWeight = GetSharedWeight(i, j);
+			if (SharedWeight > 0.0f)
+			{
+				SharedWeights[i].Add(j, SharedWeight);
+				SharedWeights[j].Add(i, SharedWeight);
+			}
+		}
+	}
+
+	auto GetCost = [&Regions, &SharedWeights](int32 i, int32 j)
+	{
+		const float* SharedWeight = SharedWeights[i].Find(j);
+		const float Overlap = SharedWeight ? FMath::Min(*SharedWeight / FMath::Min(Regions[i].Weight, Regions[j].Weight), 1.0f) : 0.0f;
+		return FVector3f::Dist(Regions[i].Center, Regions[j].Center) * (1.0f - 0.5f * Overlap);
+	};
+
+	// every region caches its cheapest merge, only regions which merged or lost their partner search again
+	TArray<int32> Nearest;
+	TArray<float> NearestCosts;
+	Nearest.Init(INDEX_NONE, NumBones);
+	NearestCosts.Init(FLT_MAX, NumBones);
+	auto FindNearest = [&](int32 i)
+	{
+		Nearest[i] = INDEX_NONE;
+		NearestCosts[i] = FLT_MAX;
+		for (int32 j = 0; j < NumBones; j++)
+		{
+			if (j == i || Regions[j].Parent != INDEX_NONE)
+				continue;
+			const float Cost = GetCost(i, j);
+			if (Cost < NearestCosts[i])
+			{
+				NearestCosts[i] = Cost;
+				Nearest[i] = j;
+			}
+		}
+	};
+	for (int32 i = 0; i < NumBones; i++)
+		FindNearest(i);
+
+	// agglomerative clustering of the cheapest pair, mostly quadratic as few cached partners are lost per merge
+	for (int32 NumRegions = NumBones; NumRegions > FMath::Max(MaxRegions, 1); NumRegions--)
+	{
+		int32 BestA = INDEX_NONE;
+		for (int32 i = 0; i < NumBones; i++)
+		{
+			if (Regions[i].Parent == INDEX_NONE && Nearest[i] != INDEX_NONE && (BestA == INDEX_NONE || NearestCosts[i] < NearestCosts[BestA]))
+				BestA = i;
+		}
+		check(BestA != INDEX_NONE);
+		int32 BestB = Nearest[BestA];
+		if (BestB < BestA)
+			Swap(BestA, BestB);
+
+		FRegion& A = Regions[BestA];
+		FRegion& B = Regions[BestB];
+		const float Weight = A.Weight + B.Weight;
+		A.Center = (A.Center * A.Weight + B.Center * B.Weight) / Weight;
+		if (BoneWeights[B.Bone] > BoneWeights[A.Bone])
+			A.Bone = B.Bone;
+		A.Weight = Weight;
+		B.Parent = BestA;
+
+		SharedWeights[BestA].Remove(BestB);
+		for (const TPair<int32, float>& SharedWeight : SharedWeights[BestB])
+		{
+			if (SharedWeight.Key == BestA)
+				continue;
+			SharedWeights[BestA].FindOrAdd(SharedWeight.Key) += SharedWeight.Value;
+			TMap<int32, float>& Other = SharedWeights[SharedWeight.Key];
+			Other.Remove(BestB);
+			Other.FindOrAdd(BestA) += SharedWeight.Value;
+		}
+		SharedWeights[BestB].Empty();
+
+		FindNearest(BestA);
+		for (int32 k = 0; k < NumBones; k++)
+		{
+			if (k == BestA || Regions[k].Parent != INDEX_NONE)
+				continue;
+			if (Nearest[k] == BestA || Nearest[k] == BestB)
+			{
+				FindNearest(k);
+			}
+			else
+			{
+				const float Cost = GetCost(k, BestA);
+				if (Cost < NearestCosts[k])
+				{
+					NearestCosts[k] = Cost;
+					Nearest[k] = BestA;
+				}
+			}
+		}
+	}
+
+	TArray<int32> RegionIndices;
+	RegionIndices.Init(INDEX_NONE, NumBones);
+	OutRegionBones.Reset();
+	for (int32 i = 0; i < NumBones; i++)
+	{
+		if (Regions[i].Parent == INDEX_NONE)
+			RegionIndices[i] = OutRegionBones.Add(Regions[i].Bone);
+	}
+
+	OutBoneRegions.SetNumUninitialized(NumBones);
+	for (int32 i = 0; i < NumBones; i++)
+	{
+		int32 Root = i;
+		while (Regions[Root].Parent != INDEX_NONE)
+			Root = Regions[Root].Parent;
+		OutBoneRegions[i] = RegionIndices[Root];
+	}
+}
+
+EFurPhysicsMode FFurPhysicsThrottle::Evaluate(const FFurPhysicsThrottleSettings& Settings, float TimeSinceRendered, float Distance, float Significance)
+{
+	if (Settings.OffscreenTime >= 0.0f && TimeSinceRendered > Settings.OffscreenTime)
+		return EFurPhysicsMode::Frozen;
+	if (Settings.FrozenDistance > 0.0f && Distance > Settings.FrozenDistance)
+		return EFurPhysicsMode::Frozen;
+	if (Significance < Settings.FrozenSignificance)
+		return EFurPhysicsMode::Frozen;
+	if (Settings.ReducedDistance > 0.0f && Distance > Settings.ReducedDistance)
+		return EFurPhysicsMode::Reduced;
+	if (Significance < Settings.ReducedSignificance)
+		return EFurPhysicsMode::Reduced;
+	return EFurPhysicsMode::Full;
+}
+
+bool FFurPhysicsThrottle::Update(const FFurPhysicsThrottleSettings& Settings, float DeltaTime, float TimeSinceRendered, float Distance, float Significance)
+{
+	const bool WasFrozen = Mode == EFurPhysicsMode::Frozen;
+	Mode = Evaluate(Settings, TimeSinceRendered, Distance, Significance);
+	StepDeltaTime = 0.0f;
+	Resuming = false;
+
+	if (Mode == EFurPhysicsMode::Frozen)
+	{
+		Accumulated = 0.0f;
+		return false;
+	}
+
+	if (WasFrozen)
+	{
+		// bones moved while frozen, the first step only catches up with them
+		Resuming = true;
+		InterpolationValid = false;
+		Accumulated = 0.0f;
+	}
+
+	Accumulated += DeltaTime;
+	if (Mode == EFurPhysicsMode::Full)
+	{
+		StepDeltaTime = Accumulated;
+		Accumulated = 0.0f;
+		InterpolationValid = false;
+		return true;
+	}
+
+	Interval = FMath::Max(Settings.ReducedInterval, UE_SMALL_NUMBER);
+	if (Accumulated < Interval && !Resuming)
+		return false;
+
+	// the previous step is shown right after this one, so the blend continues where it left off
+	StepDeltaTime = Accumulated;
+	Accumulated = 0.0f;
+	InterpolationValid = !Resuming;
+	return true;
+}
+
+float FFurPhysicsThrottle::GetInterpolationAlpha() const
+{
+	if (!InterpolationValid || Mode != EFurPhysicsMode::Reduced)
+		return 1.0f;
+	return FMath::Min(Accumulated / Interval, 1.0f);
+}
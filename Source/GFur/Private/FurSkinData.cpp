@@ -8,6 +8,15 @@
 #include "MeshDrawShaderBindings.h"
 #include "ShaderParameterUtils.h"
 #include "FurComponent.h"
+#include "GFur.h"
+#include "Algo/BinarySearch.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Buffer Locks"), STAT_FurBoneBufferLocks, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Buffer Bytes Uploaded"), STAT_FurBoneBufferBytes, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Uploads"), STAT_FurBoneUploads, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Uploads Skipped"), STAT_FurBoneUploadsSkipped, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Uniform Buffers Created"), STAT_FurBoneUniformBuffersCreated, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Uniform Buffer Updates"), STAT_FurBoneUniformBufferUpdates, STATGROUP_GFur);
 
 static TArray< FFurSkinData* > FurSkinData;
 static FCriticalSection FurSkinDataCS;
@@ -15,6 +24,8 @@ static FCriticalSection FurSkinDataCS;
 // bone limit 512 (from previous 256)
 static unsigned int MaxGPUSkinBones = 512;
 //static uint32 MaxGPUSkinBones = FGPUBaseSkinVertexFactory::GetMaxGPUSkinBones();
+// sections of a LOD share their bones up to this count, it fits the bone uniform buffer of feature levels below ES3_1 as well
+static const int32 MaxSharedLodBones = 256;
 
 /** Fur Skin Vertex Blitter */
 template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT, bool bExtraBoneInfluencesT>
@@ -124,14 +135,11 @@ class FFurSkinVertexFactoryBase : public FFurVertexFactory
 public:
 	struct FShaderDataType
 	{
-		FShaderDataType(ERHIFeatureLevel::Type InFeatureLevel)
+		FShaderDataType()
 			: MeshOrigin(0, 0, 0)
 			, MeshExtension(1, 1, 1)
 			, FurOffsetPower(2.0f)
 			, MaxPhysicsOffsetLength(FLT_MAX)
-			, CurrentBuffer(0)
-			, FeatureLevel(InFeatureLevel)
-			, Discontinuous(true)
 		{
 		}
 
@@ -142,147 +150,12 @@ public:
 		float FurOffsetPower;
 		float MaxPhysicsOffsetLength;
 
-		void Init(uint32 InBoneCount)
-		{
-			BoneCount = InBoneCount;
-		}
-
-		// @param FrameTime from GFrameTime
-		void UpdateBoneData(const TArray<FMatrix>& ReferenceToLocalMatrices, const TArray<FVector>& LinearOffsets, const TArray<FVector>& AngularOffsets,
-			const TArray<FMatrix>& LastTransformations, const TArray<FBoneIndexType>& BoneMap, bool InDiscontinuous, ERHIFeatureLevel::Type FeatureLevel);
-
-		void InitDynamicRHI();
-
-		void ReleaseBoneData()
-		{
-			/*ensure(IsInRenderingThread());*/
-
-			UniformBuffer.SafeRelease();
-
-			for (uint32 i = 0; i < 2; ++i)
-			{
-				BoneBuffer[i].SafeRelease();
-				BoneFurOffsetsBuffer[i].SafeRelease();
-			}
-		}
-
-		// if FeatureLevel < ERHIFeatureLevel::ES3_1
-		FUniformBufferRHIRef GetUniformBuffer() const
-		{
-			return UniformBuffer;
-		}
-
-		// @param bPrevious true:previous, false:current
-		// @param FrameNumber usually from View.Family->FrameNumber
-		const FVertexBufferAndSRV& GetBoneBufferForReading(bool bPrevious) const
-		{
-			const FVertexBufferAndSRV* RetPtr = &GetBoneBufferInternal(bPrevious);
-
-			if (!RetPtr->VertexBufferRHI.IsValid())
-			{
-				// this only should happen if we request the old data
-				check(bPrevious);
-
-				// if we don't have any old data we use the current one
-				RetPtr = &GetBoneBufferInternal(false);
-
-				// at least the current one needs to be valid when reading
-				check(RetPtr->VertexBufferRHI.IsValid());
-			}
-
-			return *RetPtr;
-		}
-
-		// @param bPrevious true:previous, false:current
-		// @param FrameNumber usually from View.Family->FrameNumber
-		// @return IsValid() can fail, then you have to create the buffers first (or if the size changes)
-		FVertexBufferAndSRV& GetBoneBufferForWriting(bool bPrevious)
-		{
-			const FShaderDataType* This = (const FShaderDataType*)this;
-
-			// non const version maps to const version
-			return (FVertexBufferAndSRV&)This->GetBoneBufferInternal(bPrevious);
-		}
-
-		const FVertexBufferAndSRV& GetBoneFurOffsetsBufferForReading(bool bPrevious) const
-		{
-			const FVertexBufferAndSRV* RetPtr = &GetBoneFurOffsetsBufferInternal(bPrevious);
-
-			if (!RetPtr->VertexBufferRHI.IsValid())
-			{
-				// this only should happen if we request the old data
-				check(bPrevious);
-
-				// if we don't have any old data we use the current one
-				RetPtr = &GetBoneFurOffsetsBufferInternal(false);
-
-				// at least the current one needs to be valid when reading
-				check(RetPtr->VertexBufferRHI.IsValid());
-			}
-
-			return *RetPtr;
-		}
-
-		FVertexBufferAndSRV& GetBoneFurOffsetsBufferForWriting(bool bPrevious)
-		{
-			const FShaderDataType* This = (const FShaderDataType*)this;
-
-			// non const version maps to const version
-			return (FVertexBufferAndSRV&)This->GetBoneFurOffsetsBufferInternal(bPrevious);
-		}
-
-	private:
-		// double buffered bone positions+orientations to support normal rendering and velocity (new-old position) rendering
-		FVertexBufferAndSRV BoneBuffer[2];
-		FVertexBufferAndSRV BoneFurOffsetsBuffer[2];
-		// 0 / 1 to index into BoneBuffer
-		uint32 CurrentBuffer;
-		// if FeatureLevel < ERHIFeatureLevel::ES3_1
-		FUniformBufferRHIRef UniformBuffer;
-		uint32 BoneCount;
-		ERHIFeatureLevel::Type FeatureLevel;
-		bool Discontinuous;
-
-		void GoToNextFrame(bool InDiscontinuous);
-
-		// to support GetBoneBufferForWriting() and GetBoneBufferForReading()
-		// @param bPrevious true:previous, false:current
-		// @param FrameNumber usually from View.Family->FrameNumber
-		// @return might not pass the IsValid() 
-		const FVertexBufferAndSRV& GetBoneBufferInternal(bool bPrevious) const
-		{
-			check(IsInParallelRenderingThread());
-
-			if (Discontinuous)
-			{
-				bPrevious = false;
-			}
-
-			uint32 BufferIndex = CurrentBuffer ^ (uint32)bPrevious;
-
-			const FVertexBufferAndSRV& Ret = BoneBuffer[BufferIndex];
-			return Ret;
-		}
-
-		const FVertexBufferAndSRV& GetBoneFurOffsetsBufferInternal(bool bPrevious) const
-		{
-			check(IsInParallelRenderingThread());
-
-			if (Discontinuous)
-			{
-				bPrevious = false;
-			}
-
-			uint32 BufferIndex = CurrentBuffer ^ (uint32)bPrevious;
-
-			const FVertexBufferAndSRV& Ret = BoneFurOffsetsBuffer[BufferIndex];
-			return Ret;
-		}
+		/** Bone buffers shared with the other sections of the LOD */
+		TSharedPtr<FFurSkinBoneData, ESPMode::ThreadSafe> BoneData;
 	};
 
 	FFurSkinVertexFactoryBase(ERHIFeatureLevel::Type InFeatureLevel)
 		: FFurVertexFactory(InFeatureLevel)
-		, ShaderData(InFeatureLevel)
 	{
 	}
 
@@ -303,10 +176,10 @@ public:
 	};
 
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT>
-	void Init(const FFurVertexBuffer* VertexBuffer, const FVertexBuffer* MorphVertexBuffer, uint32 BoneCount)
+	void Init(const FFurVertexBuffer* VertexBuffer, const FVertexBuffer* MorphVertexBuffer, const TSharedPtr<FFurSkinBoneData, ESPMode::ThreadSafe>& InBoneData)
 	{
 		typedef FFurSkinVertex<TangentBasisTypeT, UVTypeT, bExtraInfluencesT> VertexType;
-		ShaderData.Init(BoneCount);
+		ShaderData.BoneData = InBoneData;
 		ENQUEUE_RENDER_COMMAND(InitProceduralMeshVertexFactory)
 			([this, VertexBuffer, MorphVertexBuffer](FRHICommandListImmediate& RHICmdList) {
 				const auto TangentElementType = TStaticMeshVertexTangentTypeSelector<TangentBasisTypeT>::VertexElementType;
@@ -451,21 +324,24 @@ public:
 
 		//Old InitDynamicRHI
 		FVertexFactory::InitRHI(RHICmdList);
-		ShaderData.InitDynamicRHI();
+		ShaderData.BoneData->InitRHI(RHICmdList);
 	}
 
 	void ReleaseRHI() override
 	{
 		FVertexFactory::ReleaseRHI();
-		ShaderData.ReleaseBoneData();
+		ShaderData.BoneData->ReleaseRHI();
 	}
 
-	void UpdateSkeletonShaderData(float InFurOffsetPower, float InMaxPhysicsOffsetLength, const TArray<FMatrix>& InReferenceToLocal, const TArray<FVector>& InLinearOffsets, const TArray<FVector>& InAngularOffsets,
-		const TArray<FMatrix>& InTransformations, const TArray<FBoneIndexType>& InBoneMap, bool InDiscontinuous, ERHIFeatureLevel::Type InFeatureLevel) override
+	void UpdateSkeletonShaderData(float InFurOffsetPower, float InMaxPhysicsOffsetLength) override
 	{
 		ShaderData.FurOffsetPower = InFurOffsetPower;
 		ShaderData.MaxPhysicsOffsetLength = InMaxPhysicsOffsetLength;
-		ShaderData.UpdateBoneData(InReferenceToLocal, InLinearOffsets, InAngularOffsets, InTransformations, InBoneMap, InDiscontinuous, InFeatureLevel);
+	}
+
+	FFurSkinBoneData* GetSkinBoneData() const override
+	{
+		return ShaderData.BoneData.Get();
 	}
 
 	FDataType Data;
@@ -635,249 +511,189 @@ IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FBoneMatricesUniformShaderParameters, "
 // End of fix from gloriousayu
 
 
-static FBoneMatricesUniformShaderParameters GBoneUniformStruct;
-
-template<bool MorphTargets, bool Physics, bool ExtraInfluences>
-void FFurSkinVertexFactoryBase<MorphTargets, Physics, ExtraInfluences>::FShaderDataType::GoToNextFrame(bool InDiscontinuous)
-{
-	CurrentBuffer = 1 - CurrentBuffer;
-	Discontinuous = InDiscontinuous;
-}
-
-template<bool MorphTargets, bool Physics, bool ExtraInfluences>
-void FFurSkinVertexFactoryBase<MorphTargets, Physics, ExtraInfluences>::FShaderDataType::UpdateBoneData(const TArray<FMatrix>& ReferenceToLocalMatrices, const TArray<FVector>& LinearOffsets, const TArray<FVector>& AngularOffsets,
-	const TArray<FMatrix>& LastTransformations, const TArray<FBoneIndexType>& BoneMap, bool InDiscontinuous, ERHIFeatureLevel::Type InFeatureLevel)
+void FFurSkinBoneData::CreateBuffers(FRHICommandListBase& RHICmdList, bool bPrevious)
 {
-	//class FRHICommandListBase* RHICmdList;
-	FRHICommandListBase& RHICmdList = FRHICommandListExecutor::GetImmediateCommandList();
-	
-	const uint32 NumBones = BoneMap.Num();
-	check(NumBones <= MaxGPUSkinBones);
-	float* ChunkMatrices = nullptr;
-	FVector4f* Offsets = nullptr;
-
-	FVertexBufferAndSRV* CurrentBoneBuffer = 0;
-	FVertexBufferAndSRV* CurrentBoneFurOffsetsBuffer = 0;
-
-	if (InFeatureLevel >= ERHIFeatureLevel::ES3_1)
+	const uint32 BufferIndex = CurrentBuffer ^ (uint32)bPrevious;
+	const uint32 VectorArraySize = FMath::Max(NumBones, 1u) * 3 * sizeof(FVector4f);
+	for (FVertexBufferAndSRV* Buffer : { &BoneBuffer[BufferIndex], &BoneFurOffsetsBuffer[BufferIndex] })
 	{
-		check(IsInRenderingThread());
-		GoToNextFrame(InDiscontinuous);
-
-		CurrentBoneBuffer = &GetBoneBufferForWriting(false);
-
-		uint32 NumVectors = NumBones * 3;
-		check(NumVectors <= (MaxGPUSkinBones * 3));
-		uint32 VectorArraySize = NumVectors * sizeof(FVector4f);
-
-		uint32 OffsetArraySize = NumBones * 3 * sizeof(FVector4f);
-
-
-		if (!IsValidRef(*CurrentBoneBuffer))
+		if (!IsValidRef(*Buffer))
 		{
-			FVertexBufferAndSRV Buffer;
 			FRHIResourceCreateInfo CreateInfo(L"FurVertexBuffer");
-			
-		
-
-			//Buffer.VertexBufferRHI = FRHICommandListBase::CreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			//Buffer.VertexBufferSRV = RHICreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-
-			Buffer.VertexBufferRHI =  RHICmdList.CreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			Buffer.VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-
-			*CurrentBoneBuffer = Buffer;
-			check(IsValidRef(*CurrentBoneBuffer));
+			Buffer->VertexBufferRHI = RHICmdList.CreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
+			Buffer->VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer->VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
+			check(IsValidRef(*Buffer));
 		}
+	}
+}
 
-		CurrentBoneFurOffsetsBuffer = &GetBoneFurOffsetsBufferForWriting(false);
-		if (!IsValidRef(*CurrentBoneFurOffsetsBuffer))
-		{
-			FVertexBufferAndSRV Buffer;
-			FRHIResourceCreateInfo CreateInfo(L"FurVertexBuffer");
-
-			//Buffer.VertexBufferRHI = RHICreateVertexBuffer(OffsetArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			//Buffer.VertexBufferSRV = RHICreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-			Buffer.VertexBufferRHI = RHICmdList.CreateVertexBuffer(OffsetArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			Buffer.VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
+void FFurSkinBoneData::InitRHI(FRHICommandListBase& RHICmdList)
+{
+	if (NumInitializedUsers++ == 0)
+		InitResources(RHICmdList);
+}
 
-			*CurrentBoneFurOffsetsBuffer = Buffer;
-			check(IsValidRef(*CurrentBoneFurOffsetsBuffer));
-		}
+void FFurSkinBoneData::ReleaseRHI()
+{
+	check(NumInitializedUsers > 0);
+	if (--NumInitializedUsers == 0)
+		ReleaseResources();
+}
 
-		if (NumBones)
-		{
-			//ChunkMatrices = (float*)RHILockBuffer(CurrentBoneBuffer->VertexBufferRHI, 0, VectorArraySize, RLM_WriteOnly);
-			//Offsets = (FVector4f*)RHILockBuffer(CurrentBoneFurOffsetsBuffer->VertexBufferRHI, 0, OffsetArraySize, RLM_WriteOnly);
-			
-			ChunkMatrices = (float*)RHICmdList.LockBuffer(CurrentBoneBuffer->VertexBufferRHI, 0, VectorArraySize, RLM_WriteOnly);
-			Offsets = (FVector4f*)RHICmdList.LockBuffer(CurrentBoneFurOffsetsBuffer->VertexBufferRHI, 0, OffsetArraySize, RLM_WriteOnly);
-		}
+void FFurSkinBoneData::InitResources(FRHICommandListBase& RHICmdList)
+{
+	check(NumBones <= MaxGPUSkinBones);
+	if (FeatureLevel >= ERHIFeatureLevel::ES3_1)
+	{
+		check(IsInRenderingThread());
+		CreateBuffers(RHICmdList, false);
+		CreateBuffers(RHICmdList, true);
 	}
-	else
+	else if (!UniformBuffer.IsValid())
 	{
-		if (NumBones)
-		{
-			check(NumBones * sizeof(float) * 12 <= sizeof(GBoneUniformStruct));
-			ChunkMatrices = (float*)&GBoneUniformStruct;
-		}
+		UniformData.SetNumZeroed(sizeof(FBoneMatricesUniformShaderParameters));
+		UniformBuffer = RHICreateUniformBuffer(UniformData.GetData(), &FBoneMatricesUniformShaderParameters::GetStructMetadata()->GetLayout(), UniformBuffer_MultiFrame);
+		INC_DWORD_STAT(STAT_FurBoneUniformBuffersCreated);
 	}
+}
 
-	if (InFeatureLevel >= ERHIFeatureLevel::ES3_1)
-	{
-		//FSkinMatrix3x4 is sizeof() == 48
-		// PLATFORM_CACHE_LINE_SIZE (128) / 48 = 2.6
-		//  sizeof(FMatrix) == 64
-		// PLATFORM_CACHE_LINE_SIZE (128) / 64 = 2
-		const int32 PreFetchStride = 2; // FPlatformMisc::Prefetch stride
-		for (uint32 BoneIdx = 0; BoneIdx < NumBones; BoneIdx++)
-		{
-			const FBoneIndexType RefToLocalIdx = BoneMap[BoneIdx];
-			FPlatformMisc::Prefetch(ReferenceToLocalMatrices.GetData() + RefToLocalIdx + PreFetchStride);
-			FPlatformMisc::Prefetch(ReferenceToLocalMatrices.GetData() + RefToLocalIdx + PreFetchStride, PLATFORM_CACHE_LINE_SIZE);
+void FFurSkinBoneData::ReleaseResources()
+{
+	/*ensure(IsInRenderingThread());*/
 
-			float* BoneMat = ChunkMatrices + BoneIdx * 12;
-			const FMatrix44f RefToLocal = FMatrix44f(ReferenceToLocalMatrices[RefToLocalIdx]);
-			RefToLocal.To3x4MatrixTranspose(BoneMat);
+	UniformBuffer.SafeRelease();
+	UniformData.Empty();
+	UploadedRevisionValid = false;
+	Unchanged = false;
 
-			Offsets[BoneIdx * 3] = FVector3f(LinearOffsets[RefToLocalIdx]);
-			Offsets[BoneIdx * 3 + 1] = FVector3f(AngularOffsets[RefToLocalIdx]);
-			Offsets[BoneIdx * 3 + 2] = FVector3f(LastTransformations[RefToLocalIdx].GetOrigin());
-		}
-	}
-	else
+	for (uint32 i = 0; i < 2; ++i)
 	{
-		const int32 PreFetchStride = 2; // FPlatformMisc::Prefetch stride
-		for (uint32 BoneIdx = 0; BoneIdx < NumBones; BoneIdx++)
-		{
-			const FBoneIndexType RefToLocalIdx = BoneMap[BoneIdx];
-			FPlatformMisc::Prefetch(ReferenceToLocalMatrices.GetData() + RefToLocalIdx + PreFetchStride);
-			FPlatformMisc::Prefetch(ReferenceToLocalMatrices.GetData() + RefToLocalIdx + PreFetchStride, PLATFORM_CACHE_LINE_SIZE);
-
-			float* BoneMat = ChunkMatrices + BoneIdx * 12;
-			const FMatrix44f RefToLocal = FMatrix44f(ReferenceToLocalMatrices[RefToLocalIdx]);
-			RefToLocal.To3x4MatrixTranspose(BoneMat);
-		}
+		BoneBuffer[i].SafeRelease();
+		BoneFurOffsetsBuffer[i].SafeRelease();
 	}
-	if (InFeatureLevel >= ERHIFeatureLevel::ES3_1)
-	{
-		if (NumBones)
-		{
-			check(CurrentBoneBuffer);
-			//RHIUnlockBuffer(CurrentBoneBuffer->VertexBufferRHI);
-			RHICmdList.UnlockBuffer(CurrentBoneBuffer->VertexBufferRHI);
+}
 
-			check(CurrentBoneFurOffsetsBuffer);
-			//RHIUnlockBuffer(CurrentBoneFurOffsetsBuffer->VertexBufferRHI);
-			RHICmdList.UnlockBuffer(CurrentBoneFurOffsetsBuffer->VertexBufferRHI);
-		}
+const FVertexBufferAndSRV& FFurSkinBoneData::GetBufferForReading(const FVertexBufferAndSRV (&Buffers)[2], bool bPrevious) const
+{
+	check(IsInParallelRenderingThread());
+
+	if (Discontinuous || Unchanged)
+	{
+		bPrevious = false;
 	}
-	else
+
+	const FVertexBufferAndSRV* RetPtr = &Buffers[CurrentBuffer ^ (uint32)bPrevious];
+	if (!RetPtr->VertexBufferRHI.IsValid())
 	{
-		//UniformBuffer = RHICreateUniformBuffer(&GBoneUniformStruct, &FBoneMatricesUniformShaderParameters::StaticStructMetadata.GetLayout(), UniformBuffer_MultiFrame);
-		UniformBuffer = RHICreateUniformBuffer(&GBoneUniformStruct, &FBoneMatricesUniformShaderParameters::GetStructMetadata()->GetLayout(), UniformBuffer_MultiFrame);
+		// this only should happen if we request the old data
+		check(bPrevious);
 
+		// if we don't have any old data we use the current one
+		RetPtr = &Buffers[CurrentBuffer];
+
+		// at least the current one needs to be valid when reading
+		check(RetPtr->VertexBufferRHI.IsValid());
 	}
+
+	return *RetPtr;
 }
 
-template<bool MorphTargets, bool Physics, bool ExtraInfluences>
-void FFurSkinVertexFactoryBase<MorphTargets, Physics, ExtraInfluences>::FShaderDataType::InitDynamicRHI()
+void FFurSkinBoneData::Update(FRHICommandListBase& RHICmdList, const TArray<FMatrix>& ReferenceToLocalMatrices, const TArray<FVector3f>& LinearOffsets,
+	const TArray<FVector3f>& AngularOffsets, const TArray<FVector3f>& BonePositions, const TArray<FBoneIndexType>& BoneMap, uint32 Revision, bool InDiscontinuous)
 {
-	const uint32 NumBones = BoneCount;
-	check(NumBones <= MaxGPUSkinBones);
+	const uint32 NumMappedBones = BoneMap.Num();
+	check(NumMappedBones <= MaxGPUSkinBones);
+
+	// the current buffer already holds this revision, keep it and stop the motion of the previous frame
+	if (UploadedRevisionValid && UploadedRevision == Revision && UploadedNumBones == NumMappedBones && NumMappedBones <= NumBones)
+	{
+		Unchanged = true;
+		INC_DWORD_STAT(STAT_FurBoneUploadsSkipped);
+		return;
+	}
+	Unchanged = false;
+	INC_DWORD_STAT(STAT_FurBoneUploads);
 	float* ChunkMatrices = nullptr;
+	FVector4f* Offsets = nullptr;
+
+	const uint32 VectorArraySize = NumMappedBones * 3 * sizeof(FVector4f);
+	const uint32 OffsetArraySize = NumMappedBones * 3 * sizeof(FVector4f);
 
-	//class FRHICommandListBase* RHICmdList;
-	FRHICommandListBase& RHICmdList = FRHICommandListExecutor::GetImmediateCommandList();
 	if (FeatureLevel >= ERHIFeatureLevel::ES3_1)
 	{
 		check(IsInRenderingThread());
+		CurrentBuffer = 1 - CurrentBuffer;
+		Discontinuous = InDiscontinuous;
 
-		uint32 NumVectors = NumBones * 3;
-		check(NumVectors <= (MaxGPUSkinBones * 3));
-		uint32 VectorArraySize = NumVectors * sizeof(FVector4f);
-
-		uint32 OffsetArraySize = NumBones * 3 * sizeof(FVector4f);
-
-		FVertexBufferAndSRV* CurrentBoneBuffer = &GetBoneBufferForWriting(false);
-		if (!IsValidRef(*CurrentBoneBuffer))
+		if (NumMappedBones > NumBones)
 		{
-			FVertexBufferAndSRV Buffer;
-			FRHIResourceCreateInfo CreateInfo(L"FurVertexBuffer");
-
-			//Buffer.VertexBufferRHI = RHICreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			//Buffer.VertexBufferSRV = RHICreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-			
-			Buffer.VertexBufferRHI = RHICmdList.CreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			Buffer.VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-
-			*CurrentBoneBuffer = Buffer;
-			check(IsValidRef(*CurrentBoneBuffer));
+			// LOD bone map grew after the fur was rebuilt
+			NumBones = NumMappedBones;
+			ReleaseResources();
+			CreateBuffers(RHICmdList, true);
 		}
+		CreateBuffers(RHICmdList, false);
 
-		FVertexBufferAndSRV* PreviousBoneBuffer = &GetBoneBufferForWriting(true);
-		if (!IsValidRef(*PreviousBoneBuffer))
+		if (NumMappedBones)
 		{
-			FVertexBufferAndSRV Buffer;
-			FRHIResourceCreateInfo CreateInfo(L"FurVertexBuffer");
-
-			//Buffer.VertexBufferRHI = RHICreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			//Buffer.VertexBufferSRV = RHICreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-			Buffer.VertexBufferRHI = RHICmdList.CreateVertexBuffer(VectorArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			Buffer.VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-
-			*PreviousBoneBuffer = Buffer;
-			check(IsValidRef(*PreviousBoneBuffer));
+			ChunkMatrices = (float*)RHICmdList.LockBuffer(BoneBuffer[CurrentBuffer].VertexBufferRHI, 0, VectorArraySize, RLM_WriteOnly);
+			Offsets = (FVector4f*)RHICmdList.LockBuffer(BoneFurOffsetsBuffer[CurrentBuffer].VertexBufferRHI, 0, OffsetArraySize, RLM_WriteOnly);
+			INC_DWORD_STAT_BY(STAT_FurBoneBufferLocks, 2);
+			INC_DWORD_STAT_BY(STAT_FurBoneBufferBytes, VectorArraySize + OffsetArraySize);
 		}
-
-		FVertexBufferAndSRV* CurrentBoneFurOffsetsBuffer = &GetBoneFurOffsetsBufferForWriting(false);
-		if (!IsValidRef(*CurrentBoneFurOffsetsBuffer))
+	}
+	else
+	{
+		if (!UniformBuffer.IsValid())
+			InitResources(RHICmdList);
+		if (NumMappedBones)
 		{
-			FVertexBufferAndSRV Buffer;
-			FRHIResourceCreateInfo CreateInfo(L"FurVertexBuffer");
-
-			//Buffer.VertexBufferRHI = RHICreateVertexBuffer(OffsetArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			//Buffer.VertexBufferSRV = RHICreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-			Buffer.VertexBufferRHI = RHICmdList.CreateVertexBuffer(OffsetArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			Buffer.VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-
-			*CurrentBoneFurOffsetsBuffer = Buffer;
-			check(IsValidRef(*CurrentBoneFurOffsetsBuffer));
+			check(NumMappedBones * sizeof(float) * 12 <= (uint32)UniformData.Num());
+			ChunkMatrices = (float*)UniformData.GetData();
 		}
+	}
 
-		FVertexBufferAndSRV* PreviousBoneFurOffsetsBuffer = &GetBoneFurOffsetsBufferForWriting(true);
-		if (!IsValidRef(*PreviousBoneFurOffsetsBuffer))
-		{
-			FVertexBufferAndSRV Buffer;
-			FRHIResourceCreateInfo CreateInfo(L"FurVertexBuffer");
+	//FSkinMatrix3x4 is sizeof() == 48
+	// PLATFORM_CACHE_LINE_SIZE (128) / 48 = 2.6
+	//  sizeof(FMatrix) == 64
+	// PLATFORM_CACHE_LINE_SIZE (128) / 64 = 2
+	const int32 PreFetchStride = 2; // FPlatformMisc::Prefetch stride
+	for (uint32 BoneIdx = 0; BoneIdx < NumMappedBones; BoneIdx++)
+	{
+		const FBoneIndexType RefToLocalIdx = BoneMap[BoneIdx];
+		FPlatformMisc::Prefetch(ReferenceToLocalMatrices.GetData() + RefToLocalIdx + PreFetchStride);
+		FPlatformMisc::Prefetch(ReferenceToLocalMatrices.GetData() + RefToLocalIdx + PreFetchStride, PLATFORM_CACHE_LINE_SIZE);
 
-			//Buffer.VertexBufferRHI = RHICreateVertexBuffer(OffsetArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			//Buffer.VertexBufferSRV = RHICreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
-			Buffer.VertexBufferRHI = RHICmdList.CreateVertexBuffer(OffsetArraySize, (BUF_Dynamic | BUF_ShaderResource), CreateInfo);
-			Buffer.VertexBufferSRV = RHICmdList.CreateShaderResourceView(Buffer.VertexBufferRHI, sizeof(FVector4f), PF_A32B32G32R32F);
+		float* BoneMat = ChunkMatrices + BoneIdx * 12;
+		const FMatrix44f RefToLocal = FMatrix44f(ReferenceToLocalMatrices[RefToLocalIdx]);
+		RefToLocal.To3x4MatrixTranspose(BoneMat);
 
-			*PreviousBoneFurOffsetsBuffer = Buffer;
-			check(IsValidRef(*PreviousBoneFurOffsetsBuffer));
-		}
-	}
-	else
-	{
-		if (NumBones)
+		if (Offsets)
 		{
-			check(NumBones * sizeof(float) * 12 <= sizeof(GBoneUniformStruct));
-			ChunkMatrices = (float*)&GBoneUniformStruct;
+			Offsets[BoneIdx * 3] = LinearOffsets[RefToLocalIdx];
+			Offsets[BoneIdx * 3 + 1] = AngularOffsets[RefToLocalIdx];
+			Offsets[BoneIdx * 3 + 2] = BonePositions[RefToLocalIdx];
 		}
 	}
 
 	if (FeatureLevel >= ERHIFeatureLevel::ES3_1)
 	{
+		if (NumMappedBones)
+		{
+			RHICmdList.UnlockBuffer(BoneBuffer[CurrentBuffer].VertexBufferRHI);
+			RHICmdList.UnlockBuffer(BoneFurOffsetsBuffer[CurrentBuffer].VertexBufferRHI);
+		}
 	}
 	else
 	{
-		//UniformBuffer = RHICreateUniformBuffer(&GBoneUniformStruct, &FBoneMatricesUniformShaderParameters::StaticStructMetadata.GetLayout(), UniformBuffer_MultiFrame);
-		UniformBuffer = RHICreateUniformBuffer(&GBoneUniformStruct, &FBoneMatricesUniformShaderParameters::GetStructMetadata()->GetLayout(), UniformBuffer_MultiFrame);
-
+		// contents are copied by the command list, the buffer itself lives as long as the bone data
+		RHICmdList.UpdateUniformBuffer(UniformBuffer, UniformData.GetData());
+		INC_DWORD_STAT(STAT_FurBoneUniformBufferUpdates);
 	}
+
+	UploadedRevision = Revision;
+	UploadedNumBones = NumMappedBones;
+	UploadedRevisionValid = true;
 }
 
 template<bool Physics>
@@ -893,6 +709,7 @@ void FFurSkinVertexFactoryShaderParameters<Physics>::GetElementShaderBindings(
 	FVertexInputStreamArray& VertexStreams) const
 {
 	FFurSkinVertexFactory::FShaderDataType& ShaderData = ((FFurSkinVertexFactory*)VertexFactory)->ShaderData;
+	const FFurSkinBoneData& BoneData = *ShaderData.BoneData;
 
 	ShaderBindings.Add(MeshOriginParameter, ShaderData.MeshOrigin);
 	ShaderBindings.Add(MeshExtensionParameter, ShaderData.MeshExtension);
@@ -903,14 +720,14 @@ void FFurSkinVertexFactoryShaderParameters<Physics>::GetElementShaderBindings(
 
 	if (BoneMatrices.IsBound())
 	{
-		auto CurrentData = ShaderData.GetBoneBufferForReading(false).VertexBufferSRV;
+		auto CurrentData = BoneData.GetBoneBufferForReading(false).VertexBufferSRV;
 		ShaderBindings.Add(BoneMatrices, CurrentData);
 	}
 	if (PreviousBoneMatrices.IsBound())
 	{
 		// todo: Maybe a check for PreviousData!=CurrentData would save some performance (when objects don't have velocty yet) but removing the bool also might save performance
 
-		auto PreviousData = ShaderData.GetBoneBufferForReading(true).VertexBufferSRV;
+		auto PreviousData = BoneData.GetBoneBufferForReading(true).VertexBufferSRV;
 		ShaderBindings.Add(PreviousBoneMatrices, PreviousData);
 	}
 
@@ -918,18 +735,18 @@ void FFurSkinVertexFactoryShaderParameters<Physics>::GetElementShaderBindings(
 	{
 		if (BoneFurOffsets.IsBound())
 		{
-			auto CurrentData = ShaderData.GetBoneFurOffsetsBufferForReading(false).VertexBufferSRV;
+			auto CurrentData = BoneData.GetBoneFurOffsetsBufferForReading(false).VertexBufferSRV;
 			ShaderBindings.Add(BoneFurOffsets, CurrentData);
 		}
 		if (PreviousBoneFurOffsets.IsBound())
 		{
-			auto PreviousData = ShaderData.GetBoneFurOffsetsBufferForReading(true).VertexBufferSRV;
+			auto PreviousData = BoneData.GetBoneFurOffsetsBufferForReading(true).VertexBufferSRV;
 			ShaderBindings.Add(PreviousBoneFurOffsets, PreviousData);
 		}
 	}
 	else
 	{
-		ShaderBindings.Add(Shader->GetUniformBufferParameter<FBoneMatricesUniformShaderParameters>(), ShaderData.GetUniformBuffer());
+		ShaderBindings.Add(Shader->GetUniformBufferParameter<FBoneMatricesUniformShaderParameters>(), BoneData.GetUniformBuffer());
 	}
 }
 
@@ -944,6 +761,7 @@ FFurSkinData* FFurSkinData::CreateFurData(int32 InFurLayerCount, int32 InLod, UG
 	{
 		if (Data->Compare(InFurLayerCount, InLod, InFurComponent))
 		{
+			Data->WaitForFullBuild();
 			Data->RefCount++;
 			return Data;
 		}
@@ -966,6 +784,52 @@ FFurSkinData* FFurSkinData::CreateFurData(int32 InFurLayerCount, int32 InLod, UG
 	return Data;
 }
 
+FFurSkinData* FFurSkinData::CreateFurDataAsync(int32 InFurLayerCount, int32 InLod, UGFurComponent* InFurComponent, FFurData*& OutPending)
+{
+	check(InFurLayerCount >= MinimalFurLayerCount && InFurLayerCount <= MaximalFurLayerCount);
+
+	FScopeLock lock(&FurSkinDataCS);
+
+	OutPending = nullptr;
+	FFurSkinData* Pending = nullptr;
+	for (FFurSkinData* Data : FurSkinData)
+	{
+		if (Data->Compare(InFurLayerCount, InLod, InFurComponent))
+		{
+			Data->RefCount++;
+			if (Data->IsBuilt())
+				return Data;
+			Pending = Data;
+			break;
+		}
+	}
+
+	if (!Pending)
+	{
+		Pending = new FFurSkinData();
+		Pending->Set(InFurLayerCount, InLod, InFurComponent);
+		Pending->FullBuildEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Pending]()
+		{
+			Pending->BuildFur(BuildType::Full);
+		}, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask);
+		FurSkinData.Add(Pending);
+	}
+
+	// built fur of the same mesh is shown until the new one is done
+	for (FFurSkinData* Data : FurSkinData)
+	{
+		if (Data != Pending && Data->IsBuilt() && Data->Similar(InLod, InFurComponent))
+		{
+			Data->RefCount++;
+			OutPending = Pending;
+			return Data;
+		}
+	}
+
+	Pending->WaitForFullBuild();
+	return Pending;
+}
+
 void FFurSkinData::DestroyFurData(const TArray<FFurData*>& InFurDataArray)
 {
 	FScopeLock lock(&FurSkinDataCS);
@@ -991,27 +855,33 @@ void FFurSkinData::DestroyFurData(const TArray<FFurData*>& InFurDataArray)
 
 void FFurSkinData::CreateVertexFactories(TArray<FFurVertexFactory*>& VertexFactories, FVertexBuffer* InMorphVertexBuffer, bool InPhysics, ERHIFeatureLevel::Type InFeatureLevel)
 {
+	TArray<TSharedPtr<FFurSkinBoneData, ESPMode::ThreadSafe>, TInlineAllocator<8>> BoneDatas;
+	for (const TArray<FBoneIndexType>& BoneMap : BoneMaps)
+		BoneDatas.Add(MakeShared<FFurSkinBoneData, ESPMode::ThreadSafe>(BoneMap.Num(), InFeatureLevel));
+	int32 SectionIndex = 0;
 	auto CreateVertexFactory = [&](const FFurData::FSection& s, auto* vf) {
+		const auto& BoneData = BoneDatas[GetBoneMapIndex(BoneMaps, SectionIndex)];
 		if (bUseHighPrecisionTangentBasis)
 		{
 			if (bUseFullPrecisionUVs)
-				vf->template Init<EStaticMeshVertexTangentBasisType::HighPrecision, EStaticMeshVertexUVType::HighPrecision>(&VertexBuffer, InMorphVertexBuffer, s.NumBones);
+				vf->template Init<EStaticMeshVertexTangentBasisType::HighPrecision, EStaticMeshVertexUVType::HighPrecision>(&VertexBuffer, InMorphVertexBuffer, BoneData);
 			else
-				vf->template Init<EStaticMeshVertexTangentBasisType::HighPrecision, EStaticMeshVertexUVType::Default>(&VertexBuffer, InMorphVertexBuffer, s.NumBones);
+				vf->template Init<EStaticMeshVertexTangentBasisType::HighPrecision, EStaticMeshVertexUVType::Default>(&VertexBuffer, InMorphVertexBuffer, BoneData);
 		}
 		else
 		{
 			if (bUseFullPrecisionUVs)
-				vf->template Init<EStaticMeshVertexTangentBasisType::Default, EStaticMeshVertexUVType::HighPrecision>(&VertexBuffer, InMorphVertexBuffer, s.NumBones);
+				vf->template Init<EStaticMeshVertexTangentBasisType::Default, EStaticMeshVertexUVType::HighPrecision>(&VertexBuffer, InMorphVertexBuffer, BoneData);
 			else
-				vf->template Init<EStaticMeshVertexTangentBasisType::Default, EStaticMeshVertexUVType::Default>(&VertexBuffer, InMorphVertexBuffer, s.NumBones);
+				vf->template Init<EStaticMeshVertexTangentBasisType::Default, EStaticMeshVertexUVType::Default>(&VertexBuffer, InMorphVertexBuffer, BoneData);
 		}
 		BeginInitResource(vf);
 		VertexFactories.Add(vf);
 	};
 
-	for (auto& s : Sections)
+	for (SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
 	{
+		const auto& s = Sections[SectionIndex];
 		if (InPhysics && InFeatureLevel >= ERHIFeatureLevel::ES3_1)
 		{
 			if (InMorphVertexBuffer)
@@ -1051,6 +921,10 @@ void FFurSkinData::CreateVertexFactories(TArray<FFurVertexFactory*>& VertexFacto
 
 FFurSkinData::~FFurSkinData()
 {
+	// the rebuild task of combed vertices and the full build task call back into this object
+	WaitForFullBuild();
+	WaitForBuildFur(true);
+
 	UnbindChangeDelegates();
 
 #if WITH_EDITORONLY_DATA
@@ -1076,6 +950,11 @@ void FFurSkinData::UnbindChangeDelegates()
 			FurSplinesAssigned->OnSplinesCombed.Remove(FurSplinesCombHandle);
 			FurSplinesCombHandle.Reset();
 		}
+		if (FurSplinesAddRemoveHandle.IsValid())
+		{
+			FurSplinesAssigned->OnSplinesAddedRemoved.Remove(FurSplinesAddRemoveHandle);
+			FurSplinesAddRemoveHandle.Reset();
+		}
 	}
 	if (SkeletalMesh && SkeletalMeshChangeHandle.IsValid())
 	{
@@ -1106,6 +985,7 @@ void FFurSkinData::Set(int32 InFurLayerCount, int32 InLod, class UGFurComponent*
 
 	SkeletalMesh = InFurComponent->SkeletalGrowMesh;
 	GuideMeshes = InFurComponent->SkeletalGuideMeshes;
+	MaxPhysicsRegions = InFurComponent->MaxPhysicsRegions;
 #if WITH_EDITORONLY_DATA
 	if (SkeletalMesh)
 		SkeletalMesh->AddToRoot();
@@ -1125,11 +1005,12 @@ void FFurSkinData::Set(int32 InFurLayerCount, int32 InLod, class UGFurComponent*
 	}
 
 #if WITH_EDITORONLY_DATA
-	SkeletalMeshChangeHandle = SkeletalMesh->GetOnMeshChanged().AddLambda([this]() { BuildFur(BuildType::Full); });
+	SkeletalMeshChangeHandle = SkeletalMesh->GetOnMeshChanged().AddLambda([this]() { WaitForFullBuild(); BuildFur(BuildType::Full); });
 	if (FurSplinesAssigned)
 	{
-		FurSplinesChangeHandle = FurSplinesAssigned->OnSplinesChanged.AddLambda([this]() { BuildFur(BuildType::Splines); });
-		FurSplinesCombHandle = FurSplinesAssigned->OnSplinesCombed.AddLambda([this](const TArray<uint32>& VertexSet) { BuildFur(VertexSet); });
+		FurSplinesChangeHandle = FurSplinesAssigned->OnSplinesChanged.AddLambda([this]() { WaitForFullBuild(); BuildFur(BuildType::Splines); });
+		FurSplinesCombHandle = FurSplinesAssigned->OnSplinesCombed.AddLambda([this](const TArray<uint32>& VertexSet) { ScheduleBuildFur(VertexSet); });
+		FurSplinesAddRemoveHandle = FurSplinesAssigned->OnSplinesAddedRemoved.AddLambda([this](const TArray<int32>& RemovedSplines, int32 AddedSplineCount) { WaitForFullBuild(); BuildFur(RemovedSplines, AddedSplineCount); });
 	}
 	else if (GuideMeshes.Num() > 0)
 	{
@@ -1138,6 +1019,7 @@ void FFurSkinData::Set(int32 InFurLayerCount, int32 InLod, class UGFurComponent*
 			if (GuideMesh)
 			{
 				auto Handle = GuideMesh->GetOnMeshChanged().AddLambda([this, InLod]() {
+					WaitForFullBuild();
 					if (FurSplinesGenerated)
 						FurSplinesGenerated->ConditionalBeginDestroy();
 					FurSplinesGenerated = NewObject<UFurSplines>();
@@ -1156,6 +1038,45 @@ void FFurSkinData::Set(int32 InFurLayerCount, int32 InLod, class UGFurComponent*
 #endif // WITH_EDITORONLY_DATA
 }
 
+bool FFurSkinData::GetPhysicsRegions(int32 InMaxRegions, TArray<int32>& OutBoneRegions, TArray<int32>& OutRegionBones)
+{
+	if (InMaxRegions <= 0 || FurBones.Num() <= InMaxRegions)
+		return false;
+
+	FScopeLock Lock(&PhysicsRegionsCS);
+	const FPhysicsRegions* Regions = PhysicsRegions.FindByPredicate([InMaxRegions](const FPhysicsRegions& Entry) { return Entry.MaxRegions == InMaxRegions; });
+	if (!Regions)
+		Regions = &BuildPhysicsRegions(InMaxRegions);
+	OutBoneRegions = Regions->BoneRegions;
+	OutRegionBones = Regions->RegionBones;
+	return true;
+}
+
+const FFurSkinData::FPhysicsRegions& FFurSkinData::BuildPhysicsRegions(int32 InMaxRegions)
+{
+	const auto& RefBasesInvMatrix = SkeletalMesh->GetRefBasesInvMatrix();
+	const int32 NumBones = FurBones.Num();
+	TArray<FVector3f> Positions;
+	TArray<float> Weights;
+	Positions.SetNumUninitialized(NumBones);
+	Weights.SetNumUninitialized(NumBones);
+	for (int32 Index = 0; Index < NumBones; Index++)
+	{
+		const FBoneIndexType BoneIndex = FurBones[Index];
+		Positions[Index] = RefBasesInvMatrix.IsValidIndex(BoneIndex) ? RefBasesInvMatrix[BoneIndex].Inverse().GetOrigin() : FVector3f::ZeroVector;
+		Weights[Index] = FurBoneWeights[BoneIndex];
+	}
+
+	FPhysicsRegions& Regions = PhysicsRegions.AddDefaulted_GetRef();
+	Regions.MaxRegions = InMaxRegions;
+	BuildFurPhysicsRegions(InMaxRegions, Positions, Weights, [this](int32 A, int32 B)
+	{
+		const float* Overlap = FurBoneOverlaps.Find(MakeBonePairKey(FurBones[A], FurBones[B]));
+		return Overlap ? *Overlap : 0.0f;
+	}, Regions.BoneRegions, Regions.RegionBones);
+	return Regions;
+}
+
 bool FFurSkinData::Compare(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent)
 {
 	return FFurData::Compare(InFurLayerCount, InLod, InFurComponent) && SkeletalMesh == InFurComponent->SkeletalGrowMesh && GuideMeshes == InFurComponent->SkeletalGuideMeshes;
@@ -1168,6 +1089,9 @@ bool FFurSkinData::Similar(int32 InLod, class UGFurComponent* InFurComponent)
 
 void FFurSkinData::BuildFur(BuildType Build)
 {
+	// the whole buffer is rebuilt from the current splines, a running rebuild of combed vertices is obsolete
+	WaitForBuildFur(true);
+
 	auto* SkeletalMeshResource = SkeletalMesh->GetResourceForRendering();
 	check(SkeletalMeshResource);
 
@@ -1225,8 +1149,7 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 
 	uint32 NewVertexCount = VertexCountPerLayer * FurLayerCount;
 
-	while (RenderThreadDataSubmissionPending)
-		;
+	WaitForRenderThreadDataSubmission();
 
 	TArray<FSection>& LocalSections = Sections.Num() ? TempSections : Sections;
 	LocalSections.SetNum(LodRenderData.RenderSections.Num());
@@ -1240,6 +1163,35 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 	}
 	uint32 SectionVertexOffset = 0;
 	float MaxDistSq = 0.0f;
+	if (Build == BuildType::Full)
+	{
+		FurBoneWeights.Init(0.0f, SkeletalMesh->GetRefSkeleton().GetRawBoneNum());
+		FurBoneOverlaps.Reset();
+	}
+
+	// all sections share one bone buffer, vertices index the union of section bone maps
+	TArray<FBoneIndexType> NewLodBones;
+	for (const auto& SourceSection : LodRenderData.RenderSections)
+	{
+		for (FBoneIndexType BoneIndex : SourceSection.BoneMap)
+			NewLodBones.AddUnique(BoneIndex);
+	}
+	NewLodBones.Sort();
+
+	// the engine splits sections to stay in the bone limits, a union too large for them keeps the bone maps of sections
+	TArray<TArray<FBoneIndexType>> NewBoneMaps;
+	const bool ShareLodBones = NewLodBones.Num() <= MaxSharedLodBones;
+	if (ShareLodBones)
+	{
+		NewBoneMaps.Add(MoveTemp(NewLodBones));
+	}
+	else
+	{
+		for (const auto& SourceSection : LodRenderData.RenderSections)
+			NewBoneMaps.Add(SourceSection.BoneMap);
+	}
+
+	TArray<FBoneIndexType> SectionToLod;
 	for (int32 SectionIndex = 0; SectionIndex < LodRenderData.RenderSections.Num(); SectionIndex++)
 	{
 		const auto& SourceSection = LodRenderData.RenderSections[SectionIndex];
@@ -1259,20 +1211,64 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 					if (Vertices[VertexIndex].InfluenceWeights[b] == 0)
 						break;
 					uint32 BoneIndex = SourceSection.BoneMap[Vertices[VertexIndex].InfluenceBones[b]];
+					float Weight = Vertices[VertexIndex].InfluenceWeights[b];
+					FurBoneWeights[BoneIndex] += Weight;
+					for (uint32 b2 = 0; b2 < b; b2++)
+					{
+						float SharedWeight = FMath::Min(Weight, (float)Vertices[VertexIndex].InfluenceWeights[b2]);
+						FurBoneOverlaps.FindOrAdd(MakeBonePairKey(BoneIndex, SourceSection.BoneMap[Vertices[VertexIndex].InfluenceBones[b2]])) += SharedWeight;
+					}
 					float distSq = FVector::DistSquared(FVector(Vertices[VertexIndex].Position), RefPose[BoneIndex].GetTranslation());
 					if (distSq > MaxDistSq)
 						MaxDistSq = distSq;
 				}
 			}
 		}
+
+		if (ShareLodBones)
+		{
+			SectionToLod.SetNumUninitialized(SourceSection.BoneMap.Num());
+			for (int32 b = 0; b < SourceSection.BoneMap.Num(); b++)
+				SectionToLod[b] = Algo::BinarySearch(NewBoneMaps[0], SourceSection.BoneMap[b]);
+			for (uint32 i = 0, Count = VertCount * FurLayerCount; i < Count; i++)
+			{
+				VertexType& Vertex = Vertices[SectionVertexOffset + i];
+				for (uint32 b = 0; b < VertexType::NumInfluences; b++)
+				{
+					if (Vertex.InfluenceBones[b] < SectionToLod.Num())
+						Vertex.InfluenceBones[b] = SectionToLod[Vertex.InfluenceBones[b]];
+				}
+			}
+		}
 		SectionVertexOffset += VertCount * FurLayerCount;
 
 		FurSection.MaxVertexIndex = SectionVertexOffset - 1;
 	}
 	VertexBuffer.Unlock();
+	if (NewBoneMaps != BoneMaps)
+	{
+		BoneMaps = NewBoneMaps;
+		ENQUEUE_RENDER_COMMAND(UpdateLodBonesCommand)([this, NewBoneMaps = MoveTemp(NewBoneMaps)](FRHICommandListImmediate& RHICmdList) {
+			BoneMaps_RenderThread = NewBoneMaps;
+		});
+	}
 	if (Build == BuildType::Full)
+	{
 		MaxVertexBoneDistance = sqrtf(MaxDistSq);
 
+		FurBones.Reset();
+		for (int32 BoneIndex = 0; BoneIndex < FurBoneWeights.Num(); BoneIndex++)
+		{
+			if (FurBoneWeights[BoneIndex] > 0.0f)
+				FurBones.Add(BoneIndex);
+		}
+
+		FScopeLock Lock(&PhysicsRegionsCS);
+		PhysicsRegions.Reset();
+		if (MaxPhysicsRegions > 0 && FurBones.Num() > MaxPhysicsRegions)
+			BuildPhysicsRegions(MaxPhysicsRegions);
+	}
+
 	if (Build >= BuildType::Splines || FurLayerCount != OldFurLayerCount || RemoveFacesWithoutSplines != OldRemoveFacesWithoutSplines)
 	{
 		OldFurLayerCount = FurLayerCount;
@@ -1321,7 +1317,7 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 				}
 			}
 			FurSection.NumTriangles = (Idx - FurSection.BaseIndex) / 3;
-			FurSection.NumBones = SourceSection.BoneMap.Num();
+			FurSection.NumBones = BoneMaps[GetBoneMapIndex(BoneMaps, SectionIndex)].Num();
 		}
 		check(Idx <= (uint32)Indices.Num());
 		Indices.RemoveAt(Idx, Indices.Num() - Idx, false);
@@ -1340,10 +1336,7 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 		}
 	}
 
-	RenderThreadDataSubmissionPending = true;
-	ENQUEUE_RENDER_COMMAND(UpdateDataCommand)([this](FRHICommandListImmediate& RHICmdList) {
-		RenderThreadDataSubmissionPending = false;
-	});
+	SubmitRenderThreadData();
 
 #if !WITH_EDITORONLY_DATA
 	Normals.SetNum(0, true);
@@ -1352,44 +1345,50 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 #endif // WITH_EDITORONLY_DATA
 }
 
-void FFurSkinData::BuildFur(const TArray<uint32>& InVertexSet)
+void FFurSkinData::BuildFur(const TArray<int32>& InRemovedSplines, int32 InAddedSplineCount)
+{
+	TArray<uint32> AffectedVertices;
+	if (!UpdateSplineMap(SkeletalMesh->GetResourceForRendering()->LODRenderData[Lod].StaticVertexBuffers.PositionVertexBuffer, InRemovedSplines, InAddedSplineCount, AffectedVertices))
+		BuildFur(BuildType::Splines);
+	else if (AffectedVertices.Num())
+		ScheduleBuildFur(AffectedVertices);
+}
+
+void FFurSkinData::BuildFur(const FCombedVertices& InCombed)
 {
 	auto* SkeletalMeshResource = SkeletalMesh->GetResourceForRendering();
 	check(SkeletalMeshResource);
 
 	const FSkeletalMeshLODRenderData& LodRenderData = SkeletalMeshResource->LODRenderData[Lod];
 	if (LodRenderData.StaticVertexBuffers.StaticMeshVertexBuffer.GetUseHighPrecisionTangentBasis())
-		BuildFur<EStaticMeshVertexTangentBasisType::HighPrecision>(LodRenderData, InVertexSet);
+		BuildFur<EStaticMeshVertexTangentBasisType::HighPrecision>(LodRenderData, InCombed);
 	else
-		BuildFur<EStaticMeshVertexTangentBasisType::Default>(LodRenderData, InVertexSet);
+		BuildFur<EStaticMeshVertexTangentBasisType::Default>(LodRenderData, InCombed);
 }
 
 template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
-inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const TArray<uint32>& InVertexSet)
+inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const FCombedVertices& InCombed)
 {
 	if (LodRenderData.StaticVertexBuffers.StaticMeshVertexBuffer.GetUseFullPrecisionUVs())
-		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::HighPrecision>(LodRenderData, InVertexSet);
+		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::HighPrecision>(LodRenderData, InCombed);
 	else
-		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::Default>(LodRenderData, InVertexSet);
+		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::Default>(LodRenderData, InCombed);
 }
 
 template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT>
-inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const TArray<uint32>& InVertexSet)
+inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const FCombedVertices& InCombed)
 {
 	if (LodRenderData.SkinWeightVertexBuffer.GetMaxBoneInfluences() > 4)
-		BuildFur<TangentBasisTypeT, UVTypeT, true>(LodRenderData, InVertexSet);
+		BuildFur<TangentBasisTypeT, UVTypeT, true>(LodRenderData, InCombed);
 	else
-		BuildFur<TangentBasisTypeT, UVTypeT, false>(LodRenderData, InVertexSet);
+		BuildFur<TangentBasisTypeT, UVTypeT, false>(LodRenderData, InCombed);
 }
 
 template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT, bool bExtraBoneInfluencesT>
-inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const TArray<uint32>& InVertexSet)
+inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const FCombedVertices& InCombed)
 {
 	typedef FFurSkinVertex<TangentBasisTypeT, UVTypeT, bExtraBoneInfluencesT> VertexType;
 
-	while (RenderThreadDataSubmissionPending)
-		;
-
 	const auto& SrcSections = LodRenderData.RenderSections;
 	uint32 SectionIndex = 0;
 	uint32 SectionCount = SrcSections.Num();
@@ -1400,16 +1399,14 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 	uint32 DstSectionVertexBegin = LocalSections[SectionIndex].MinVertexIndex;
 	uint32 DstSectionVertexCountPerLayer = (LocalSections[SectionIndex].MaxVertexIndex + 1 - DstSectionVertexBegin) / FurLayerCount;
 
-	TArray<float> FurLengths;
-	GenerateFurLengths(FurLengths);
-
 	VertexType* Vertices = VertexBuffer.Lock<VertexType>(VertexCountPerLayer * FurLayerCount);
 	bool UseRemap = VertexRemap.Num() > 0;
 	for (int32 Layer = 0; Layer < FurLayerCount; Layer++)
 	{
 		auto GenLayerData = CalcFurGenLayerData(FurLayerCount - Layer);
-		for (uint32 SrcVertexIndex : InVertexSet)
+		for (int32 CombedIndex = 0; CombedIndex < InCombed.Vertices.Num(); CombedIndex++)
 		{
+			uint32 SrcVertexIndex = InCombed.Vertices[CombedIndex];
 			uint32 checkCounter = 0;
 			while (SrcVertexIndex < SectionVertexIndexBegin || SrcVertexIndex >= SectionVertexIndexEnd)
 			{
@@ -1424,11 +1421,12 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 			DstVertexIndex += DstSectionVertexCountPerLayer * Layer + DstSectionVertexBegin;
 			VertexType& Vertex = Vertices[DstVertexIndex];
 
-			if (FurSplinesUsed)
+			if (InCombed.VertexSplines.Num())
 			{
-				int32 SplineIndex = SplineMap[SrcVertexIndex];
-				float Length = SplineIndex >= 0 ? FurLengths[SplineIndex] : FurLength;
-				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, SplineIndex);
+				int32 Slot = InCombed.VertexSplines[CombedIndex];
+				float Length = Slot >= 0 ? InCombed.Lengths[Slot] : FurLength;
+				const FVector* ControlPoints = Slot >= 0 ? &InCombed.ControlPoints[Slot * FurSplinesUsed->ControlPointCount] : nullptr;
+				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, ControlPoints);
 			}
 			else
 			{
@@ -1436,13 +1434,6 @@ inline void FFurSkinData::BuildFur(const FSkeletalMeshLODRenderData& LodRenderDa
 			}
 		}
 	}
-
-	VertexBuffer.Unlock();
-
-	RenderThreadDataSubmissionPending = true;
-	ENQUEUE_RENDER_COMMAND(UpdateDataCommand)([this](FRHICommandListImmediate& RHICmdList) {
-		RenderThreadDataSubmissionPending = false;
-	});
 }
 
 /** Generate Splines */
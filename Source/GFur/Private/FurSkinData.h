@@ -4,6 +4,7 @@
 
 #include "Runtime/Engine/Classes/Engine/SkeletalMesh.h"
 #include "GPUSkinPublicDefs.h"
+#include "Runtime/Engine/Public/GPUSkinVertexFactory.h"
 #include "FurData.h"
 
 
@@ -20,23 +21,126 @@ struct FFurSkinVertex : FFurStaticVertex<TangentBasisTypeT, UVTypeT>
 	uint16			InfluenceWeights[NumInfluences];
 };
 
+/**
+ * Bone matrices and fur offsets of one fur LOD, shared by vertex factories of all its sections and uploaded once per frame.
+ * Vertices index bones through the LOD bone map of FFurSkinData, union of bone maps of all sections. LODs whose union
+ * doesn't fit the bone limits have one bone data per section instead.
+ * Uploads are skipped while the bone data revision of the component stays the same, previous frame data then reads
+ * the current buffer so that the velocity stays zero.
+ */
+class FFurSkinBoneData
+{
+public:
+	FFurSkinBoneData(uint32 InNumBones, ERHIFeatureLevel::Type InFeatureLevel)
+		: NumBones(InNumBones)
+		, FeatureLevel(InFeatureLevel)
+	{
+	}
+
+	/** Called by every vertex factory sharing the data, the first one creates the resources and the last one releases them. */
+	void InitRHI(FRHICommandListBase& RHICmdList);
+	void ReleaseRHI();
+
+	void Update(FRHICommandListBase& RHICmdList, const TArray<FMatrix>& ReferenceToLocalMatrices, const TArray<FVector3f>& LinearOffsets,
+		const TArray<FVector3f>& AngularOffsets, const TArray<FVector3f>& BonePositions, const TArray<FBoneIndexType>& BoneMap, uint32 Revision, bool InDiscontinuous);
+
+	// if FeatureLevel < ERHIFeatureLevel::ES3_1
+	FUniformBufferRHIRef GetUniformBuffer() const { return UniformBuffer; }
+
+	// @param bPrevious true:previous, false:current
+	const FVertexBufferAndSRV& GetBoneBufferForReading(bool bPrevious) const { return GetBufferForReading(BoneBuffer, bPrevious); }
+	const FVertexBufferAndSRV& GetBoneFurOffsetsBufferForReading(bool bPrevious) const { return GetBufferForReading(BoneFurOffsetsBuffer, bPrevious); }
+
+private:
+	// double buffered bone positions+orientations to support normal rendering and velocity (new-old position) rendering
+	FVertexBufferAndSRV BoneBuffer[2];
+	FVertexBufferAndSRV BoneFurOffsetsBuffer[2];
+	// 0 / 1 to index into BoneBuffer
+	uint32 CurrentBuffer = 0;
+	// number of bones the buffers are allocated for
+	uint32 NumBones;
+	// if FeatureLevel < ERHIFeatureLevel::ES3_1, created once and updated in place from UniformData
+	FUniformBufferRHIRef UniformBuffer;
+	TArray<uint8, TAlignedHeapAllocator<16>> UniformData;
+	ERHIFeatureLevel::Type FeatureLevel;
+	bool Discontinuous = true;
+	// revision and bone count of the data in the current buffer
+	uint32 UploadedRevision = 0;
+	uint32 UploadedNumBones = 0;
+	bool UploadedRevisionValid = false;
+	// set while the data didn't change since the last upload, previous frame reads the current buffer
+	bool Unchanged = false;
+
+	// number of vertex factories with initialized RHI resources using the data
+	int32 NumInitializedUsers = 0;
+
+	void InitResources(FRHICommandListBase& RHICmdList);
+	void ReleaseResources();
+	void CreateBuffers(FRHICommandListBase& RHICmdList, bool bPrevious);
+	const FVertexBufferAndSRV& GetBufferForReading(const FVertexBufferAndSRV (&Buffers)[2], bool bPrevious) const;
+};
+
 /** Fur Skin Data */
 class FFurSkinData: public FFurData
 {
 public:
 	static FFurSkinData* CreateFurData(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent);
+	/**
+	 * Like CreateFurData, but new fur data is built in a task. Until the build is done, fur data of the same mesh, LOD and
+	 * splines is returned instead and OutPending references the data being built, it's released with DestroyFurData.
+	 */
+	static FFurSkinData* CreateFurDataAsync(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent, FFurData*& OutPending);
 	static void DestroyFurData(const TArray<FFurData*>& InFurDataArray);
 
 	virtual void CreateVertexFactories(TArray<FFurVertexFactory*>& VertexFactories, FVertexBuffer* InMorphVertexBuffer, bool InPhysics, ERHIFeatureLevel::Type InFeatureLevel) override;
 
+	/**
+	 * Bone maps of the bone data of the LOD, fur vertices index bones through them. A single sorted union of bone maps of all
+	 * sections when it fits the bone limits, otherwise the bone map of every section.
+	 */
+	const TArray<TArray<FBoneIndexType>>& GetBoneMaps_RenderThread() const { return BoneMaps_RenderThread; }
+	/** Index of the bone map used by a section. */
+	static int32 GetBoneMapIndex(const TArray<TArray<FBoneIndexType>>& InBoneMaps, int32 InSectionIndex) { return InBoneMaps.Num() == 1 ? 0 : InSectionIndex; }
+
+	/** Sorted skeleton indices of bones weighting at least one fur vertex. */
+	const TArray<FBoneIndexType>& GetFurBones() const { return FurBones; }
+	/** Sum of skin weights of every skeleton bone over fur vertices. */
+	const TArray<float>& GetFurBoneWeights() const { return FurBoneWeights; }
+	/** Skin weights shared by two skeleton bones over fur vertices, keyed by MakeBonePairKey. */
+	const TMap<uint32, float>& GetFurBoneOverlaps() const { return FurBoneOverlaps; }
+	static uint32 MakeBonePairKey(FBoneIndexType A, FBoneIndexType B) { return A < B ? (uint32(A) << 16) | B : (uint32(B) << 16) | A; }
+
+	/**
+	 * Physics regions grouping GetFurBones() into at most InMaxRegions regions, see BuildFurPhysicsRegions. Regions are built
+	 * with the fur for MaxPhysicsRegions of the component which created the data and cached for other values on first use.
+	 * Returns false if the bones don't need grouping.
+	 */
+	bool GetPhysicsRegions(int32 InMaxRegions, TArray<int32>& OutBoneRegions, TArray<int32>& OutRegionBones);
+
 protected:
+	struct FPhysicsRegions
+	{
+		int32 MaxRegions;
+		TArray<int32> BoneRegions;
+		TArray<int32> RegionBones;
+	};
+
 	USkeletalMesh* SkeletalMesh = nullptr;
+	TArray<FBoneIndexType> FurBones;
+	TArray<TArray<FBoneIndexType>> BoneMaps;
+	TArray<TArray<FBoneIndexType>> BoneMaps_RenderThread;
+	TArray<float> FurBoneWeights;
+	TMap<uint32, float> FurBoneOverlaps;
+	int32 MaxPhysicsRegions = 0;
+	TArray<FPhysicsRegions> PhysicsRegions;
+	FCriticalSection PhysicsRegionsCS;
 	TArray<USkeletalMesh*> GuideMeshes;
 	bool HasExtraBoneInfluences;
 
 #if WITH_EDITORONLY_DATA
 	FDelegateHandle FurSplinesChangeHandle;
 	FDelegateHandle FurSplinesCombHandle;
+	FDelegateHandle FurSplinesAddRemoveHandle;
 	FDelegateHandle SkeletalMeshChangeHandle;
 	TArray<FDelegateHandle> GuideMeshesChangeHandles;
 #endif // WITH_EDITORONLY_DATA
@@ -45,12 +149,14 @@ protected:
 	~FFurSkinData();
 
 	void UnbindChangeDelegates();
+	const FPhysicsRegions& BuildPhysicsRegions(int32 InMaxRegions);
 	void Set(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent);
 
 	bool Compare(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent);
 	bool Similar(int32 InLod, class UGFurComponent* InFurComponent);
 
 	void BuildFur(BuildType Build);
+	void BuildFur(const TArray<int32>& InRemovedSplines, int32 InAddedSplineCount);
 
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
 	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, BuildType Build);
@@ -59,13 +165,13 @@ protected:
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT, bool bExtraBoneInfluencesT>
 	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, BuildType Build);
 
-	void BuildFur(const TArray<uint32>& InVertexSet);
+	virtual void BuildFur(const FCombedVertices& InCombed) override;
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
-	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const TArray<uint32>& InVertexSet);
+	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const FCombedVertices& InCombed);
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT>
-	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const TArray<uint32>& InVertexSet);
+	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const FCombedVertices& InCombed);
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT, bool bExtraBoneInfluencesT>
-	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const TArray<uint32>& InVertexSet);
+	void BuildFur(const FSkeletalMeshLODRenderData& LodRenderData, const FCombedVertices& InCombed);
 };
 
 /** Generate Splines */
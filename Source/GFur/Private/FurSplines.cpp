@@ -58,7 +58,10 @@ void UFurSplines::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedE
 void UFurSplines::PostEditUndo()
 {
 	Super::PostEditUndo();
-	OnSplinesChanged.Broadcast();
+	const bool CombUndoRebuiltFur = CombUndoFrame == GFrameCounter;
+	CombUndoFrame = 0;
+	if (!CombUndoRebuiltFur)
+		OnSplinesChanged.Broadcast();
 }
 #endif // WITH_EDITOR
 
@@ -344,6 +344,7 @@ FFurStaticData* FFurStaticData::CreateFurData(int32 InFurLayerCount, int32 InLod
 	{
 		if (Data->Compare(InFurLayerCount, InLod, InFurComponent))
 		{
+			Data->WaitForFullBuild();
 			Data->RefCount++;
 			return Data;
 		}
@@ -366,6 +367,52 @@ FFurStaticData* FFurStaticData::CreateFurData(int32 InFurLayerCount, int32 InLod
 	return Data;
 }
 
+FFurStaticData* FFurStaticData::CreateFurDataAsync(int32 InFurLayerCount, int32 InLod, UGFurComponent* InFurComponent, FFurData*& OutPending)
+{
+	check(InFurLayerCount >= MinimalFurLayerCount && InFurLayerCount <= MaximalFurLayerCount);
+
+	FScopeLock lock(&FurStaticDataCS);
+
+	OutPending = nullptr;
+	FFurStaticData* Pending = nullptr;
+	for (FFurStaticData* Data : FurStaticData)
+	{
+		if (Data->Compare(InFurLayerCount, InLod, InFurComponent))
+		{
+			Data->RefCount++;
+			if (Data->IsBuilt())
+				return Data;
+			Pending = Data;
+			break;
+		}
+	}
+
+	if (!Pending)
+	{
+		Pending = new FFurStaticData();
+		Pending->Set(InFurLayerCount, InLod, InFurComponent);
+		Pending->FullBuildEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Pending]()
+		{
+			Pending->BuildFur(BuildType::Full);
+		}, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask);
+		FurStaticData.Add(Pending);
+	}
+
+	// built fur of the same mesh is shown until the new one is done
+	for (FFurStaticData* Data : FurStaticData)
+	{
+		if (Data != Pending && Data->IsBuilt() && Data->Similar(InLod, InFurComponent))
+		{
+			Data->RefCount++;
+			OutPending = Pending;
+			return Data;
+		}
+	}
+
+	Pending->WaitForFullBuild();
+	return Pending;
+}
+
 void FFurStaticData::DestroyFurData(const TArray<FFurData*>& InFurDataArray)
 {
 	FScopeLock lock(&FurStaticDataCS);
@@ -428,6 +475,10 @@ void FFurStaticData::CreateVertexFactories(TArray<FFurVertexFactory*>& VertexFac
 
 FFurStaticData::~FFurStaticData()
 {
+	// the rebuild task of combed vertices and the full build task call back into this object
+	WaitForFullBuild();
+	WaitForBuildFur(true);
+
 	UnbindChangeDelegates();
 
 #if WITH_EDITORONLY_DATA
@@ -451,6 +502,11 @@ void FFurStaticData::UnbindChangeDelegates()
 		FurSplinesAssigned->OnSplinesCombed.Remove(FurSplinesCombHandle);
 		FurSplinesCombHandle.Reset();
 	}
+	if (FurSplinesAddRemoveHandle.IsValid())
+	{
+		FurSplinesAssigned->OnSplinesAddedRemoved.Remove(FurSplinesAddRemoveHandle);
+		FurSplinesAddRemoveHandle.Reset();
+	}
 	if (StaticMeshChangeHandle.IsValid())
 	{
 		StaticMesh->OnMeshChanged.Remove(StaticMeshChangeHandle);
@@ -495,11 +551,12 @@ void FFurStaticData::Set(int32 InFurLayerCount, int32 InLod, class UGFurComponen
 		FurSplinesUsed = FurSplinesGenerated;
 	}
 #if WITH_EDITORONLY_DATA
-	StaticMeshChangeHandle = StaticMesh->OnMeshChanged.AddLambda([this]() { BuildFur(BuildType::Full); });
+	StaticMeshChangeHandle = StaticMesh->OnMeshChanged.AddLambda([this]() { WaitForFullBuild(); BuildFur(BuildType::Full); });
 	if (FurSplinesAssigned)
 	{
-		FurSplinesChangeHandle = FurSplinesAssigned->OnSplinesChanged.AddLambda([this]() { BuildFur(BuildType::Splines); });
-		FurSplinesCombHandle = FurSplinesAssigned->OnSplinesCombed.AddLambda([this](const TArray<uint32>& VertexSet) { BuildFur(VertexSet); });
+		FurSplinesChangeHandle = FurSplinesAssigned->OnSplinesChanged.AddLambda([this]() { WaitForFullBuild(); BuildFur(BuildType::Splines); });
+		FurSplinesCombHandle = FurSplinesAssigned->OnSplinesCombed.AddLambda([this](const TArray<uint32>& VertexSet) { ScheduleBuildFur(VertexSet); });
+		FurSplinesAddRemoveHandle = FurSplinesAssigned->OnSplinesAddedRemoved.AddLambda([this](const TArray<int32>& RemovedSplines, int32 AddedSplineCount) { WaitForFullBuild(); BuildFur(RemovedSplines, AddedSplineCount); });
 	}
 	else if (GuideMeshes.Num() > 0)
 	{
@@ -508,6 +565,7 @@ void FFurStaticData::Set(int32 InFurLayerCount, int32 InLod, class UGFurComponen
 			if (GuideMesh)
 			{
 				auto Handle = GuideMesh->OnMeshChanged.AddLambda([this, InLod]() {
+					WaitForFullBuild();
 					if (FurSplinesGenerated)
 						FurSplinesGenerated->ConditionalBeginDestroy();
 					FurSplinesGenerated = NewObject<UFurSplines>();
@@ -538,6 +596,9 @@ bool FFurStaticData::Similar(int32 InLod, class UGFurComponent* InFurComponent)
 
 void FFurStaticData::BuildFur(BuildType Build)
 {
+	// the whole buffer is rebuilt from the current splines, a running rebuild of combed vertices is obsolete
+	WaitForBuildFur(true);
+
 	auto* StaticMeshResource = StaticMesh->GetRenderData();
 	check(StaticMeshResource);
 
@@ -586,8 +647,7 @@ inline void FFurStaticData::BuildFur(const FStaticMeshLODResources& LodRenderDat
 
 	FFurStaticVertexBlitter<TangentBasisTypeT, UVTypeT> VertexBlitter(SourcePositions, SourceVertices, SourceColors);
 
-	while (RenderThreadDataSubmissionPending)
-		;
+	WaitForRenderThreadDataSubmission();
 
 	VertexType* Vertices = VertexBuffer.Lock<VertexType>(NewVertexCount);
 	{
@@ -679,10 +739,7 @@ inline void FFurStaticData::BuildFur(const FStaticMeshLODResources& LodRenderDat
 		IndexBuffer.Unlock();
 	}
 
-	RenderThreadDataSubmissionPending = true;
-	ENQUEUE_RENDER_COMMAND(UpdateDataCommand)([this](FRHICommandListImmediate& RHICmdList) {
-		RenderThreadDataSubmissionPending = false;
-	});
+	SubmitRenderThreadData();
 
 #if !WITH_EDITORONLY_DATA
 	Normals.SetNum(0, true);
@@ -691,52 +748,57 @@ inline void FFurStaticData::BuildFur(const FStaticMeshLODResources& LodRenderDat
 #endif // WITH_EDITORONLY_DATA
 }
 
-void FFurStaticData::BuildFur(const TArray<uint32>& InVertexSet)
+void FFurStaticData::BuildFur(const TArray<int32>& InRemovedSplines, int32 InAddedSplineCount)
+{
+	TArray<uint32> AffectedVertices;
+	if (!UpdateSplineMap(StaticMesh->GetRenderData()->LODResources[Lod].VertexBuffers.PositionVertexBuffer, InRemovedSplines, InAddedSplineCount, AffectedVertices))
+		BuildFur(BuildType::Splines);
+	else if (AffectedVertices.Num())
+		ScheduleBuildFur(AffectedVertices);
+}
+
+void FFurStaticData::BuildFur(const FCombedVertices& InCombed)
 {
 	auto* StaticMeshResource = StaticMesh->GetRenderData();
 	check(StaticMeshResource);
 
 	const FStaticMeshLODResources& LodRenderData = StaticMeshResource->LODResources[Lod];
 	if (LodRenderData.VertexBuffers.StaticMeshVertexBuffer.GetUseHighPrecisionTangentBasis())
-		BuildFur<EStaticMeshVertexTangentBasisType::HighPrecision>(LodRenderData, InVertexSet);
+		BuildFur<EStaticMeshVertexTangentBasisType::HighPrecision>(LodRenderData, InCombed);
 	else
-		BuildFur<EStaticMeshVertexTangentBasisType::Default>(LodRenderData, InVertexSet);
+		BuildFur<EStaticMeshVertexTangentBasisType::Default>(LodRenderData, InCombed);
 }
 
 template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
-void FFurStaticData::BuildFur(const FStaticMeshLODResources& LodRenderData, const TArray<uint32>& InVertexSet)
+void FFurStaticData::BuildFur(const FStaticMeshLODResources& LodRenderData, const FCombedVertices& InCombed)
 {
 	if (LodRenderData.VertexBuffers.StaticMeshVertexBuffer.GetUseFullPrecisionUVs())
-		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::HighPrecision>(InVertexSet);
+		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::HighPrecision>(InCombed);
 	else
-		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::Default>(InVertexSet);
+		BuildFur<TangentBasisTypeT, EStaticMeshVertexUVType::Default>(InCombed);
 }
 
 template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT>
-void FFurStaticData::BuildFur(const TArray<uint32>& InVertexSet)
+void FFurStaticData::BuildFur(const FCombedVertices& InCombed)
 {
 	typedef FFurStaticVertex<TangentBasisTypeT, UVTypeT> VertexType;
 
-	while (RenderThreadDataSubmissionPending)
-		;
-
-	TArray<float> FurLengths;
-	GenerateFurLengths(FurLengths);
-
 	VertexType* Vertices = VertexBuffer.Lock<VertexType>(VertexCountPerLayer * FurLayerCount);
 	bool UseRemap = VertexRemap.Num() > 0;
 	for (int32 Layer = 0; Layer < FurLayerCount; Layer++)
 	{
 		auto GenLayerData = CalcFurGenLayerData(FurLayerCount - Layer);
-		for (uint32 SrcVertexIndex : InVertexSet)
+		for (int32 CombedIndex = 0; CombedIndex < InCombed.Vertices.Num(); CombedIndex++)
 		{
+			uint32 SrcVertexIndex = InCombed.Vertices[CombedIndex];
 			VertexType& Vertex = Vertices[(UseRemap ? VertexRemap[SrcVertexIndex] : SrcVertexIndex) + Layer * VertexCountPerLayer];
 
-			if (FurSplinesUsed)
+			if (InCombed.VertexSplines.Num())
 			{
-				int32 SplineIndex = SplineMap[SrcVertexIndex];
-				float Length = SplineIndex >= 0 ? FurLengths[SplineIndex] : FurLength;
-				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, SplineIndex);
+				int32 Slot = InCombed.VertexSplines[CombedIndex];
+				float Length = Slot >= 0 ? InCombed.Lengths[Slot] : FurLength;
+				const FVector* ControlPoints = Slot >= 0 ? &InCombed.ControlPoints[Slot * FurSplinesUsed->ControlPointCount] : nullptr;
+				GenerateFurVertex(Vertex.FurOffset, Vertex.UV1, Vertex.UV2, Vertex.UV3, FVector3f(Normals[SrcVertexIndex]), Length, GenLayerData, ControlPoints);
 			}
 			else
 			{
@@ -744,13 +806,6 @@ void FFurStaticData::BuildFur(const TArray<uint32>& InVertexSet)
 			}
 		}
 	}
-
-	VertexBuffer.Unlock();
-
-	RenderThreadDataSubmissionPending = true;
-	ENQUEUE_RENDER_COMMAND(UpdateDataCommand)([this](FRHICommandListImmediate& RHICmdList) {
-		RenderThreadDataSubmissionPending = false;
-	});
 }
 
 /** Generate Splines */
@@ -10,6 +10,11 @@ class FFurStaticData: public FFurData
 {
 public:
 	static FFurStaticData* CreateFurData(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent);
+	/**
+	 * Like CreateFurData, but new fur data is built in a task. Until the build is done, fur data of the same mesh, LOD and
+	 * splines is returned instead and OutPending references the data being built, it's released with DestroyFurData.
+	 */
+	static FFurStaticData* CreateFurDataAsync(int32 InFurLayerCount, int32 InLod, class UGFurComponent* InFurComponent, FFurData*& OutPending);
 	static void DestroyFurData(const TArray<FFurData*>& InFurDataArray);
 
 	virtual void CreateVertexFactories(TArray<FFurVertexFactory*>& VertexFactories, FVertexBuffer* InMorphVertexBuffer, bool InPhysics, ERHIFeatureLevel::Type InFeatureLevel) override;
@@ -20,6 +25,7 @@ protected:
 #if WITH_EDITORONLY_DATA
 	FDelegateHandle FurSplinesChangeHandle;
 	FDelegateHandle FurSplinesCombHandle;
+	FDelegateHandle FurSplinesAddRemoveHandle;
 	FDelegateHandle StaticMeshChangeHandle;
 	TArray<FDelegateHandle> GuideMeshesChangeHandles;
 #endif // WITH_EDITORONLY_DATA
@@ -37,17 +43,18 @@ protected:
 	bool Similar(int32 InLod, class UGFurComponent* InFurComponent);
 
 	void BuildFur(BuildType Build);
+	void BuildFur(const TArray<int32>& InRemovedSplines, int32 InAddedSplineCount);
 
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
 	void BuildFur(const FStaticMeshLODResources& LodRenderData, BuildType Build);
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT>
 	void BuildFur(const FStaticMeshLODResources& LodRenderData, BuildType Build);
 
-	void BuildFur(const TArray<uint32>& InVertexSet);
+	virtual void BuildFur(const FCombedVertices& InCombed) override;
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT>
-	void BuildFur(const FStaticMeshLODResources& LodRenderData, const TArray<uint32>& InVertexSet);
+	void BuildFur(const FStaticMeshLODResources& LodRenderData, const FCombedVertices& InCombed);
 	template<EStaticMeshVertexTangentBasisType TangentBasisTypeT, EStaticMeshVertexUVType UVTypeT>
-	void BuildFur(const TArray<uint32>& InVertexSet);
+	void BuildFur(const FCombedVertices& InCombed);
 };
 
 /** Generate Splines */
@@ -0,0 +1,290 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurSubsystem.h"
+#include "FurComponent.h"
+#include "FurPhysics.h"
+#include "GFur.h"
+#include "Async/ParallelFor.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "SceneViewExtension.h"
+
+static TAutoConsoleVariable<int32> CVarFurAsyncPhysics(
+	TEXT("gFur.AsyncPhysics"),
+	1,
+	TEXT("Whether fur bones are gathered and simulated in task graph tasks overlapping the end of frame update of the game thread.\n")
+	TEXT(" 0: gather and simulate on the game thread\n")
+	TEXT(" 1: launch tasks, fur components join them when sending their render data (default)"));
+
+DECLARE_CYCLE_STAT(TEXT("Fur Physics Gather"), STAT_FurPhysicsGather, STATGROUP_GFur);
+DECLARE_CYCLE_STAT(TEXT("Fur Physics"), STAT_FurPhysics, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Fur Components"), STAT_FurSimulatedComponents, STATGROUP_GFur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Fur Bones"), STAT_FurSimulatedBones, STATGROUP_GFur);
+DECLARE_CYCLE_STAT(TEXT("Fur Render Update"), STAT_FurRenderUpdate, STATGROUP_GFur);
+
+// number of 4 element blocks integrated by one task
+static const int32 FurPhysicsBlocksPerTask = 32;
+
+struct FFurPhysicsTask
+{
+	FFurPhysicsState* State;
+	const FFurPhysicsParameters* Parameters;
+	int32 BeginBlock;
+	int32 EndBlock;
+};
+typedef TArray<FFurPhysicsTask, TInlineAllocator<256>> FFurPhysicsTasks;
+
+/** Splits integration of a state into tasks of FurPhysicsBlocksPerTask blocks. */
+static void AddPhysicsTasks(FFurPhysicsTasks& Tasks, FFurPhysicsState& State, const FFurPhysicsParameters& Parameters)
+{
+	for (int32 Block = 0; Block < State.NumBlocks(); Block += FurPhysicsBlocksPerTask)
+		Tasks.Add({ &State, &Parameters, Block, FMath::Min(Block + FurPhysicsBlocksPerTask, State.NumBlocks()) });
+}
+
+static void RunPhysicsTasks(const FFurPhysicsTasks& Tasks)
+{
+	ParallelFor(Tasks.Num(), [&Tasks](int32 TaskIndex)
+	{
+		const FFurPhysicsTask& Task = Tasks[TaskIndex];
+		Task.State->Integrate(*Task.Parameters, Task.BeginBlock, Task.EndBlock);
+	});
+}
+
+/** Submits render data of fur components once all end of frame updates of the world were sent. */
+class FFurSceneViewExtension : public FWorldSceneViewExtension
+{
+public:
+	FFurSceneViewExtension(const FAutoRegister& AutoRegister, UWorld* InWorld, UGFurSubsystem* InFurSubsystem)
+		: FWorldSceneViewExtension(AutoRegister, InWorld)
+		, FurSubsystem(InFurSubsystem)
+	{
+	}
+
+	virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override
+	{
+		if (UGFurSubsystem* Subsystem = FurSubsystem.Get())
+			Subsystem->FlushRenderUpdates();
+	}
+
+private:
+	TWeakObjectPtr<UGFurSubsystem> FurSubsystem;
+};
+
+void UGFurSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SceneViewExtension = FSceneViewExtensions::NewExtension<FFurSceneViewExtension>(GetWorld(), this);
+}
+
+void UGFurSubsystem::Deinitialize()
+{
+	for (UGFurComponent* FurComponent : FurComponents)
+		FurComponent->WaitForPhysics();
+	FurComponents.Reset();
+	FlushRenderUpdates();
+	SceneViewExtension.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UGFurSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE || WorldType == EWorldType::Editor
+		|| WorldType == EWorldType::EditorPreview || WorldType == EWorldType::GamePreview;
+}
+
+TStatId UGFurSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGFurSubsystem, STATGROUP_Tickables);
+}
+
+void UGFurSubsystem::Register(UGFurComponent* InFurComponent)
+{
+	FurComponents.AddUnique(InFurComponent);
+}
+
+void UGFurSubsystem::Unregister(UGFurComponent* InFurComponent)
+{
+	InFurComponent->WaitForPhysics();
+	FurComponents.RemoveSwap(InFurComponent);
+
+	// the component may be gone before the batch runs
+	FScopeLock Lock(&PendingRenderUpdatesCS);
+	const int32 PendingIndex = InFurComponent->PendingRenderUpdateIndex;
+	if (PendingIndex != INDEX_NONE)
+	{
+		InFurComponent->PendingRenderUpdateIndex = INDEX_NONE;
+		FFurDynamicDataRing::Release(PendingRenderUpdates[PendingIndex].DynamicData);
+		PendingRenderUpdates.RemoveAt(PendingIndex);
+		for (int32 Index = PendingIndex; Index < PendingRenderUpdates.Num(); Index++)
+			PendingRenderUpdates[Index].FurComponent->PendingRenderUpdateIndex = Index;
+	}
+}
+
+void UGFurSubsystem::SetSignificanceFunction(TFunction<float(const UGFurComponent*)> InSignificanceFunction)
+{
+	SignificanceFunction = MoveTemp(InSignificanceFunction);
+}
+
+float UGFurSubsystem::GetSignificance(const UGFurComponent* InFurComponent) const
+{
+	return SignificanceFunction ? SignificanceFunction(InFurComponent) : 1.0f;
+}
+
+void UGFurSubsystem::QueueRenderUpdate(FFurRenderUpdate&& InUpdate)
+{
+	FScopeLock Lock(&PendingRenderUpdatesCS);
+	// pending updates are flushed every frame, only the latest update of a component in a frame is submitted
+	UGFurComponent* FurComponent = InUpdate.FurComponent;
+	if (FurComponent->PendingRenderUpdateIndex != INDEX_NONE)
+	{
+		FFurRenderUpdate& PendingUpdate = PendingRenderUpdates[FurComponent->PendingRenderUpdateIndex];
+		FFurDynamicDataRing::Release(PendingUpdate.DynamicData);
+		PendingUpdate = MoveTemp(InUpdate);
+	}
+	else
+		FurComponent->PendingRenderUpdateIndex = PendingRenderUpdates.Add(MoveTemp(InUpdate));
+}
+
+void UGFurSubsystem::FlushRenderUpdates()
+{
+	FFurRenderUpdates Updates;
+	{
+		FScopeLock Lock(&PendingRenderUpdatesCS);
+		if (PendingRenderUpdates.Num() == 0)
+			return;
+		for (const FFurRenderUpdate& Update : PendingRenderUpdates)
+			Update.FurComponent->PendingRenderUpdateIndex = INDEX_NONE;
+		Updates = MoveTemp(PendingRenderUpdates);
+	}
+
+	// A master which recreated its render state since the update was queued handed its mesh object over to deferred cleanup,
+	// an object still current now is deleted only after the render command below ran.
+	for (FFurRenderUpdate& Update : Updates)
+	{
+		const USkinnedMeshComponent* MasterComp = Update.FurComponent->MasterPoseComponent.Get();
+		if (Update.MasterMeshObject && (!MasterComp || MasterComp->MeshObject != Update.MasterMeshObject))
+			Update.MasterMeshObject = nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_FurRenderCommands);
+	ENQUEUE_RENDER_COMMAND(FurUpdateDataCommand)(
+		[Updates = MoveTemp(Updates)](FRHICommandListImmediate& RHICmdList)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FurRenderUpdate);
+		for (const FFurRenderUpdate& Update : Updates)
+			Update.FurComponent->UpdateFur_RenderThread(RHICmdList, Update);
+	});
+}
+
+void UGFurSubsystem::Tick(float DeltaTime)
+{
+	// data of frames which weren't rendered is still submitted in order
+	FlushRenderUpdates();
+
+	if (CVarFurAsyncPhysics.GetValueOnGameThread() == 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FurPhysics);
+
+		TArray<UGFurComponent*, TInlineAllocator<64>> SimulatedComponents;
+		for (UGFurComponent* FurComponent : FurComponents)
+		{
+			if (!FurComponent->PhysicsPending)
+				continue;
+			FurComponent->BeginPhysics(GetSignificance(FurComponent));
+			if (FurComponent->GatherPhysics())
+				SimulatedComponents.Add(FurComponent);
+		}
+		SimulatePhysics(SimulatedComponents);
+		return;
+	}
+
+	TArray<UGFurComponent*> PendingComponents;
+	FGraphEventArray GatherEvents;
+	for (UGFurComponent* FurComponent : FurComponents)
+	{
+		if (!FurComponent->PhysicsPending)
+			continue;
+		FurComponent->PhysicsPending = false;
+		FurComponent->PhysicsGathered = false;
+		FurComponent->BeginPhysics(GetSignificance(FurComponent));
+
+		// Component space transforms of the master must be final before they are gathered. All tick groups are done by now,
+		// a parallel animation evaluation which is still running is waited for by the gather instead of the game thread.
+		FGraphEventArray GatherPrerequisites;
+		const USkeletalMeshComponent* MasterComp = Cast<USkeletalMeshComponent>(FurComponent->MasterPoseComponent.Get());
+		if (MasterComp && MasterComp->IsRunningParallelEvaluation())
+			GatherPrerequisites.Add(MasterComp->ParallelAnimationEvaluationTask);
+
+		GatherEvents.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([FurComponent]()
+		{
+			SCOPE_CYCLE_COUNTER(STAT_FurPhysicsGather);
+			FurComponent->PhysicsGathered = FurComponent->GatherPhysics();
+		}, TStatId(), &GatherPrerequisites, ENamedThreads::AnyHiPriThreadHiPriTask));
+		PendingComponents.Add(FurComponent);
+	}
+
+	if (PendingComponents.Num() == 0)
+	{
+		SET_DWORD_STAT(STAT_FurSimulatedComponents, 0);
+		SET_DWORD_STAT(STAT_FurSimulatedBones, 0);
+		return;
+	}
+
+	FGraphEventRef PhysicsEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([PendingComponents]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FurPhysics);
+
+		TArray<UGFurComponent*, TInlineAllocator<64>> SimulatedComponents;
+		for (UGFurComponent* FurComponent : PendingComponents)
+		{
+			if (FurComponent->PhysicsGathered)
+				SimulatedComponents.Add(FurComponent);
+		}
+		SimulatePhysics(SimulatedComponents);
+	}, TStatId(), &GatherEvents, ENamedThreads::AnyHiPriThreadHiPriTask);
+
+	// components join the task when they send their render data at the end of frame
+	for (UGFurComponent* FurComponent : PendingComponents)
+		FurComponent->PhysicsEvent = PhysicsEvent;
+}
+
+void UGFurSubsystem::SimulatePhysics(TArrayView<UGFurComponent* const> InComponents)
+{
+	FFurPhysicsTasks Tasks;
+	int32 NumSimulatedBones = 0;
+	for (UGFurComponent* FurComponent : InComponents)
+	{
+		NumSimulatedBones += FurComponent->PhysicsState.Num();
+		if (FurComponent->IntegratePhysics)
+			AddPhysicsTasks(Tasks, FurComponent->PhysicsState, FurComponent->PhysicsParameters);
+	}
+	RunPhysicsTasks(Tasks);
+
+	for (UGFurComponent* FurComponent : InComponents)
+		FurComponent->FinishPhysics();
+
+	SET_DWORD_STAT(STAT_FurSimulatedComponents, InComponents.Num());
+	SET_DWORD_STAT(STAT_FurSimulatedBones, NumSimulatedBones);
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+FGraphEventRef UGFurSubsystem::LaunchPhysicsForTest(TArrayView<FFurPhysicsState* const> InStates, TArrayView<const FFurPhysicsParameters> InParameters,
+	const FGraphEventArray& InPrerequisites)
+{
+	check(InStates.Num() == InParameters.Num());
+	TArray<TPair<FFurPhysicsState*, const FFurPhysicsParameters*>> States;
+	for (int32 Index = 0; Index < InStates.Num(); Index++)
+		States.Emplace(InStates[Index], &InParameters[Index]);
+
+	return FFunctionGraphTask::CreateAndDispatchWhenReady([States = MoveTemp(States)]()
+	{
+		FFurPhysicsTasks Tasks;
+		for (const TPair<FFurPhysicsState*, const FFurPhysicsParameters*>& State : States)
+			AddPhysicsTasks(Tasks, *State.Key, *State.Value);
+		RunPhysicsTasks(Tasks);
+	}, TStatId(), &InPrerequisites, ENamedThreads::AnyHiPriThreadHiPriTask);
+}
+#endif // WITH_DEV_AUTOMATION_TESTS
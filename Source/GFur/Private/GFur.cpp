@@ -7,6 +7,8 @@
 
 #define LOCTEXT_NAMESPACE "FGFurModule"
 
+DEFINE_STAT(STAT_FurRenderCommands);
+
 void FGFurModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -0,0 +1,127 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurSubsystem.h"
+#include "FurPhysics.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurAsyncPhysicsTest
+{
+	struct FBoneTransform
+	{
+		FVector3f Position;
+		FQuat4f Rotation;
+	};
+
+	FFurPhysicsParameters MakeParameters(FRandomStream& Random)
+	{
+		FFurPhysicsParameters Params;
+		const float Angle = Random.FRandRange(0.1f, 0.5f);
+		Params.ForceFactor = Random.FRandRange(0.2f, 1.0f);
+		Params.SinX = FMath::Sin(Angle);
+		Params.CosX = FMath::Cos(Angle);
+		Params.DampingFactor = Random.FRandRange(0.8f, 0.99f);
+		Params.MaxForce = Random.FRandRange(1.0f, 3.0f);
+		Params.MaxTorque = Random.FRandRange(0.3f, 1.0f);
+		Params.ConstantForce = FVector3f(0.0f, 0.0f, -Random.FRandRange(0.0f, 0.5f));
+		return Params;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurAsyncPhysicsTest, "GFur.Physics.AsyncMatchesInline", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurAsyncPhysicsTest::RunTest(const FString& Parameters)
+{
+	using namespace FurAsyncPhysicsTest;
+
+	// components of one bone, one block, a padded block and several integration tasks
+	const int32 BoneCounts[] = { 1, 4, 13, 300, 517 };
+	const int32 NumStates = UE_ARRAY_COUNT(BoneCounts);
+	const int32 NumFrames = 60;
+	FRandomStream Random(1357);
+
+	TArray<FFurPhysicsParameters> Params;
+	TArray<FFurPhysicsState> AsyncStates;
+	TArray<FFurPhysicsState> InlineStates;
+	TArray<TArray<FBoneTransform>> Transforms;
+	AsyncStates.SetNum(NumStates);
+	InlineStates.SetNum(NumStates);
+	Transforms.SetNum(NumStates);
+	for (int32 StateIndex = 0; StateIndex < NumStates; StateIndex++)
+	{
+		Params.Add(MakeParameters(Random));
+		AsyncStates[StateIndex].SetNum(BoneCounts[StateIndex]);
+		InlineStates[StateIndex].SetNum(BoneCounts[StateIndex]);
+		for (int32 Bone = 0; Bone < BoneCounts[StateIndex]; Bone++)
+		{
+			const FBoneTransform Transform = { FVector3f(Random.GetUnitVector()) * 10.0f, FQuat4f(FVector3f(Random.GetUnitVector()), Random.FRandRange(-PI, PI)) };
+			Transforms[StateIndex].Add(Transform);
+			AsyncStates[StateIndex].SetNewTransform(Bone, Transform.Position, Transform.Rotation);
+			InlineStates[StateIndex].SetNewTransform(Bone, Transform.Position, Transform.Rotation);
+		}
+		AsyncStates[StateIndex].Reset();
+		InlineStates[StateIndex].Reset();
+	}
+	TArray<FFurPhysicsState*> AsyncStatePointers;
+	for (FFurPhysicsState& State : AsyncStates)
+		AsyncStatePointers.Add(&State);
+
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		for (TArray<FBoneTransform>& StateTransforms : Transforms)
+		{
+			const float Step = (Frame % 20) < 3 ? 3.0f : 0.2f;
+			for (FBoneTransform& Transform : StateTransforms)
+			{
+				Transform.Position += FVector3f(Random.GetUnitVector()) * Random.FRandRange(0.0f, Step);
+				Transform.Rotation = (FQuat4f(FVector3f(Random.GetUnitVector()), Random.FRandRange(-Step, Step)) * Transform.Rotation).GetNormalized();
+			}
+		}
+
+		// the animation evaluation stands for the prerequisite of the gather, the gather sets the bones of this frame
+		FGraphEventRef AnimationEvent = FGraphEvent::CreateGraphEvent();
+		FGraphEventArray GatherPrerequisites = { AnimationEvent };
+		FGraphEventArray GatherEvents = { FFunctionGraphTask::CreateAndDispatchWhenReady([&AsyncStates, &Transforms]()
+		{
+			for (int32 StateIndex = 0; StateIndex < AsyncStates.Num(); StateIndex++)
+			{
+				for (int32 Bone = 0; Bone < Transforms[StateIndex].Num(); Bone++)
+					AsyncStates[StateIndex].SetNewTransform(Bone, Transforms[StateIndex][Bone].Position, Transforms[StateIndex][Bone].Rotation);
+			}
+		}, TStatId(), &GatherPrerequisites, ENamedThreads::AnyHiPriThreadHiPriTask) };
+		FGraphEventRef PhysicsEvent = UGFurSubsystem::LaunchPhysicsForTest(AsyncStatePointers, Params, GatherEvents);
+
+		for (int32 StateIndex = 0; StateIndex < NumStates; StateIndex++)
+		{
+			FFurPhysicsState& State = InlineStates[StateIndex];
+			for (int32 Bone = 0; Bone < Transforms[StateIndex].Num(); Bone++)
+				State.SetNewTransform(Bone, Transforms[StateIndex][Bone].Position, Transforms[StateIndex][Bone].Rotation);
+			State.Integrate(Params[StateIndex], 0, State.NumBlocks());
+		}
+
+		if (!TestFalse(FString::Printf(TEXT("Physics of frame %d waits for the animation"), Frame), PhysicsEvent->IsComplete()))
+		{
+			AnimationEvent->DispatchSubsequents();
+			PhysicsEvent->Wait();
+			return false;
+		}
+		AnimationEvent->DispatchSubsequents();
+		PhysicsEvent->Wait();
+
+		for (int32 StateIndex = 0; StateIndex < NumStates; StateIndex++)
+		{
+			for (int32 Bone = 0; Bone < BoneCounts[StateIndex]; Bone++)
+			{
+				const bool LinearMatches = AsyncStates[StateIndex].GetLinearOffset(Bone).Equals(InlineStates[StateIndex].GetLinearOffset(Bone), 0.0f);
+				const bool AngularMatches = AsyncStates[StateIndex].GetAngularOffset(Bone).Equals(InlineStates[StateIndex].GetAngularOffset(Bone), 0.0f);
+				if (!TestTrue(FString::Printf(TEXT("Offsets of bone %d of state %d in frame %d"), Bone, StateIndex, Frame), LinearMatches && AngularMatches))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,106 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurComponent.h"
+#include "Misc/AutomationTest.h"
+#include "Async/Async.h"
+#include "Containers/Queue.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurDynamicDataRingStressTest, "GFur.DynamicData.RingStress", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** A producer writes and submits snapshots like fur physics while a consumer reads them like the render thread. */
+bool FFurDynamicDataRingStressTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumSubmissions = 200000;
+	constexpr int32 NumBones = 64;
+
+	struct FSubmitted
+	{
+		const FFurDynamicData* Data;
+		uint64 Submission;
+	};
+
+	FFurDynamicDataRing Ring;
+	TQueue<FSubmitted, EQueueMode::Spsc> Queue;
+	std::atomic<bool> ProducerDone { false };
+	std::atomic<int32> NumMismatches { 0 };
+	std::atomic<int32> NumConsumed { 0 };
+	std::atomic<int32> NumQueued { 0 };
+
+	TFuture<void> Consumer = Async(EAsyncExecution::Thread, [&]()
+	{
+		FRandomStream Random(7);
+		FSubmitted Submitted;
+		while (true)
+		{
+			if (!Queue.Dequeue(Submitted))
+			{
+				if (ProducerDone.load() && Queue.IsEmpty())
+					break;
+				FPlatformProcess::Yield();
+				continue;
+			}
+
+			const FFurDynamicData& Data = *Submitted.Data;
+			const float Expected = float(Submitted.Submission % 65536);
+			bool Valid = Data.Submission.load(std::memory_order_acquire) == Submitted.Submission && Data.LinearOffsets.Num() == NumBones;
+			for (int32 BoneIndex = 0; Valid && BoneIndex < NumBones; BoneIndex++)
+			{
+				// a slow reader gives the producer a chance to overwrite the snapshot
+				if (Random.FRand() < 0.01f)
+					FPlatformProcess::Yield();
+				Valid = Data.LinearOffsets[BoneIndex].X == Expected && Data.BonePositions[BoneIndex].Y == Expected;
+			}
+			if (!Valid)
+				NumMismatches++;
+			NumConsumed++;
+			FFurDynamicDataRing::Release(Submitted.Data);
+			NumQueued--;
+		}
+	});
+
+	FRandomStream Random(3);
+	int32 NumDropped = 0;
+	for (int32 SubmissionIndex = 0; SubmissionIndex < NumSubmissions; SubmissionIndex++)
+	{
+		FFurDynamicData& Data = Ring.Begin();
+		const uint64 Submission = Ring.GetSubmission();
+		const float Value = float(Submission % 65536);
+		Data.LinearOffsets.SetNumUninitialized(NumBones);
+		Data.BonePositions.SetNumUninitialized(NumBones);
+		for (int32 BoneIndex = 0; BoneIndex < NumBones; BoneIndex++)
+		{
+			Data.LinearOffsets[BoneIndex] = FVector3f(Value);
+			Data.BonePositions[BoneIndex] = FVector3f(Value);
+		}
+
+		// physics may run again before the snapshot is submitted
+		if (Random.FRand() < 0.05f)
+			continue;
+
+		const FFurDynamicData* Submitted = Ring.Submit();
+		// updates replaced in the queue of the subsystem are released unread
+		if (Random.FRand() < 0.05f)
+		{
+			FFurDynamicDataRing::Release(Submitted);
+			NumDropped++;
+			continue;
+		}
+		// the engine keeps the render thread a few frames behind at most
+		while (NumQueued.load() >= 4)
+			FPlatformProcess::Yield();
+		NumQueued++;
+		Queue.Enqueue({ Submitted, Submission });
+	}
+	ProducerDone.store(true);
+	Consumer.Wait();
+
+	TestEqual(TEXT("Snapshots overwritten while read"), NumMismatches.load(), 0);
+	TestTrue(TEXT("Snapshots consumed"), NumConsumed.load() > 0);
+	AddInfo(FString::Printf(TEXT("%d snapshots consumed, %d dropped, ring grew to %d"), NumConsumed.load(), NumDropped, Ring.Num()));
+	return true;
+}
+
+#endif
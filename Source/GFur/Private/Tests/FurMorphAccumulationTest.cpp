@@ -0,0 +1,64 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurMorphObject.h"
+#include "Animation/MorphTarget.h"
+#include "GPUSkinVertexFactory.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurMorphAccumulationTest, "GFur.Morph.ParallelAccumulationMatchesSerial", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurMorphAccumulationTest::RunTest(const FString& Parameters)
+{
+	const int32 NumSourceVertices = 24000;
+	const int32 NumVertices = 20000;
+	const int32 NumMorphs = 60;
+	FRandomStream Random(1234);
+
+	// some source vertices don't exist in the fur mesh, some deltas point past the remap table like broken imports
+	TArray<int32> MorphRemapTable;
+	MorphRemapTable.SetNumUninitialized(NumSourceVertices - 100);
+	for (int32 i = 0; i < MorphRemapTable.Num(); i++)
+		MorphRemapTable[i] = Random.FRand() < 0.1f ? -1 : Random.RandHelper(NumVertices);
+
+	// facial rig like targets, overlapping regions with weights of both signs and above one
+	TArray<TArray<FMorphTargetDelta>> MorphDeltas;
+	TArray<FFurMorphObject::FActiveMorph> ActiveMorphs;
+	MorphDeltas.SetNum(NumMorphs);
+	for (int32 MorphIndex = 0; MorphIndex < NumMorphs; MorphIndex++)
+	{
+		TArray<FMorphTargetDelta>& Deltas = MorphDeltas[MorphIndex];
+		const int32 NumDeltas = Random.RandRange(100, 4000);
+		const int32 First = Random.RandHelper(NumSourceVertices - NumDeltas);
+		for (int32 i = 0; i < NumDeltas; i++)
+		{
+			FMorphTargetDelta& Delta = Deltas.AddDefaulted_GetRef();
+			Delta.PositionDelta = FVector3f(Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-1.0f, 1.0f));
+			Delta.TangentZDelta = FVector3f(Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-1.0f, 1.0f));
+			Delta.SourceIdx = First + i;
+		}
+
+		FFurMorphObject::FActiveMorph& ActiveMorph = ActiveMorphs.AddDefaulted_GetRef();
+		ActiveMorph.Deltas = Deltas.GetData();
+		ActiveMorph.NumDeltas = Deltas.Num();
+		ActiveMorph.Weight = Random.FRandRange(-1.5f, 1.5f);
+		ActiveMorph.AbsWeight = FMath::Abs(ActiveMorph.Weight);
+	}
+
+	TArray<FMorphGPUSkinVertex> Serial;
+	FFurMorphObject::AccumulateForTest(ActiveMorphs, MorphRemapTable, NumVertices, 1, Serial);
+
+	// uneven range sizes and more ranges than workers
+	for (int32 NumRanges : { 2, 7, 16, 33 })
+	{
+		TArray<FMorphGPUSkinVertex> Parallel;
+		FFurMorphObject::AccumulateForTest(ActiveMorphs, MorphRemapTable, NumVertices, NumRanges, Parallel);
+		TestTrue(FString::Printf(TEXT("%d ranges match the serial accumulation bit for bit"), NumRanges),
+			FMemory::Memcmp(Serial.GetData(), Parallel.GetData(), sizeof(FMorphGPUSkinVertex) * NumVertices) == 0);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
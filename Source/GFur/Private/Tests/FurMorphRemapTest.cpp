@@ -0,0 +1,175 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurMorphRemap.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurMorphRemapTest
+{
+	void AddVertex(FFurMorphRemapMesh& Mesh, const FVector3f& Position, const FVector3f& Normal, const FVector2f& UV)
+	{
+		const FVector3f TangentX = FVector3f::CrossProduct(FMath::Abs(Normal.Z) < 0.9f ? FVector3f::UpVector : FVector3f::ForwardVector, Normal).GetSafeNormal();
+		Mesh.Positions.Add(Position);
+		Mesh.TangentsX.Add(FVector4f(TangentX, 0.0f));
+		Mesh.TangentsY.Add(FVector3f::CrossProduct(Normal, TangentX));
+		Mesh.TangentsZ.Add(FVector4f(Normal, 1.0f));
+		Mesh.UVs.Add(UV);
+	}
+
+	/**
+	 * Sphere mirrored in Z, every vertex has a counterpart at -Z. Positions are snapped close to cell borders of the spatial
+	 * hash and the equator is duplicated like a mirror seam.
+	 */
+	FFurMorphRemapMesh MakeSymmetricMesh(int32 NumRings, int32 NumSegments, float Radius)
+	{
+		FFurMorphRemapMesh Mesh;
+		Mesh.NumTexCoords = 1;
+		for (int32 Ring = 0; Ring <= NumRings; Ring++)
+		{
+			for (int32 Segment = 0; Segment < NumSegments; Segment++)
+			{
+				const float Theta = PI * 0.5f * Ring / NumRings;
+				const float Phi = 2.0f * PI * Segment / NumSegments;
+				FVector3f Normal(FMath::Cos(Theta) * FMath::Cos(Phi), FMath::Cos(Theta) * FMath::Sin(Phi), FMath::Sin(Theta));
+				FVector3f Position = Normal * Radius;
+				Position.X = FMath::RoundToFloat(Position.X / 0.02f) * 0.02f + 0.0001f;
+				const FVector2f UV((float)Segment / NumSegments, (float)Ring / NumRings);
+				AddVertex(Mesh, Position, Normal, UV);
+				AddVertex(Mesh, FVector3f(Position.X, Position.Y, -Position.Z), FVector3f(Normal.X, Normal.Y, -Normal.Z), FVector2f(UV.X, -UV.Y));
+			}
+		}
+		Mesh.Sections.Add({ 0, (uint32)Mesh.Positions.Num(), 0 });
+		return Mesh;
+	}
+
+	/** Grow mesh of the master with shuffled vertices moved within the tolerance, some vertices removed or changed. */
+	FFurMorphRemapMesh MakeGrowMesh(const FFurMorphRemapMesh& Master, FRandomStream& Random)
+	{
+		TArray<int32> Order;
+		for (int32 i = 0; i < Master.Positions.Num(); i++)
+		{
+			if (Random.FRand() > 0.1f)
+				Order.Add(i);
+		}
+		for (int32 i = Order.Num() - 1; i > 0; i--)
+			Order.Swap(i, Random.RandRange(0, i));
+
+		FFurMorphRemapMesh Grow;
+		Grow.NumTexCoords = 1;
+		for (int32 Index : Order)
+		{
+			const FVector3f Jitter = FVector3f(Random.VRand()) * Random.FRand() * FFurMorphRemapCache::PositionTolerance * 0.9f;
+			FVector2f UV = Master.UVs[Index];
+			if (Random.FRand() < 0.05f)
+				UV.X += 0.5f;
+			Grow.Positions.Add(Master.Positions[Index] + Jitter);
+			Grow.TangentsX.Add(Master.TangentsX[Index]);
+			Grow.TangentsY.Add(Master.TangentsY[Index]);
+			Grow.TangentsZ.Add(Master.TangentsZ[Index]);
+			Grow.UVs.Add(UV);
+		}
+
+		// two sections, the second one with another material doesn't match anything
+		const uint32 NumFirst = Grow.Positions.Num() * 3 / 4;
+		Grow.Sections.Add({ 0, NumFirst, 0 });
+		Grow.Sections.Add({ NumFirst, Grow.Positions.Num() - NumFirst, 1 });
+		return Grow;
+	}
+
+	TArray<int32> BuildBruteForce(const FFurMorphRemapMesh& Master, const FFurMorphRemapMesh& Grow)
+	{
+		TArray<int32> Table;
+		Table.Init(-1, Master.Positions.Num());
+		const uint32 UVCount = FMath::Min(Master.NumTexCoords, Grow.NumTexCoords);
+		for (const auto& MasterSection : Master.Sections)
+		{
+			for (uint32 i = MasterSection.BaseVertexIndex; i < MasterSection.BaseVertexIndex + MasterSection.NumVertices; i++)
+			{
+				int32 BestIndex = -1;
+				float BestDistSquared = FMath::Square(FFurMorphRemapCache::PositionTolerance);
+				for (const auto& Section : Grow.Sections)
+				{
+					if (Section.MaterialIndex != MasterSection.MaterialIndex)
+						continue;
+					for (uint32 j = Section.BaseVertexIndex; j < Section.BaseVertexIndex + Section.NumVertices; j++)
+					{
+						const float DistSquared = FVector3f::DistSquared(Master.Positions[i], Grow.Positions[j]);
+						if (DistSquared > BestDistSquared || (BestIndex != -1 && DistSquared >= BestDistSquared))
+							continue;
+						bool Matches = Master.TangentsX[i].Equals(Grow.TangentsX[j], FFurMorphRemapCache::TangentTolerance)
+							&& Master.TangentsY[i].Equals(Grow.TangentsY[j], FFurMorphRemapCache::TangentTolerance)
+							&& Master.TangentsZ[i].Equals(Grow.TangentsZ[j], FFurMorphRemapCache::TangentTolerance);
+						for (uint32 k = 0; Matches && k < UVCount; k++)
+							Matches = Master.UVs[i * Master.NumTexCoords + k].Equals(Grow.UVs[j * Grow.NumTexCoords + k], FFurMorphRemapCache::UVTolerance);
+						if (Matches)
+						{
+							BestIndex = j;
+							BestDistSquared = DistSquared;
+						}
+					}
+				}
+				Table[i] = BestIndex;
+			}
+		}
+		return Table;
+	}
+
+	void Compare(FAutomationTestBase& Test, const TCHAR* Name, const FFurMorphRemapMesh& Master, const FFurMorphRemapMesh& Grow)
+	{
+		const TArray<int32> Table = FFurMorphRemapCache::Build(Master, Grow);
+		const TArray<int32> Expected = BuildBruteForce(Master, Grow);
+		if (!Test.TestEqual(FString::Printf(TEXT("%s table size"), Name), Table.Num(), Expected.Num()))
+			return;
+
+		int32 NumMatched = 0;
+		int32 NumMismatches = 0;
+		for (int32 i = 0; i < Table.Num(); i++)
+		{
+			NumMatched += Expected[i] != -1;
+			if (Table[i] == Expected[i])
+				continue;
+			// vertices at the same distance are equally good matches
+			if (Table[i] == -1 || Expected[i] == -1
+				|| FVector3f::DistSquared(Master.Positions[i], Grow.Positions[Table[i]]) != FVector3f::DistSquared(Master.Positions[i], Grow.Positions[Expected[i]]))
+				NumMismatches++;
+		}
+		Test.TestEqual(FString::Printf(TEXT("%s mismatches"), Name), NumMismatches, 0);
+		Test.TestTrue(FString::Printf(TEXT("%s matches vertices"), Name), NumMatched > Table.Num() / 2);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurMorphRemapBuildTest, "GFur.MorphRemap.Build", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurMorphRemapBuildTest::RunTest(const FString& Parameters)
+{
+	using namespace FurMorphRemapTest;
+	FRandomStream Random(11);
+
+	// mirrored vertices fall into cells at -Z which must not be confused with the cells at +Z
+	const FFurMorphRemapMesh Symmetric = MakeSymmetricMesh(24, 48, 50.0f);
+	Compare(*this, TEXT("Symmetric in Z"), Symmetric, MakeGrowMesh(Symmetric, Random));
+
+	// a small mesh puts many vertices into neighbouring cells
+	const FFurMorphRemapMesh Small = MakeSymmetricMesh(16, 32, 0.2f);
+	Compare(*this, TEXT("Small symmetric"), Small, MakeGrowMesh(Small, Random));
+
+	// identical meshes map every vertex of a section to itself or a vertex at the same position
+	FFurMorphRemapMesh Identical = Symmetric;
+	Compare(*this, TEXT("Identical"), Symmetric, Identical);
+	const TArray<int32> Table = FFurMorphRemapCache::Build(Symmetric, Identical);
+	int32 NumUnmatched = 0;
+	for (int32 Index : Table)
+		NumUnmatched += Index == -1;
+	TestEqual(TEXT("Identical meshes match all vertices"), NumUnmatched, 0);
+
+	// grow mesh without UVs matches by position and tangents only
+	FFurMorphRemapMesh NoUVs = MakeGrowMesh(Symmetric, Random);
+	NoUVs.NumTexCoords = 0;
+	NoUVs.UVs.Reset();
+	Compare(*this, TEXT("No UVs"), Symmetric, NoUVs);
+	return true;
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurPhysics.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurPhysicsIntegrateTest
+{
+	/** Spring of one bone as it was integrated by UGFurComponent before the SIMD pass. */
+	struct FReferenceSpring
+	{
+		FVector3f Position;
+		FQuat4f Rotation;
+		FVector3f LinearOffset = FVector3f::ZeroVector;
+		FVector3f LinearVelocity = FVector3f::ZeroVector;
+		FVector3f AngularOffset = FVector3f::ZeroVector;
+		FVector3f AngularVelocity = FVector3f::ZeroVector;
+
+		void Integrate(const FFurPhysicsParameters& Params, const FVector3f& NewPosition, const FQuat4f& NewRotation)
+		{
+			const FVector3f Force = Params.ConstantForce;
+			LinearOffset -= (NewPosition - Position) * Params.ForceFactor;
+			FVector3f NewOffset = (LinearVelocity * Params.SinX + (LinearOffset - Force) * Params.CosX) * Params.DampingFactor + Force;
+			FVector3f NewVelocity = (LinearVelocity * Params.CosX - (LinearOffset - Force) * Params.SinX) * Params.DampingFactor;
+			LinearOffset = NewOffset;
+			LinearVelocity = NewVelocity;
+			if (LinearOffset.Size() > Params.MaxForce)
+			{
+				LinearOffset *= Params.MaxForce / LinearOffset.Size();
+				const float k = FVector3f::DotProduct(LinearOffset, LinearVelocity) / FVector3f::DotProduct(LinearOffset, LinearOffset);
+				if (k > 0.0f)
+					LinearVelocity -= LinearOffset * k;
+			}
+
+			const FQuat4f Diff = NewRotation * Rotation.Inverse();
+			FVector3f Axis;
+			float Angle;
+			Diff.ToAxisAndAngle(Axis, Angle);
+			if (Angle > PI)
+				Angle -= 2 * PI;
+			AngularOffset -= Axis * (-Angle * Params.ForceFactor);
+			NewOffset = (AngularVelocity * Params.SinX + AngularOffset * Params.CosX) * Params.DampingFactor;
+			NewVelocity = (AngularVelocity * Params.CosX - AngularOffset * Params.SinX) * Params.DampingFactor;
+			AngularOffset = NewOffset;
+			AngularVelocity = NewVelocity;
+			if (AngularOffset.Size() > Params.MaxTorque)
+				AngularOffset *= Params.MaxTorque / AngularOffset.Size();
+
+			Position = NewPosition;
+			Rotation = NewRotation;
+		}
+	};
+
+	FQuat4f RandomRotation(FRandomStream& Random, float MaxAngle)
+	{
+		return FQuat4f(FVector3f(Random.GetUnitVector()), Random.FRandRange(-MaxAngle, MaxAngle));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurPhysicsIntegrateTest, "GFur.Physics.SimdMatchesScalarSpring", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurPhysicsIntegrateTest::RunTest(const FString& Parameters)
+{
+	using namespace FurPhysicsIntegrateTest;
+
+	// not a multiple of the block size, so the last block is padded
+	const int32 NumBones = 13;
+	const int32 NumFrames = 300;
+	const float Tolerance = 1.0e-3f;
+	FRandomStream Random(4321);
+
+	FFurPhysicsParameters Params;
+	Params.ForceFactor = 0.5f;
+	Params.SinX = FMath::Sin(0.3f);
+	Params.CosX = FMath::Cos(0.3f);
+	Params.DampingFactor = 0.9f;
+	Params.MaxForce = 2.0f;
+	Params.MaxTorque = 0.5f;
+	Params.ConstantForce = FVector3f(0.0f, 0.1f, -0.3f);
+
+	FFurPhysicsState State;
+	State.SetNum(NumBones);
+	TArray<FReferenceSpring> Springs;
+	Springs.SetNum(NumBones);
+	for (int32 i = 0; i < NumBones; i++)
+	{
+		Springs[i].Position = FVector3f(Random.GetUnitVector()) * 10.0f;
+		Springs[i].Rotation = RandomRotation(Random, PI);
+		State.SetNewTransform(i, Springs[i].Position, Springs[i].Rotation);
+	}
+	State.Reset();
+
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		// jerky frames push offsets past MaxForce and MaxTorque, some bones turn by more than PI
+		const float Step = (Frame % 50) < 5 ? 3.0f : 0.2f;
+		for (int32 i = 0; i < NumBones; i++)
+		{
+			const FVector3f NewPosition = Springs[i].Position + FVector3f(Random.GetUnitVector()) * Random.FRandRange(0.0f, Step);
+			const FQuat4f NewRotation = (RandomRotation(Random, Step) * Springs[i].Rotation).GetNormalized();
+			State.SetNewTransform(i, NewPosition, NewRotation);
+			Springs[i].Integrate(Params, NewPosition, NewRotation);
+		}
+		State.Integrate(Params, 0, State.NumBlocks());
+
+		for (int32 i = 0; i < NumBones; i++)
+		{
+			const bool LinearMatches = State.GetLinearOffset(i).Equals(Springs[i].LinearOffset, Tolerance);
+			const bool AngularMatches = State.GetAngularOffset(i).Equals(Springs[i].AngularOffset, Tolerance);
+			if (!TestTrue(FString::Printf(TEXT("Linear offset of bone %d in frame %d"), i, Frame), LinearMatches)
+				|| !TestTrue(FString::Printf(TEXT("Angular offset of bone %d in frame %d"), i, Frame), AngularMatches))
+				return false;
+			TestTrue(TEXT("Position moved to the new transformation"), State.GetPosition(i).Equals(Springs[i].Position, 0.0f));
+		}
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,133 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurPhysics.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurPhysicsThrottleTest
+{
+	FFurPhysicsThrottleSettings MakeSettings()
+	{
+		FFurPhysicsThrottleSettings Settings;
+		Settings.OffscreenTime = 1.0f;
+		Settings.ReducedDistance = 3000.0f;
+		Settings.FrozenDistance = 10000.0f;
+		Settings.ReducedSignificance = 0.5f;
+		Settings.FrozenSignificance = 0.1f;
+		Settings.ReducedInterval = 0.125f;
+		return Settings;
+	}
+
+	/** One frame of a scripted sequence and what the throttle should do in it. */
+	struct FFrame
+	{
+		float TimeSinceRendered;
+		float Distance;
+		EFurPhysicsMode Mode;
+		bool Step;
+		bool Resuming;
+	};
+
+	void RunSequence(FAutomationTestBase& Test, const TCHAR* Name, TArrayView<const FFrame> Frames, float DeltaTime)
+	{
+		const FFurPhysicsThrottleSettings Settings = MakeSettings();
+		FFurPhysicsThrottle Throttle;
+		for (int32 FrameIndex = 0; FrameIndex < Frames.Num(); FrameIndex++)
+		{
+			const FFrame& Frame = Frames[FrameIndex];
+			const bool Step = Throttle.Update(Settings, DeltaTime, Frame.TimeSinceRendered, Frame.Distance, 1.0f);
+			const FString Context = FString::Printf(TEXT("%s frame %d"), Name, FrameIndex);
+			Test.TestEqual(*(Context + TEXT(" mode")), (int32)Throttle.GetMode(), (int32)Frame.Mode);
+			Test.TestEqual(*(Context + TEXT(" step")), Step, Frame.Step);
+			Test.TestEqual(*(Context + TEXT(" resuming")), Throttle.IsResuming(), Frame.Resuming);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurPhysicsThrottleVisibilityTest, "GFur.Physics.Throttle.Visibility", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurPhysicsThrottleVisibilityTest::RunTest(const FString& Parameters)
+{
+	using namespace FurPhysicsThrottleTest;
+	constexpr EFurPhysicsMode Full = EFurPhysicsMode::Full;
+	constexpr EFurPhysicsMode Frozen = EFurPhysicsMode::Frozen;
+
+	// a component which was never rendered simulates, e.g. fur spawned this frame or captured by a scene capture only
+	const FFrame NeverRendered[] = {
+		{ -1.0f, 0.0f, Full, true, false },
+		{ -1.0f, 0.0f, Full, true, false },
+		{ -1.0f, 0.0f, Full, true, false },
+	};
+	RunSequence(*this, TEXT("Never rendered"), NeverRendered, 1.0f / 30.0f);
+
+	// visible, offscreen for longer than the offscreen time, visible again
+	const FFrame Offscreen[] = {
+		{ 0.0f, 0.0f, Full, true, false },
+		{ 0.5f, 0.0f, Full, true, false },
+		{ 1.0f, 0.0f, Full, true, false },
+		{ 1.5f, 0.0f, Frozen, false, false },
+		{ 2.0f, 0.0f, Frozen, false, false },
+		{ 0.0f, 0.0f, Full, true, true },
+		{ 0.0f, 0.0f, Full, true, false },
+	};
+	RunSequence(*this, TEXT("Offscreen"), Offscreen, 0.5f);
+
+	// walking away from a visible component and back
+	const FFrame Distance[] = {
+		{ 0.0f, 1000.0f, Full, true, false },
+		{ 0.0f, 20000.0f, Frozen, false, false },
+		{ 0.0f, 1000.0f, Full, true, true },
+	};
+	RunSequence(*this, TEXT("Distance"), Distance, 1.0f / 30.0f);
+
+	// disabled offscreen freezing keeps simulating offscreen fur
+	FFurPhysicsThrottleSettings Settings = MakeSettings();
+	Settings.OffscreenTime = -1.0f;
+	TestEqual(TEXT("Offscreen freezing disabled"), (int32)FFurPhysicsThrottle::Evaluate(Settings, 100.0f, 0.0f, 1.0f), (int32)Full);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurPhysicsThrottleReducedTest, "GFur.Physics.Throttle.Reduced", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurPhysicsThrottleReducedTest::RunTest(const FString& Parameters)
+{
+	using namespace FurPhysicsThrottleTest;
+	const FFurPhysicsThrottleSettings Settings = MakeSettings();
+	constexpr float DeltaTime = 1.0f / 32.0f;
+
+	// steps every 4 frames at the reduced interval of 0.125 s and covers the time of all 4 frames
+	FFurPhysicsThrottle Throttle;
+	int32 NumSteps = 0;
+	for (int32 FrameIndex = 1; FrameIndex <= 40; FrameIndex++)
+	{
+		const bool Step = Throttle.Update(Settings, DeltaTime, 0.0f, 5000.0f, 1.0f);
+		TestEqual(TEXT("Reduced mode"), (int32)Throttle.GetMode(), (int32)EFurPhysicsMode::Reduced);
+		if (Step)
+		{
+			NumSteps++;
+			TestEqual(TEXT("Step time"), Throttle.GetStepDeltaTime(), DeltaTime * 4.0f, 1e-4f);
+			TestEqual(TEXT("Alpha after a step"), Throttle.GetInterpolationAlpha(), 0.0f, 1e-4f);
+		}
+		else if (NumSteps > 0)
+		{
+			// frames between steps blend from the previous step to the latest one
+			TestEqual(TEXT("Alpha between steps"), Throttle.GetInterpolationAlpha(), float(FrameIndex % 4) / 4.0f, 1e-4f);
+		}
+	}
+	TestEqual(TEXT("Number of steps"), NumSteps, 10);
+
+	// significance alone reduces and freezes
+	TestEqual(TEXT("Reduced significance"), (int32)FFurPhysicsThrottle::Evaluate(Settings, 0.0f, 0.0f, 0.3f), (int32)EFurPhysicsMode::Reduced);
+	TestEqual(TEXT("Frozen significance"), (int32)FFurPhysicsThrottle::Evaluate(Settings, 0.0f, 0.0f, 0.05f), (int32)EFurPhysicsMode::Frozen);
+
+	// the first step after frozen frames doesn't blend with the step before freezing
+	Throttle.Update(Settings, DeltaTime, 0.0f, 20000.0f, 1.0f);
+	TestEqual(TEXT("Frozen"), (int32)Throttle.GetMode(), (int32)EFurPhysicsMode::Frozen);
+	TestTrue(TEXT("Resume steps"), Throttle.Update(Settings, DeltaTime, 0.0f, 5000.0f, 1.0f));
+	TestTrue(TEXT("Resuming"), Throttle.IsResuming());
+	TestEqual(TEXT("Alpha when resuming"), Throttle.GetInterpolationAlpha(), 1.0f);
+	return true;
+}
+
+#endif
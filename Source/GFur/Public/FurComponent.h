@@ -4,8 +4,91 @@
 
 #include "Runtime/Engine/Classes/Components/MeshComponent.h"
 #include "Runtime/Engine/Classes/Components/SkinnedMeshComponent.h"
+#include "FurPhysics.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "Experimental/ConcurrentLinearAllocator.h"
+#include <atomic>
 #include "FurComponent.generated.h"
 
+class UGFurComponent;
+
+/** Bone data of one frame written by fur physics and read by the render thread, see UGFurComponent::FurDynamicData. */
+struct FFurDynamicData
+{
+	TArray<FMatrix> ReferenceToLocal;
+	TArray<FVector3f> LinearOffsets;
+	TArray<FVector3f> AngularOffsets;
+	TArray<FVector3f> BonePositions;
+	float ForceDistribution = 0.0f;
+	float MaxPhysicsOffsetLength = 0.0f;
+	/** Simulated bones the arrays were written for, see UGFurComponent::UpdateSimulatedBones. */
+	uint32 Generation = 0;
+	/** Submission the snapshot was written for, the render thread checks it wasn't overwritten meanwhile. */
+	std::atomic<uint64> Submission { 0 };
+	/** Set while a submitted snapshot may still be read, see FFurDynamicDataRing::Release. */
+	mutable std::atomic<bool> InFlight { false };
+};
+
+/**
+ * Snapshots of bone data handed over to the render thread without copies or locks. Physics writes the current snapshot,
+ * a submitted snapshot is never written again until its reader releases it. The ring grows when all snapshots are in
+ * flight, which happens only with several submissions before the render thread catches up.
+ */
+class GFUR_API FFurDynamicDataRing
+{
+public:
+	FFurDynamicDataRing();
+
+	/** Moves to a snapshot which isn't in flight once the current one was submitted, returns the current snapshot. */
+	FFurDynamicData& Begin();
+	FFurDynamicData& GetCurrent() { return Snapshots[Index]; }
+	/** Snapshot submitted last, physics continues from it. */
+	const FFurDynamicData& GetPrevious() const { return Snapshots[PreviousIndex]; }
+	/** Hands the current snapshot over, it's in flight until released. */
+	const FFurDynamicData* Submit();
+	uint64 GetSubmission() const { return Submission; }
+	int32 Num() const { return Snapshots.Num(); }
+
+	/** Called by the render thread when done with a snapshot, or by whoever drops a submitted snapshot unread. */
+	static void Release(const FFurDynamicData* InData) { InData->InFlight.store(false, std::memory_order_release); }
+
+private:
+	TIndirectArray<FFurDynamicData> Snapshots;
+	int32 Index = 0;
+	int32 PreviousIndex = 0;
+	uint64 Submission = 0;
+	bool Submitted = true;
+};
+
+/** Morph target active in the master pose component with its weight, gathered on the game thread. */
+struct FFurActiveMorphTarget
+{
+	const UMorphTarget* MorphTarget;
+	float Weight;
+};
+
+/** Active morph targets of one frame, allocated from frame memory to be passed to the render thread. */
+typedef TArray<FFurActiveMorphTarget, FConcurrentLinearArrayAllocator> FFurActiveMorphTargets;
+
+/** Dynamic data a fur component sends to the render thread every frame. */
+struct FFurRenderUpdate
+{
+	UGFurComponent* FurComponent = nullptr;
+	/**
+	 * Skeletal mesh object of the master when skinning matrices are copied from it. Checked against the master when the update
+	 * is enqueued, a mesh object released later is deleted only after the render command ran.
+	 */
+	class FSkeletalMeshObject* MasterMeshObject = nullptr;
+	/** Skinning matrices of bones bound in the master are copied from MasterMeshObject, ReferenceToLocal holds the others. */
+	bool UseMasterReferenceToLocal = false;
+	const FFurDynamicData* DynamicData = nullptr;
+	uint64 DynamicDataSubmission = 0;
+	FFurActiveMorphTargets ActiveMorphTargets;
+	uint32 BoneDataRevision = 0;
+	bool Discontinuous = false;
+};
+
 USTRUCT(BlueprintType)
 struct FFurLod
 {
@@ -42,6 +125,25 @@ struct FFurLod
 	bool DisableMorphTargets = false;
 };
 
+/** Morph remap table stored at cook time, maps vertices of the master mesh to vertices of the grow mesh. */
+USTRUCT()
+struct FFurMorphRemapTableData
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+	class USkinnedAsset* MasterMesh = nullptr;
+
+	UPROPERTY()
+	class USkeletalMesh* GrowMesh = nullptr;
+
+	UPROPERTY()
+	int32 Lod = 0;
+
+	UPROPERTY()
+	TArray<int32> RemapTable;
+};
+
 /** UFurComponent */
 UCLASS(editinlinenew,
 	meta = (BlueprintSpawnableComponent),
@@ -179,6 +281,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "gFur Physics")
 	float MaxPhysicsOffsetLength;
 
+	/**
+	* Maximal number of physics regions simulated for skeletal meshes, 0 simulates every bone driving fur. Neighbouring bones sharing
+	* skin weights are grouped into one region which moves the fur of all its bones. Useful for rigs with many small bones.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "gFur Physics", meta = (ClampMin = "0"))
+	int32 MaxPhysicsRegions;
+
 	/**
 	* Introduces noise to the shell vertices along the normal. This helps to break up the uniformity of the shell slices when viewed from the side.
 	*/
@@ -191,6 +300,12 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "gFur Shell settings")
 	bool DisableMorphTargets;
 
+	/**
+	* Stores the tables that map morph targets of the parent mesh to the grow mesh when cooking, so they don't have to be computed when the fur is created in game.
+	*/
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "gFur Shell settings")
+	bool CookMorphRemapTables;
+
 	/**
 	 * Allows adjusting the desired streaming distance of streaming textures that uses UV 0.
 	 * 1.0 is the default, whereas a higher value makes the textures stream in sooner from far away.
@@ -223,12 +338,21 @@ public:
 	virtual class UBodySetup* GetBodySetup() override;
 	// End UPrimitiveComponent interface.
 
+	// Begin UObject interface.
+	virtual void BeginDestroy() override;
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+	// End UObject interface.
+
 	const TArray<class UMaterialInstanceDynamic*>& GetFurMaterials() const { return FurMaterials; }
 
 	TWeakObjectPtr< class USkinnedMeshComponent > GetMasterPoseComponent() const { return MasterPoseComponent; }
 
 protected:
 	//~ Begin UActorComponent Interface
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
 	virtual void CreateRenderState_Concurrent(FRegisterComponentContext* Context) override;
 	virtual void SendRenderDynamicData_Concurrent() override;
 	virtual void DestroyRenderState_Concurrent() override;
@@ -237,23 +361,66 @@ protected:
 	//~ End UActorComponent Interface
 
 private:
+	friend class UGFurSubsystem;
+
 	TWeakObjectPtr< class USkinnedMeshComponent > MasterPoseComponent;
+	/** Master registered as the tick prerequisite of this component. */
+	TWeakObjectPtr< class USkinnedMeshComponent > TickPrerequisiteMaster;
 	TArray<TArray<int32>> MasterBoneMap;
-	TArray<FMatrix> ReferenceToLocal;
-	TArray<FMatrix> Transformations;
-	TArray<FVector> LinearVelocities;
-	TArray<FVector> AngularVelocities;
-	TArray<FVector> LinearOffsets;
-	TArray<FVector> AngularOffsets;
+	FFurDynamicDataRing FurDynamicData;
+	/** Index of the update of this component in UGFurSubsystem::PendingRenderUpdates, guarded by its lock. */
+	int32 PendingRenderUpdateIndex = INDEX_NONE;
+	uint32 FurDynamicDataGeneration = 1;
+	/** Incremented whenever ReferenceToLocal, offsets or bone positions change, bone buffers are uploaded only for new revisions. */
+	uint32 BoneDataRevision = 0;
+	bool BoneDataChanged = true;
+	/** Fur bones are bound like the bones of the master, skinning matrices of the master apply to them as they are. */
+	bool MasterBindPoseMatches = false;
+	/** ReferenceToLocal is copied from the skeletal mesh object of the master on the render thread this frame. */
+	bool UseMasterReferenceToLocal = false;
+	/** Bones missing in some LOD of the master, their ReferenceToLocal is computed from the reference pose even when copying. */
+	TBitArray<> MasterUnmappedBones;
+	TArray<TArray<int32>> MasterBoneMap_RenderThread;
+	TArray<FMatrix> MasterReferenceToLocal_RenderThread;
+	/** Bones weighting fur vertices in any LOD, in the order of physics states. */
+	TArray<FBoneIndexType> SimulatedBones;
+	/** Physics region of every simulated bone, index of the physics state. */
+	TArray<int32> SimulatedBoneRegions;
+	/** Simulated bone driving every physics region. */
+	TArray<int32> PhysicsRegionBones;
+	TArray<FVector3f> SimulatedBonePositions;
+	/** Component space transformations of gathered bones, kept between frames to avoid reallocating them. */
+	TArray<FMatrix> GatheredMatrices;
+	TArray<bool> ValidGatheredMatrices;
+	/** Bones whose transformations are gathered, simulated bones and their ancestors. */
+	TBitArray<> GatheredBones;
 	TArray< class UMaterialInstanceDynamic* > FurMaterials;
 	TArray< class FFurData* > FurData;
-	TArray< TArray< int32 > > MorphRemapTables;
-
-	FVector StaticLinearOffset;
-	FVector StaticAngularOffset;
-	FVector StaticLinearVelocity;
-	FVector StaticAngularVelocity;
-	FMatrix StaticTransformation;
+	/**
+	 * References to fur data kept in the editor across re-registration of edited components, fur data of the previous
+	 * parameters stands in for fur data of the new ones until its build task is done.
+	 */
+	TArray< class FFurData* > HeldFurData;
+	bool HeldFurDataSkeletal = false;
+	FTSTicker::FDelegateHandle HeldFurDataTickerHandle;
+	TArray< TSharedPtr< const TArray< int32 >, ESPMode::ThreadSafe > > MorphRemapTables;
+
+	UPROPERTY()
+	TArray<FFurMorphRemapTableData> CookedMorphRemapTables;
+
+	FFurPhysicsState PhysicsState;
+	FFurPhysicsParameters PhysicsParameters;
+	FFurPhysicsThrottle PhysicsThrottle;
+	TArray<FVector3f> PrevLinearOffsets;
+	TArray<FVector3f> PrevAngularOffsets;
+	FMatrix PhysicsToWorld;
+	FGraphEventRef PhysicsEvent;
+	bool PhysicsPending = false;
+	bool PhysicsGathered = false;
+	bool PhysicsSimulated = false;
+	bool PhysicsStep = true;
+	bool PhysicsHold = false;
+	bool IntegratePhysics = false;
 	bool OldPositionValid = false;
 	int32 LastLOD = -1;
 
@@ -266,7 +433,25 @@ private:
 	// Begin USceneComponent interface.
 
 	void updateFur();
-	void UpdateFur_RenderThread(FRHICommandListImmediate& RHICmdList, bool Discontinuous, const FMorphTargetWeightMap & ActiveMorphTargets, const TArray<float> & MorphTargetWeights);
+	/** Captures the component transform and decides whether physics steps this frame. */
+	void BeginPhysics(float Significance);
+	/** Gathers bone transformations and spring constants for this frame, returns false if there's nothing to simulate. Can run on any thread. */
+	bool GatherPhysics();
+	/** Copies simulated offsets for rendering. */
+	void FinishPhysics();
+	void SimulatePhysics();
+	/** Moves to the next snapshot once the current one was submitted, physics writes it. */
+	void BeginDynamicData();
+	const FFurDynamicData& GetPreviousDynamicData() const { return FurDynamicData.GetPrevious(); }
+	/** Waits for physics task launched by UGFurSubsystem. */
+	void WaitForPhysics();
+	void UpdateFur_RenderThread(FRHICommandListImmediate& RHICmdList, const FFurRenderUpdate& Update);
 	void UpdateMasterBoneMap();
+	void UpdateMasterTickPrerequisite();
+	/** Whether fur data is built in tasks and kept in HeldFurData meanwhile. */
+	bool UseAsyncFurDataBuild() const;
+	void ReleaseHeldFurData();
+	void UpdateSimulatedBones();
 	void CreateMorphRemapTable(int32 InLod);
+	class USkinnedMeshComponent* FindMasterPoseComponent() const;
 };
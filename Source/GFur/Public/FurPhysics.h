@@ -0,0 +1,139 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Spring constants of one component for the current frame, shared by all its bones. */
+struct FFurPhysicsParameters
+{
+	float ForceFactor = 1.0f;
+	float SinX = 0.0f;
+	float CosX = 1.0f;
+	float DampingFactor = 1.0f;
+	float MaxForce = FLT_MAX;
+	float MaxTorque = FLT_MAX;
+	FVector3f ConstantForce = FVector3f::ZeroVector;
+};
+
+/**
+ * Spring states of one component in structure-of-arrays layout. Elements are integrated in blocks of 4 with SIMD,
+ * every stream is padded to a multiple of 4 elements, padding elements stay at rest.
+ */
+class FFurPhysicsState
+{
+public:
+	enum { BlockSize = 4 };
+
+	void SetNum(int32 InNum);
+	int32 Num() const { return NumElements; }
+	int32 NumBlocks() const { return NumPadded / BlockSize; }
+
+	/** Transformation of an element gathered for this frame, without scaling. */
+	void SetNewTransform(int32 Index, const FVector3f& InPosition, const FQuat4f& InRotation);
+
+	/** Moves elements to their new transformations and stops them. */
+	void Reset();
+
+	/** Moves elements to their new transformations keeping their offsets and velocities. */
+	void Teleport();
+
+	/** Integrates the analytic spring of blocks [BeginBlock, EndBlock), elements move to their new transformations. */
+	void Integrate(const FFurPhysicsParameters& Params, int32 BeginBlock, int32 EndBlock);
+
+	FVector3f GetLinearOffset(int32 Index) const { return GetVector(LinearOffsetX, Index); }
+	FVector3f GetAngularOffset(int32 Index) const { return GetVector(AngularOffsetX, Index); }
+	FVector3f GetPosition(int32 Index) const { return GetVector(PositionX, Index); }
+	FVector3f GetNewPosition(int32 Index) const { return GetVector(NewPositionX, Index); }
+
+private:
+	enum EStream
+	{
+		PositionX, PositionY, PositionZ,
+		RotationX, RotationY, RotationZ, RotationW,
+		NewPositionX, NewPositionY, NewPositionZ,
+		NewRotationX, NewRotationY, NewRotationZ, NewRotationW,
+		LinearOffsetX, LinearOffsetY, LinearOffsetZ,
+		LinearVelocityX, LinearVelocityY, LinearVelocityZ,
+		AngularOffsetX, AngularOffsetY, AngularOffsetZ,
+		AngularVelocityX, AngularVelocityY, AngularVelocityZ,
+		NumStreams
+	};
+
+	float* Stream(EStream InStream) { return Data.GetData() + InStream * NumPadded; }
+	const float* Stream(EStream InStream) const { return Data.GetData() + InStream * NumPadded; }
+	FVector3f GetVector(int32 InFirstStream, int32 Index) const
+	{
+		return FVector3f(Stream(EStream(InFirstStream))[Index], Stream(EStream(InFirstStream + 1))[Index], Stream(EStream(InFirstStream + 2))[Index]);
+	}
+
+	TArray<float, TAlignedHeapAllocator<16>> Data;
+	int32 NumElements = 0;
+	int32 NumPadded = 0;
+};
+/**
+ * Groups bones into at most MaxRegions physics regions, one spring state is simulated per region. Regions with the closest
+ * weighted centers are merged first, shared skin weights of the regions bring them up to twice closer.
+ * OutBoneRegions maps bones to regions, OutRegionBones holds the bone with the largest skin weight of every region.
+ */
+void BuildFurPhysicsRegions(int32 MaxRegions, TArrayView<const FVector3f> BonePositions, TArrayView<const float> BoneWeights,
+	TFunctionRef<float(int32, int32)> GetSharedWeight, TArray<int32>& OutBoneRegions, TArray<int32>& OutRegionBones);
+
+enum class EFurPhysicsMode : uint8
+{
+	/** Simulated every frame. */
+	Full,
+	/** Simulated at a reduced rate, offsets are interpolated between steps. */
+	Reduced,
+	/** Offsets are kept as they were. */
+	Frozen,
+};
+
+struct FFurPhysicsThrottleSettings
+{
+	/** Time without being rendered after which physics freezes, negative disables. */
+	float OffscreenTime = 1.0f;
+	/** Distance to the closest view from which physics runs at the reduced rate, non-positive disables. */
+	float ReducedDistance = 0.0f;
+	/** Distance to the closest view from which physics freezes, non-positive disables. */
+	float FrozenDistance = 0.0f;
+	/** Significance below which physics runs at the reduced rate. */
+	float ReducedSignificance = 0.0f;
+	/** Significance below which physics freezes. */
+	float FrozenSignificance = 0.0f;
+	/** Time between two steps in the reduced mode. */
+	float ReducedInterval = 1.0f / 15.0f;
+};
+
+/**
+ * Decides when physics of one component steps and how the offsets of the last two steps are blended. Doesn't depend on
+ * the engine, the component feeds it with render time, view distance and significance every frame.
+ */
+class FFurPhysicsThrottle
+{
+public:
+	/** Negative TimeSinceRendered stands for a component which was never rendered, it counts as visible. */
+	static EFurPhysicsMode Evaluate(const FFurPhysicsThrottleSettings& Settings, float TimeSinceRendered, float Distance, float Significance);
+
+	/** Advances the throttle by DeltaTime, returns true if physics should step this frame. */
+	bool Update(const FFurPhysicsThrottleSettings& Settings, float DeltaTime, float TimeSinceRendered, float Distance, float Significance);
+
+	/** Forgets the previous step, next frames show the latest step only. */
+	void ResetInterpolation() { InterpolationValid = false; }
+
+	EFurPhysicsMode GetMode() const { return Mode; }
+	/** Time covered by the step of this frame. */
+	float GetStepDeltaTime() const { return StepDeltaTime; }
+	/** True for the first step after frozen frames, bones should be moved without affecting the offsets. */
+	bool IsResuming() const { return Resuming; }
+	/** Blend from the previous step to the latest one. */
+	float GetInterpolationAlpha() const;
+
+private:
+	EFurPhysicsMode Mode = EFurPhysicsMode::Full;
+	float Accumulated = 0.0f;
+	float StepDeltaTime = 0.0f;
+	float Interval = 0.0f;
+	bool Resuming = false;
+	bool InterpolationValid = false;
+};
@@ -48,6 +48,14 @@ public:
 	FOnSplinesChanged OnSplinesChanged;
 	DECLARE_MULTICAST_DELEGATE_OneParam(FOnSplinesCombed, const TArray<uint32>&);
 	FOnSplinesCombed OnSplinesCombed;
+	/** Notification when splines were removed and appended, removed splines are sorted indices before the removal. */
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSplinesAddedRemoved, const TArray<int32>& /*RemovedSplines*/, int32 /*AddedSplineCount*/);
+	FOnSplinesAddedRemoved OnSplinesAddedRemoved;
+	/**
+	 * Frame in which a comb undo record rebuilt fur through OnSplinesCombed, PostEditUndo of the same frame then skips the full
+	 * rebuild. A record applied without PostEditUndo doesn't affect undo in later frames.
+	 */
+	uint64 CombUndoFrame = 0;
 
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 	virtual void PostEditUndo() override;
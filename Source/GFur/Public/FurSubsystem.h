@@ -0,0 +1,71 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "FurComponent.h"
+#include "FurSubsystem.generated.h"
+
+typedef TArray<FFurRenderUpdate, FConcurrentLinearArrayAllocator> FFurRenderUpdates;
+
+/**
+ * Simulates fur physics of all fur components in the world. Bone states of the components are gathered after all actors
+ * ticked and integrated together in one parallel pass. With gFur.AsyncPhysics the pass runs in task graph tasks which
+ * fur components join when sending their render data at the end of frame.
+ * With gFur.BatchedRenderUpdate the render data of all components is submitted in one render command when the world
+ * starts rendering.
+ */
+UCLASS()
+class GFUR_API UGFurSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Begin UWorldSubsystem interface.
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End UWorldSubsystem interface.
+
+	// Begin FTickableGameObject interface.
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickableInEditor() const override { return true; }
+	// End FTickableGameObject interface.
+
+	void Register(UGFurComponent* InFurComponent);
+	void Unregister(UGFurComponent* InFurComponent);
+
+	/**
+	 * Sets a callback returning significance of a fur component in range 0 to 1, e.g. from the significance manager.
+	 * Fur physics runs at a reduced rate or freezes for insignificant components, see gFur.PhysicsThrottle.
+	 */
+	void SetSignificanceFunction(TFunction<float(const UGFurComponent*)> InSignificanceFunction);
+	float GetSignificance(const UGFurComponent* InFurComponent) const;
+
+	/** Queues render data of a component for the next batch, can be called from parallel end of frame updates. */
+	void QueueRenderUpdate(FFurRenderUpdate&& InUpdate);
+
+	/** Enqueues one render command updating all queued components. */
+	void FlushRenderUpdates();
+
+#if WITH_DEV_AUTOMATION_TESTS
+	/**
+	 * Integrates states in a task launched after InPrerequisites like the physics task of components, the integration is
+	 * split into the same parallel tasks. InParameters must outlive the returned event.
+	 */
+	static FGraphEventRef LaunchPhysicsForTest(TArrayView<FFurPhysicsState* const> InStates, TArrayView<const FFurPhysicsParameters> InParameters,
+		const FGraphEventArray& InPrerequisites);
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+private:
+	/** Integrates gathered components and hands the offsets over to them, can run on any thread. */
+	static void SimulatePhysics(TArrayView<UGFurComponent* const> InComponents);
+
+	TArray<UGFurComponent*> FurComponents;
+	TFunction<float(const UGFurComponent*)> SignificanceFunction;
+
+	FFurRenderUpdates PendingRenderUpdates;
+	FCriticalSection PendingRenderUpdatesCS;
+	TSharedPtr<class FFurSceneViewExtension, ESPMode::ThreadSafe> SceneViewExtension;
+};
\ No newline at end of file
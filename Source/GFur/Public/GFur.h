@@ -3,6 +3,12 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("gFur"), STATGROUP_GFur, STATCAT_Advanced);
+
+/** Render commands enqueued for fur dynamic data, by components or batched by UGFurSubsystem. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Fur Render Commands"), STAT_FurRenderCommands, STATGROUP_GFur, );
 
 class FGFurModule : public IModuleInterface
 {
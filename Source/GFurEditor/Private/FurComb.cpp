@@ -1,11 +1,18 @@
 // Copyright 2023 GiM s.r.o. All Rights Reserved.
 
 #include "FurComb.h"
+#include "GFurEditor.h"
 #include "FurCombCommands.h"
 #include "FurCombSettings.h"
 #include "FurComponent.h"
+#include "GFur.h"
+#include "FurMeshBVH.h"
+#include "FurVertexGrid.h"
 #include "FurSplines.h"
+#include "FurSplinesCombChange.h"
+#include "FurSplinePreviewComponent.h"
 
+#include "Async/ParallelFor.h"
 #include "EditorViewportClient.h"
 #include "Runtime/Slate/Public/Framework/Commands/UICommandList.h"
 #include "ScopedTransaction.h"
@@ -18,6 +25,18 @@
 
 #define LOCTEXT_NAMESPACE "FurComb"
 
+static TAutoConsoleVariable<int32> CVarFurCombParallel(
+	TEXT("gFur.ParallelComb"),
+	1,
+	TEXT("Whether comb modes process splines under the brush in parallel, results are the same either way.\n")
+	TEXT(" 0: single thread\n")
+	TEXT(" 1: parallel (default)"));
+
+// splines combed by one task, smaller brushes are combed on the calling thread
+static const int32 CombSplinesPerBatch = 64;
+// roots closer than the tolerance to an existing or just added root are duplicates for CombAdd
+static const float CombAddRootTolerance = 0.1f;
+
 const float FFurComb::MinLayerDist = 0.001f;
 
 FFurComb::FFurComb()
@@ -33,6 +52,7 @@ FFurComb::FFurComb()
 FFurComb::~FFurComb()
 {
 	FCoreUObjectDelegates::OnObjectPropertyChanged.RemoveAll(this);
+	ResetSplinePreviews();
 }
 
 void FFurComb::Init()
@@ -105,6 +125,8 @@ void FFurComb::Tick(FEditorViewportClient* ViewportClient, float DeltaTime)
 
 	Time += DeltaTime;
 	LastDeltaTime = DeltaTime;
+
+	UpdateSplinePreviewVisibility();
 }
 
 void FFurComb::RegisterCommands(TSharedRef<FUICommandList> CommandList)
@@ -208,11 +230,26 @@ void FFurComb::FinishCombing()
 void FFurComb::ActorSelected(AActor* Actor)
 {
 	Actor->GetComponents<UGFurComponent>(FurComponents);
+
+	// acceleration structures are built up front so the first stroke doesn't stall
+	for (UGFurComponent* FurComponent : FurComponents)
+	{
+		GetMeshBVH(FurComponent);
+		GetMeshVertexGrid(FurComponent);
+	}
 }
 
 void FFurComb::ActorDeselected(AActor* Actor)
 {
 	FurComponents.Reset();
+	MeshCaches.Reset();
+	ResetSplinePreviews();
+	RootHashes.Reset();
+}
+
+void FFurComb::Exit()
+{
+	ResetSplinePreviews();
 }
 
 UFurCombSettings* FFurComb::GetCurrentFurCombSettings()
@@ -258,6 +295,9 @@ const FHitResult FFurComb::GetHitResult(const FVector& Origin, const FVector& Di
 
 void FFurComb::PostUndo()
 {
+	// undone strokes restore control points without going through the comb
+	ResetSplinePreviews();
+	RootHashes.Reset();
 }
 
 bool FFurComb::CombInternal(const FVector& InCameraOrigin, const FVector& InRayOrigin, const FVector& InRayDirection, ECombAction CombAction, float StrengthScale)
@@ -363,10 +403,8 @@ bool FFurComb::CombInternal(const FVector& InCameraOrigin, const FVector& InRayO
 			const FTransform InverseComponentTransform = ComponentTransform.Inverse();
 			const FVector ComponentSpaceLocation = InverseComponentTransform.TransformPosition(BestTraceResult.Location);
 			const float ComponentSpaceRadius = InverseComponentTransform.TransformVector(FVector(CombRadius, 0.0f, 0.0f)).Size();
-			const float ComponentSpaceRadiusSquared = ComponentSpaceRadius * ComponentSpaceRadius;
 
 			const FStaticMeshVertexBuffer& Vertices = VertexBuffers->StaticMeshVertexBuffer;
-			int32 VertexCount = Positions.GetNumVertices();
 
 			VertexSet.Reset();
 			SplineSet.Reset();
@@ -388,15 +426,15 @@ bool FFurComb::CombInternal(const FVector& InCameraOrigin, const FVector& InRayO
 			Params.MirrorZ = Settings->bMirrorZ;
 
 
+			const FFurVertexGrid* VertexGrid = GetMeshVertexGrid(FurComponent);
+			if (VertexGrid == nullptr)
+				continue;
+			GatherBrushVertices(*VertexGrid, Positions, Params);
+
 			if (Mode == EFurCombMode::AddRemove && Params.Strength > 0)
 			{
-				for (int32 VertexIndex = 0; VertexIndex < VertexCount; VertexIndex++)
+				for (uint32 VertexIndex : BrushVertices)
 				{
-					const FVector& Position = FVector(Positions.VertexPosition(VertexIndex));
-					FVector Location = MirrorVector(ComponentSpaceLocation, Position, Params);
-					if (FVector::DistSquared(Position, Location) > ComponentSpaceRadiusSquared)
-						continue;
-
 					int32 SplineIndex = SplineMap[VertexIndex];
 					if (SplineIndex == -1)
 						VertexSet.Add(VertexIndex);
@@ -404,21 +442,17 @@ bool FFurComb::CombInternal(const FVector& InCameraOrigin, const FVector& InRayO
 
 				if (VertexSet.Num())
 				{
-					CombAdd(FurSplines, Positions, VertexNormals);
 					FurSplines->Modify();
+					int32 OldSplineCount = FurSplines->SplineCount();
+					CombAdd(FurSplines, Positions, VertexNormals);
 					bCombApplied = true;
-					FurSplines->OnSplinesChanged.Broadcast();
+					FurSplines->OnSplinesAddedRemoved.Broadcast(TArray<int32>(), FurSplines->SplineCount() - OldSplineCount);
 				}
 			}
 			else
 			{
-				for (int32 VertexIndex = 0; VertexIndex < VertexCount; VertexIndex++)
+				for (uint32 VertexIndex : BrushVertices)
 				{
-					const FVector& Position = FVector(Positions.VertexPosition(VertexIndex));
-					FVector Location = MirrorVector(ComponentSpaceLocation, Position, Params);
-					if (FVector::DistSquared(Position, Location) > ComponentSpaceRadiusSquared)
-						continue;
-
 					int32 SplineIndex = SplineMap[VertexIndex];
 					if (SplineIndex != -1)
 					{
@@ -435,44 +469,29 @@ bool FFurComb::CombInternal(const FVector& InCameraOrigin, const FVector& InRayO
 
 				if (SplineSet.Num())
 				{
-					bool fullBuild = false;
-					FurSplines->Modify();
-					switch (Mode)
+					bool addRemove = false;
+					// removed splines change the layout of all control points, other modes keep only the touched ones for undo
+					if (Mode == EFurCombMode::AddRemove)
+						FurSplines->Modify();
+					else
+						RecordStrokeSplines(FurSplines);
+					if (Mode == EFurCombMode::AddRemove)
 					{
-					case EFurCombMode::Length:
-						CombLength(FurSplines, Params);
-						break;
-					case EFurCombMode::AverageLength:
-						CombAverageLength(FurSplines, Params);
-						break;
-					case EFurCombMode::Bend:
-						CombBend(FurSplines, Params);
-						break;
-					case EFurCombMode::Clump:
-						CombClump(FurSplines, Params);
-						break;
-					case EFurCombMode::Twist:
-						CombTwist(FurSplines, Params);
-						break;
-					case EFurCombMode::Noise:
-						CombNoise(FurSplines, Params);
-						break;
-					case EFurCombMode::Curl:
-						CombCurl(FurSplines, Params);
-						break;
-					case EFurCombMode::Relax:
-						CombRelax(FurSplines, Params);
-						break;
-					case EFurCombMode::AddRemove:
 						CombRemove(FurSplines);
-						fullBuild = true;
-						break;
+						addRemove = true;
+					}
+					else
+					{
+						CombSplineSet(Mode, FurSplines, Params);
 					}
 					bCombApplied = true;
-					if (fullBuild)
-						FurSplines->OnSplinesChanged.Broadcast();
+					if (addRemove)
+						FurSplines->OnSplinesAddedRemoved.Broadcast(CombSplines, 0);
 					else
+					{
 						FurSplines->OnSplinesCombed.Broadcast(VertexSet);
+						UpdateSplinePreviews(FurSplines);
+					}
 				}
 			}
 		}
@@ -486,6 +505,7 @@ void FFurComb::RenderInteractors(const FSceneView* View, FViewport* Viewport, FP
 {
 	TArray<MeshPaintHelpers::FPaintRay> PaintRays;
 	MeshPaintHelpers::RetrieveViewportPaintRays(View, Viewport, PDI, PaintRays);
+	HasBrushLocation = false;
 
 	// Apply paint pressure and start painting (or if not currently painting, draw a preview of where paint will be applied)
 	for (const MeshPaintHelpers::FPaintRay& PaintRay : PaintRays)
@@ -518,6 +538,9 @@ void FFurComb::RenderInteractorWidget(const FVector& InRayOrigin, const FVector&
 		HitResult.Normal.FindBestAxisVectors(BrushXAxis, BrushYAxis);
 		const FVector CombVisualPosition = HitResult.Location + HitResult.Normal * VisualBiasDistance;
 
+		BrushLocation = HitResult.Location;
+		HasBrushLocation = true;
+
 		if (PDI != NULL)
 		{
 			const int32 NumSides = 128;
@@ -536,28 +559,154 @@ void FFurComb::RenderInteractorWidget(const FVector& InRayOrigin, const FVector&
 
 void FFurComb::RenderSplines(const FSceneView* View, FViewport* Viewport, FPrimitiveDrawInterface* PDI, ESceneDepthPriorityGroup DepthGroup)
 {
+	// all splines are drawn by the preview components, only the few under the brush are drawn here
+	const UFurCombSettings* Settings = GetCurrentFurCombSettings();
+	if (!Settings->bShowSplinesUnderBrushOnly || !HasBrushLocation)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_FurCombSplineDisplay);
+
 	const FColor Color = FColor::Red;
+	const float DecimationDistance = Settings->SplineDecimationDistance;
+	const float BrushRadius = Settings->GetRadius();
+	const FVector ViewOrigin = View->ViewMatrices.GetViewOrigin();
 
+	int32 NumLines = 0;
+	int32 NumSkippedLines = 0;
 	for (UGFurComponent* FurComponent : FurComponents)
 	{
-		auto* Splines = FurComponent->FurSplines;
-		if (Splines)
+		if (!FurComponent->FurSplines)
+			continue;
+
+		const UFurSplinePreviewComponent* Preview = GetSplinePreview(FurComponent);
+		if (!Preview->IsUpToDate())
+			continue;
+
+		const UFurSplines* Splines = Preview->GetSplines();
+		const FTransform& Transform = FurComponent->GetComponentTransform();
+		const FBox BrushBounds = FBox::BuildAABB(BrushLocation, FVector(BrushRadius)).InverseTransformBy(Transform);
+		const int32 Count = Splines->ControlPointCount;
+		const int32 SplineCount = Splines->SplineCount();
+		const TArray<FBox>& ChunkBounds = Preview->GetChunkBounds();
+		for (int32 ChunkIndex = 0; ChunkIndex < ChunkBounds.Num(); ChunkIndex++)
 		{
-			int32 Count = Splines->ControlPointCount;
-			const auto& Transform = FurComponent->GetComponentTransform();
-			for (int i = 0, c = Splines->SplineCount(); i < c; i++)
+			const int32 Begin = ChunkIndex * UFurSplinePreviewComponent::ChunkSize;
+			const int32 End = FMath::Min(Begin + UFurSplinePreviewComponent::ChunkSize, SplineCount);
+			if (!ChunkBounds[ChunkIndex].Intersect(BrushBounds))
 			{
-				int32 Index = i * Count;
-				FVector Prev = Transform.TransformPosition(Splines->Vertices[Index]);
-				for (int j = Index + 1, e = Index + Count; j < e; j++)
+				NumSkippedLines += (End - Begin) * (Count - 1);
+				continue;
+			}
+
+			const FBox Bounds = ChunkBounds[ChunkIndex].TransformBy(Transform);
+			const int32 Stride = UFurSplinePreviewComponent::GetDecimationStride(FMath::Sqrt(Bounds.ComputeSquaredDistanceToPoint(ViewOrigin)), DecimationDistance);
+			for (int32 i = Begin; i < End; i++)
+			{
+				const FVector* Points = &Splines->Vertices[i * Count];
+				if (((i - Begin) % Stride) != 0 || FVector::DistSquared(Transform.TransformPosition(Points[0]), BrushLocation) > BrushRadius * BrushRadius)
+				{
+					NumSkippedLines += Count - 1;
+					continue;
+				}
+				FVector Start = Transform.TransformPosition(Points[0]);
+				for (int32 j = 1; j < Count; j++)
 				{
-					FVector Curr = Transform.TransformPosition(Splines->Vertices[j]);
-					PDI->DrawLine(Prev, Curr, Color, DepthGroup);
-					Prev = Curr;
+					const FVector Next = Transform.TransformPosition(Points[j]);
+					PDI->DrawLine(Start, Next, Color, DepthGroup);
+					Start = Next;
 				}
+				NumLines += Count - 1;
 			}
 		}
 	}
+
+	SET_DWORD_STAT(STAT_FurCombSplineDisplayLines, NumLines);
+	SET_DWORD_STAT(STAT_FurCombSplineDisplaySkippedLines, NumSkippedLines);
+}
+
+UFurSplinePreviewComponent* FFurComb::GetSplinePreview(const UGFurComponent* FurComponent)
+{
+	FSplinePreview& Preview = SplinePreviews.FindOrAdd(FObjectKey(FurComponent));
+	UFurSplines* Splines = FurComponent->FurSplines;
+	if (Preview.Splines != Splines)
+	{
+		if (UFurSplines* OldSplines = Preview.Splines.Get())
+			OldSplines->OnSplinesChanged.Remove(Preview.SplinesChangedHandle);
+		Preview.SplinesChangedHandle = Splines->OnSplinesChanged.AddRaw(this, &FFurComb::InvalidateSplineCaches, static_cast<const UFurSplines*>(Splines));
+		Preview.Splines = Splines;
+	}
+
+	UFurSplinePreviewComponent* Component = Preview.Component.Get();
+	if (!Component)
+	{
+		// owned by the actor to be kept alive, but never saved or shown in the details panel
+		Component = NewObject<UFurSplinePreviewComponent>(FurComponent->GetOwner(), NAME_None, RF_Transient | RF_TextExportTransient);
+		Component->SetIsVisualizationComponent(true);
+		Component->SetWorldTransform(FurComponent->GetComponentTransform());
+		Component->RegisterComponentWithWorld(FurComponent->GetWorld());
+		Preview.Component = Component;
+	}
+
+	const float DecimationDistance = GetCurrentFurCombSettings()->SplineDecimationDistance;
+	if (Component->GetSplines() != Splines || !Component->IsUpToDate() || Component->GetDecimationDistance() != DecimationDistance)
+		Component->SetSplines(Splines, DecimationDistance);
+	const FTransform& Transform = FurComponent->GetComponentTransform();
+	if (!Component->GetComponentTransform().Equals(Transform, 0.0))
+		Component->SetWorldTransform(Transform);
+	return Component;
+}
+
+void FFurComb::UpdateSplinePreviewVisibility()
+{
+	const UFurCombSettings* Settings = GetCurrentFurCombSettings();
+	const bool ShowAll = Settings->bShowSplines && !Settings->bShowSplinesUnderBrushOnly;
+	for (UGFurComponent* FurComponent : FurComponents)
+	{
+		if (ShowAll && FurComponent->FurSplines)
+		{
+			GetSplinePreview(FurComponent)->SetVisibility(true);
+		}
+		else if (const FSplinePreview* Preview = SplinePreviews.Find(FObjectKey(FurComponent)))
+		{
+			if (UFurSplinePreviewComponent* Component = Preview->Component.Get())
+				Component->SetVisibility(false);
+		}
+	}
+}
+
+void FFurComb::UpdateSplinePreviews(const UFurSplines* FurSplines)
+{
+	for (auto& Pair : SplinePreviews)
+	{
+		UFurSplinePreviewComponent* Component = Pair.Value.Component.Get();
+		if (Component && Component->GetSplines() == FurSplines)
+			Component->UpdateSplines(SplineSet);
+	}
+}
+
+void FFurComb::InvalidateSplineCaches(const UFurSplines* FurSplines)
+{
+	RootHashes.Remove(const_cast<UFurSplines*>(FurSplines));
+
+	// regenerated by GetSplinePreview when shown next time
+	for (auto& Pair : SplinePreviews)
+	{
+		UFurSplinePreviewComponent* Component = Pair.Value.Component.Get();
+		if (Component && Component->GetSplines() == FurSplines)
+			Component->SetSplines(nullptr, 0.0f);
+	}
+}
+
+void FFurComb::ResetSplinePreviews()
+{
+	for (auto& Pair : SplinePreviews)
+	{
+		if (UFurSplines* Splines = Pair.Value.Splines.Get())
+			Splines->OnSplinesChanged.Remove(Pair.Value.SplinesChangedHandle);
+		if (UFurSplinePreviewComponent* Component = Pair.Value.Component.Get())
+			Component->DestroyComponent();
+	}
+	SplinePreviews.Reset();
 }
 
 void FFurComb::BeginTransaction(const FText Description)
@@ -574,10 +723,59 @@ void FFurComb::BeginTransaction(const FText Description)
 void FFurComb::EndTransaction()
 {
 	checkf(CombTransaction != NULL, TEXT("Cannot end Transaction since there isn't one Active"));
+	StoreStrokeChanges();
 	delete CombTransaction;
 	CombTransaction = NULL;
 }
 
+void FFurComb::RecordStrokeSplines(UFurSplines* FurSplines)
+{
+	FStrokeSplines& Stroke = StrokeSplines.FindOrAdd(FurSplines);
+	if (Stroke.Splines.Num() == 0)
+		FurSplines->MarkPackageDirty();
+
+	const int32 Cnt = FurSplines->ControlPointCount;
+	for (int32 Index : SplineSet)
+	{
+		bool IsAlreadyInSet;
+		Stroke.SplineSlots.Add(Index, Stroke.Splines.Num(), &IsAlreadyInSet);
+		if (IsAlreadyInSet)
+			continue;
+		Stroke.Splines.Add(Index);
+		Stroke.OldVertices.Append(&FurSplines->Vertices[Index * Cnt], Cnt);
+	}
+	Stroke.CombedVertices.Append(VertexSet);
+}
+
+void FFurComb::StoreStrokeChanges()
+{
+	for (auto& Pair : StrokeSplines)
+	{
+		UFurSplines* FurSplines = Pair.Key.Get();
+		FStrokeSplines& Stroke = Pair.Value;
+		if (FurSplines == nullptr || Stroke.Splines.Num() == 0 || GUndo == nullptr)
+			continue;
+
+		TUniquePtr<FFurSplinesCombChange> Change = MakeStrokeChange(FurSplines, Stroke);
+		UE_LOG(GFurEditor, Verbose, TEXT("%s stored %llu bytes of undo."), *Change->ToString(), (uint64)Change->GetAllocatedSize());
+		GUndo->StoreUndo(FurSplines, MoveTemp(Change));
+	}
+	StrokeSplines.Reset();
+}
+
+TUniquePtr<FFurSplinesCombChange> FFurComb::MakeStrokeChange(UFurSplines* FurSplines, FStrokeSplines& Stroke)
+{
+	const int32 Cnt = FurSplines->ControlPointCount;
+	TArray<FVector> NewVertices;
+	NewVertices.Reserve(Stroke.OldVertices.Num());
+	for (int32 Index : Stroke.Splines)
+		NewVertices.Append(&FurSplines->Vertices[Index * Cnt], Cnt);
+
+	TArray<uint32> CombedVertices = Stroke.CombedVertices.Array();
+	CombedVertices.Sort();
+	return MakeUnique<FFurSplinesCombChange>(Cnt, MoveTemp(Stroke.Splines), MoveTemp(Stroke.OldVertices), MoveTemp(NewVertices), MoveTemp(CombedVertices));
+}
+
 bool FFurComb::LineTraceComponent(struct FHitResult& OutHit, const FVector Start, const FVector End, const struct FCollisionQueryParams& Params, UGFurComponent* FurComponent) const
 {
 	const bool bHitBounds = FMath::LineSphereIntersection(Start, End.GetSafeNormal(), (End - Start).SizeSquared(), FurComponent->Bounds.Origin, FurComponent->Bounds.SphereRadius);
@@ -587,7 +785,6 @@ bool FFurComb::LineTraceComponent(struct FHitResult& OutHit, const FVector Start
 	bool bHitTriangle = false;
 	if (bHitBounds || bInsideBounds)
 	{
-		float MinDistance = FLT_MAX;
 		FVector Intersect;
 		FVector Normal;
 
@@ -596,92 +793,133 @@ bool FFurComb::LineTraceComponent(struct FHitResult& OutHit, const FVector Start
 		const FVector LocalStart = InverseComponentTransform.TransformPosition(Start);
 		const FVector LocalEnd = InverseComponentTransform.TransformPosition(End);
 
-		if (FurComponent->SkeletalGrowMesh)
+		const FFurMeshBVH* MeshBVH = GetMeshBVH(FurComponent);
+		if (MeshBVH && MeshBVH->LineTrace(LocalStart, LocalEnd, Intersect, Normal))
 		{
-			USkeletalMesh* Mesh = FurComponent->SkeletalGrowMesh;
-			FSkeletalMeshRenderData* RenderData = Mesh->GetResourceForRendering();
-			auto* IndexBuffer = RenderData->LODRenderData[0].MultiSizeIndexContainer.GetIndexBuffer();
-			auto& VertexBuffer = RenderData->LODRenderData[0].StaticVertexBuffers.PositionVertexBuffer;
-			const int32 NumTriangles = IndexBuffer->Num() / 3;
-
-			for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
-			{
-				// Compute the normal of the triangle
-				const FVector& P0 = FVector(VertexBuffer.VertexPosition(IndexBuffer->Get((TriangleIndex * 3) + 0)));
-				const FVector& P1 = FVector(VertexBuffer.VertexPosition(IndexBuffer->Get((TriangleIndex * 3) + 1)));
-				const FVector& P2 = FVector(VertexBuffer.VertexPosition(IndexBuffer->Get((TriangleIndex * 3) + 2)));
-
-				const FVector TriNorm = (P1 - P0) ^ (P2 - P0);
+			OutHit.Component = FurComponent;
+			OutHit.Normal = Normal.GetSafeNormal();
+			OutHit.Location = ComponentTransform.TransformPosition(Intersect);
+			OutHit.bBlockingHit = true;
+			bHitTriangle = true;
+		}
+	}
 
-				//check collinearity of A,B,C
-				if (TriNorm.SizeSquared() > SMALL_NUMBER)
-				{
-					FVector IntersectPoint;
-					FVector HitNormal;
-					bool bHit = FMath::SegmentTriangleIntersection(LocalStart, LocalEnd, P0, P1, P2, IntersectPoint, HitNormal);
+	return bHitTriangle;
+}
 
-					if (bHit)
-					{
-						const float Distance = (LocalStart - IntersectPoint).SizeSquared();
-						if (Distance < MinDistance)
-						{
-							MinDistance = Distance;
-							Intersect = IntersectPoint;
-							Normal = HitNormal;
-						}
-					}
-				}
-			}
-		}
-		else
-		{
-			UStaticMesh* Mesh = FurComponent->StaticGrowMesh;
-			auto& IndexBuffer = Mesh->GetRenderData()->LODResources[0].IndexBuffer;
-			auto& VertexBuffer = Mesh->GetRenderData()->LODResources[0].VertexBuffers.PositionVertexBuffer;
+const FFurMeshBVH* FFurComb::GetMeshBVH(const UGFurComponent* FurComponent) const
+{
+	const UObject* Mesh = nullptr;
+	int32 NumIndices = 0;
+	if (FurComponent->SkeletalGrowMesh)
+	{
+		Mesh = FurComponent->SkeletalGrowMesh;
+		FSkeletalMeshRenderData* RenderData = FurComponent->SkeletalGrowMesh->GetResourceForRendering();
+		if (!RenderData || RenderData->LODRenderData.Num() == 0)
+			return nullptr;
+		NumIndices = RenderData->LODRenderData[0].MultiSizeIndexContainer.GetIndexBuffer()->Num();
+	}
+	else if (FurComponent->StaticGrowMesh)
+	{
+		Mesh = FurComponent->StaticGrowMesh;
+		FStaticMeshRenderData* RenderData = FurComponent->StaticGrowMesh->GetRenderData();
+		if (!RenderData || RenderData->LODResources.Num() == 0)
+			return nullptr;
+		NumIndices = RenderData->LODResources[0].IndexBuffer.GetNumIndices();
+	}
+	else
+	{
+		return nullptr;
+	}
 
-			const int32 NumTriangles = IndexBuffer.GetNumIndices() / 3;
+	TSharedPtr<FFurMeshBVH>& MeshBVH = MeshCaches.FindOrAdd(FObjectKey(Mesh)).BVH;
+	if (MeshBVH.IsValid() && MeshBVH->GetNumSourceIndices() == NumIndices)
+		return MeshBVH.Get();
 
-			for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
-			{
-				// Compute the normal of the triangle
-				const FVector& P0 = FVector(VertexBuffer.VertexPosition(IndexBuffer.GetIndex((TriangleIndex * 3) + 0)));
-				const FVector& P1 = FVector(VertexBuffer.VertexPosition(IndexBuffer.GetIndex((TriangleIndex * 3) + 1)));
-				const FVector& P2 = FVector(VertexBuffer.VertexPosition(IndexBuffer.GetIndex((TriangleIndex * 3) + 2)));
+	MeshBVH = MakeShared<FFurMeshBVH>();
+	if (FurComponent->SkeletalGrowMesh)
+	{
+		FSkeletalMeshLODRenderData& LODRenderData = FurComponent->SkeletalGrowMesh->GetResourceForRendering()->LODRenderData[0];
+		auto* IndexBuffer = LODRenderData.MultiSizeIndexContainer.GetIndexBuffer();
+		MeshBVH->Build(LODRenderData.StaticVertexBuffers.PositionVertexBuffer, NumIndices, [IndexBuffer](int32 Index) { return IndexBuffer->Get(Index); });
+	}
+	else
+	{
+		FStaticMeshLODResources& LODResources = FurComponent->StaticGrowMesh->GetRenderData()->LODResources[0];
+		const FRawStaticIndexBuffer& IndexBuffer = LODResources.IndexBuffer;
+		MeshBVH->Build(LODResources.VertexBuffers.PositionVertexBuffer, NumIndices, [&IndexBuffer](int32 Index) { return IndexBuffer.GetIndex(Index); });
+	}
+	return MeshBVH.Get();
+}
 
-				const FVector TriNorm = (P1 - P0) ^ (P2 - P0);
+const FFurVertexGrid* FFurComb::GetMeshVertexGrid(const UGFurComponent* FurComponent) const
+{
+	const UObject* Mesh = nullptr;
+	const FPositionVertexBuffer* Positions = nullptr;
+	if (FurComponent->SkeletalGrowMesh)
+	{
+		Mesh = FurComponent->SkeletalGrowMesh;
+		FSkeletalMeshRenderData* RenderData = FurComponent->SkeletalGrowMesh->GetResourceForRendering();
+		if (!RenderData || RenderData->LODRenderData.Num() == 0)
+			return nullptr;
+		Positions = &RenderData->LODRenderData[0].StaticVertexBuffers.PositionVertexBuffer;
+	}
+	else if (FurComponent->StaticGrowMesh)
+	{
+		Mesh = FurComponent->StaticGrowMesh;
+		FStaticMeshRenderData* RenderData = FurComponent->StaticGrowMesh->GetRenderData();
+		if (!RenderData || RenderData->LODResources.Num() == 0)
+			return nullptr;
+		Positions = &RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer;
+	}
+	else
+	{
+		return nullptr;
+	}
 
-				//check collinearity of A,B,C
-				if (TriNorm.SizeSquared() > SMALL_NUMBER)
-				{
-					FVector IntersectPoint;
-					FVector HitNormal;
-					bool bHit = FMath::SegmentTriangleIntersection(LocalStart, LocalEnd, P0, P1, P2, IntersectPoint, HitNormal);
+	TSharedPtr<FFurVertexGrid>& VertexGrid = MeshCaches.FindOrAdd(FObjectKey(Mesh)).VertexGrid;
+	if (!VertexGrid.IsValid() || VertexGrid->GetNumVertices() != (int32)Positions->GetNumVertices())
+	{
+		VertexGrid = MakeShared<FFurVertexGrid>();
+		VertexGrid->Build(*Positions);
+	}
+	return VertexGrid.Get();
+}
 
-					if (bHit)
-					{
-						const float Distance = (LocalStart - IntersectPoint).SizeSquared();
-						if (Distance < MinDistance)
-						{
-							MinDistance = Distance;
-							Intersect = IntersectPoint;
-							Normal = HitNormal;
-						}
-					}
-				}
-			}
-		}
+void FFurComb::GatherBrushVertices(const FFurVertexGrid& VertexGrid, const FPositionVertexBuffer& Positions, const CombParams& Params)
+{
+	const float RadiusSquared = Params.CombRadius * Params.CombRadius;
 
-		if (MinDistance != FLT_MAX)
+	// The brush is mirrored into the octant of every vertex, so each mirrored brush gathers only vertices of its own octant
+	// and none is gathered twice. Mirroring a zero coordinate gives the same brush, it's skipped.
+	BrushVertices.Reset();
+	for (int32 Mirror = 0; Mirror < 8; Mirror++)
+	{
+		if (((Mirror & 1) && (!Params.MirrorX || Params.Location.X == 0.0))
+			|| ((Mirror & 2) && (!Params.MirrorY || Params.Location.Y == 0.0))
+			|| ((Mirror & 4) && (!Params.MirrorZ || Params.Location.Z == 0.0)))
+			continue;
+
+		const FVector Location((Mirror & 1) ? -Params.Location.X : Params.Location.X, (Mirror & 2) ? -Params.Location.Y : Params.Location.Y,
+			(Mirror & 4) ? -Params.Location.Z : Params.Location.Z);
+		BrushCandidates.Reset();
+		VertexGrid.GatherCandidates(Location, Params.CombRadius, BrushCandidates);
+		for (uint32 VertexIndex : BrushCandidates)
 		{
-			OutHit.Component = FurComponent;
-			OutHit.Normal = Normal.GetSafeNormal();
-			OutHit.Location = ComponentTransform.TransformPosition(Intersect);
-			OutHit.bBlockingHit = true;
-			bHitTriangle = true;
+			const FVector& Position = FVector(Positions.VertexPosition(VertexIndex));
+			if (MirrorVector(Params.Location, Position, Params) != Location || FVector::DistSquared(Position, Location) > RadiusSquared)
+				continue;
+			BrushVertices.Add(VertexIndex);
 		}
 	}
 
-	return bHitTriangle;
+	// same order as when all vertices were tested
+	BrushVertices.Sort();
+}
+
+void FFurComb::InvalidateMeshCache(const UObject* Mesh)
+{
+	MeshCaches.Remove(FObjectKey(Mesh));
 }
 
 FVector FFurComb::MirrorVector(const FVector& Vec, const FVector& Vertex, const CombParams& Params)
@@ -710,13 +948,25 @@ FVector FFurComb::BendFur(const FVector& Dir, const FVector& Normal, const FVect
 	return Normal * MinLayerDist + v;
 }
 
+void FFurComb::GatherCombSplines()
+{
+	CombSplines.Reset(SplineSet.Num());
+	for (int32 Index : SplineSet)
+		CombSplines.Add(Index);
+}
+
 template<bool UseStrengthHeight, typename F, typename G>
 void FFurComb::Comb(UFurSplines* FurSplines, const CombParams& Params, const F& FuncPerSpline, const G& FuncPerSegment)
 {
 	const float RcpCombRadius = 1.0f / Params.CombRadius;
 	const float RcpInvFalloff = 1.0f / (1.0f - Params.Falloff);
-	for (int32 Index : SplineSet)
+
+	// splines are combed independently, every one writes only its own control points
+	GatherCombSplines();
+	const EParallelForFlags Flags = CVarFurCombParallel.GetValueOnGameThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+	ParallelFor(TEXT("FurComb"), CombSplines.Num(), CombSplinesPerBatch, [&](int32 SplineIndex)
 	{
+		const int32 Index = CombSplines[SplineIndex];
 		float Strength = Params.Strength;
 		int32 Cnt = FurSplines->ControlPointCount;
 		int32 Idx = Index * Cnt;
@@ -728,7 +978,7 @@ void FFurComb::Comb(UFurSplines* FurSplines, const CombParams& Params, const F&
 		if (D > 0.0f)
 			Strength *= 1.0f - D * RcpInvFalloff;
 		const FVector& Normal = SplineNormals[Index];
-		FuncPerSpline(FPerSplineData{ PrevVertexOld, Normal, Cnt });
+		const auto SplineData = FuncPerSpline(FPerSplineData{ PrevVertexOld, Normal, Cnt });
 		for (int32 i = Idx + 1, End = Idx + Cnt; i < End; i++)
 		{
 			float StrengtHeight = 1.0f;
@@ -747,19 +997,113 @@ void FFurComb::Comb(UFurSplines* FurSplines, const CombParams& Params, const F&
 			FVector Dir = Vertex - PrevVertexOld;
 			PrevVertexOld = Vertex;
 
-			Vertex = PrevVertexNew + FuncPerSegment(FPerSegmentData{ Dir, Normal, Strength * StrengtHeight, Height });
+			Vertex = PrevVertexNew + FuncPerSegment(SplineData, FPerSegmentData{ Dir, Normal, Strength * StrengtHeight, Height });
 			PrevVertexNew = Vertex;
 		}
+	}, Flags);
+}
+
+void FFurComb::CombSplineSet(EFurCombMode InMode, UFurSplines* FurSplines, const CombParams& Params)
+{
+	switch (InMode)
+	{
+	case EFurCombMode::Length:
+		CombLength(FurSplines, Params);
+		break;
+	case EFurCombMode::AverageLength:
+		CombAverageLength(FurSplines, Params);
+		break;
+	case EFurCombMode::Bend:
+		CombBend(FurSplines, Params);
+		break;
+	case EFurCombMode::Clump:
+		CombClump(FurSplines, Params);
+		break;
+	case EFurCombMode::Twist:
+		CombTwist(FurSplines, Params);
+		break;
+	case EFurCombMode::Noise:
+		CombNoise(FurSplines, Params);
+		break;
+	case EFurCombMode::Curl:
+		CombCurl(FurSplines, Params);
+		break;
+	case EFurCombMode::Relax:
+		CombRelax(FurSplines, Params);
+		break;
+	default:
+		break;
 	}
 }
 
+#if WITH_DEV_AUTOMATION_TESTS
+void FFurComb::CombForTest(EFurCombMode InMode, UFurSplines* FurSplines, const TArray<int32>& InSplines, const FTestDab& InDab)
+{
+	SplineSet.Reset();
+	SplineSet.Append(InSplines);
+	if (SplineNormals.Num() < FurSplines->SplineCount())
+		SplineNormals.AddUninitialized(FurSplines->SplineCount() - SplineNormals.Num());
+	for (int32 SplineIndex : InSplines)
+		SplineNormals[SplineIndex] = (FurSplines->GetLastControlPoint(SplineIndex) - FurSplines->GetFirstControlPoint(SplineIndex)).GetSafeNormal();
+
+	CombParams Params;
+	Params.Location = InDab.Location;
+	Params.OldLocation = InDab.OldLocation;
+	Params.Normal = InDab.Normal;
+	Params.CombRadius = InDab.Radius;
+	Params.Strength = InDab.Strength;
+	Params.Falloff = InDab.Falloff;
+	Params.ApplyHeight = InDab.ApplyHeight;
+	Params.ApplySpread = InDab.ApplySpread;
+	Params.TwistCount = InDab.TwistCount;
+	Params.MirrorX = false;
+	Params.MirrorY = false;
+	Params.MirrorZ = false;
+	RecordStrokeSplines(FurSplines);
+	CombSplineSet(InMode, FurSplines, Params);
+}
+
+TUniquePtr<FFurSplinesCombChange> FFurComb::EndStrokeForTest(UFurSplines* FurSplines)
+{
+	TUniquePtr<FFurSplinesCombChange> Change;
+	if (FStrokeSplines* Stroke = StrokeSplines.Find(FurSplines))
+		Change = MakeStrokeChange(FurSplines, *Stroke);
+	StrokeSplines.Reset();
+	return Change;
+}
+
+void FFurComb::AddSplinesForTest(UFurSplines* FurSplines, const FPositionVertexBuffer& Positions, const TArray<FVector>& Normals, const TArray<uint32>& InVertices)
+{
+	VertexSet = InVertices;
+	CombAdd(FurSplines, Positions, Normals);
+}
+
+void FFurComb::RemoveSplinesForTest(UFurSplines* FurSplines, const TArray<int32>& InSplines)
+{
+	SplineSet.Reset();
+	SplineSet.Append(InSplines);
+	CombRemove(FurSplines);
+}
+
+const TArray<uint32>& FFurComb::GatherBrushVerticesForTest(const FFurVertexGrid& VertexGrid, const FPositionVertexBuffer& Positions, const FVector& InLocation, float InRadius, bool InMirrorX, bool InMirrorY, bool InMirrorZ)
+{
+	CombParams Params = {};
+	Params.Location = InLocation;
+	Params.CombRadius = InRadius;
+	Params.MirrorX = InMirrorX;
+	Params.MirrorY = InMirrorY;
+	Params.MirrorZ = InMirrorZ;
+	GatherBrushVertices(VertexGrid, Positions, Params);
+	return BrushVertices;
+}
+#endif // WITH_DEV_AUTOMATION_TESTS
+
 void FFurComb::CombLength(UFurSplines* FurSplines, const CombParams& Params)
 {
 	float TotalSizeDiff = Params.Strength * 10.0f;
-	float SegSizeDiff;
-	Comb<false>(FurSplines, Params, [TotalSizeDiff, &SegSizeDiff](const FPerSplineData& Data) {
-		SegSizeDiff = TotalSizeDiff / (Data.ControlPointCount - 1);
-	}, [&SegSizeDiff](const FPerSegmentData& Data) {
+	Comb<false>(FurSplines, Params, [TotalSizeDiff](const FPerSplineData& Data) {
+		return TotalSizeDiff / (Data.ControlPointCount - 1);
+	}, [](float SegSizeDiff, const FPerSegmentData& Data) {
 		float Size = Data.Dir.Size();
 		float NewSize = FMath::Max(Size + SegSizeDiff, 0.001f);
 		return Data.Dir * (NewSize / Size);
@@ -771,30 +1115,36 @@ void FFurComb::CombAverageLength(UFurSplines* FurSplines, const CombParams& Para
 	float RcpCombRadius = 1.0f / Params.CombRadius;
 	float RcpInvFalloff = 1.0f / (1.0f - Params.Falloff);
 	float Strength = Params.Strength;
-	float LengthSum = 0.0f;
-	float LengthCnt = 0;
-	for (int32 Index : SplineSet)
+	// segment lengths are measured in parallel but summed in the order of the set, the average is bit for bit the serial one
+	GatherCombSplines();
+	const int32 Cnt = FurSplines->ControlPointCount;
+	CombSegmentLengths.SetNumUninitialized(CombSplines.Num() * FMath::Max(Cnt - 1, 0));
+	const EParallelForFlags Flags = CVarFurCombParallel.GetValueOnGameThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+	ParallelFor(TEXT("FurCombGather"), CombSplines.Num(), CombSplinesPerBatch, [&](int32 SplineIndex)
 	{
-		int32 Cnt = FurSplines->ControlPointCount;
-		int32 Idx = Index * Cnt;
+		int32 Idx = CombSplines[SplineIndex] * Cnt;
+		float* SegmentLengths = CombSegmentLengths.GetData() + SplineIndex * (Cnt - 1);
 		FVector3f PrevVertex = FVector3f(FurSplines->Vertices[Idx]);
 		for (int32 i = Idx + 1, End = Idx + Cnt; i < End; i++)
 		{
 			FVector3f Vertex = FVector3f(FurSplines->Vertices[i]);
-			LengthSum += (Vertex - PrevVertex).Size();
+			*SegmentLengths++ = (Vertex - PrevVertex).Size();
 			PrevVertex = Vertex;
 		}
-		LengthCnt += 1.0f;
-	}
+	}, Flags);
+
+	float LengthSum = 0.0f;
+	for (float SegmentLength : CombSegmentLengths)
+		LengthSum += SegmentLength;
+	float LengthCnt = CombSplines.Num();
 
 	if (LengthCnt == 0)
 		return;
 
 	float TargetLength = LengthSum / LengthCnt;
-	float SegmentTargetLength;
-	Comb<false>(FurSplines, Params, [&SegmentTargetLength, TargetLength](const FPerSplineData& Data) {
-		SegmentTargetLength = TargetLength / (Data.ControlPointCount - 1);
-	}, [&SegmentTargetLength](const FPerSegmentData& Data) {
+	Comb<false>(FurSplines, Params, [TargetLength](const FPerSplineData& Data) {
+		return TargetLength / (Data.ControlPointCount - 1);
+	}, [](float SegmentTargetLength, const FPerSegmentData& Data) {
 		float Size = Data.Dir.Size();
 		float Diff = SegmentTargetLength - Size;
 		float NewSize = FMath::Max(Size + Diff * Data.Strength, 0.001f);
@@ -808,39 +1158,36 @@ void FFurComb::CombBend(UFurSplines* FurSplines, const CombParams& Params)
 	if (OrigBendDir.X == 0.0f && OrigBendDir.Y == 0.0f && OrigBendDir.Z == 0.0f)
 		return;
 
-	FVector BendDir;
-	Comb<true>(FurSplines, Params, [&OrigBendDir, &BendDir, &Params](const FPerSplineData& Data) {
-		BendDir = MirrorVector(OrigBendDir, Data.BaseVertex, Params);
-	}, [&BendDir](const FPerSegmentData& Data) {
+	Comb<true>(FurSplines, Params, [&OrigBendDir, &Params](const FPerSplineData& Data) {
+		return MirrorVector(OrigBendDir, Data.BaseVertex, Params);
+	}, [](const FVector& BendDir, const FPerSegmentData& Data) {
 		return BendFur(Data.Dir, Data.Normal, BendDir * Data.Strength * 5.0f);
 	});
 }
 
 void FFurComb::CombClump(UFurSplines* FurSplines, const CombParams& Params)
 {
-	FVector BendDir;
-	Comb<true>(FurSplines, Params, [&Params, &BendDir](const FPerSplineData& Data) {
-		BendDir = MirrorVector(Params.Location, Data.BaseVertex, Params) - Data.BaseVertex;
-	}, [&BendDir](const FPerSegmentData& Data) {
+	Comb<true>(FurSplines, Params, [&Params](const FPerSplineData& Data) {
+		return MirrorVector(Params.Location, Data.BaseVertex, Params) - Data.BaseVertex;
+	}, [](const FVector& BendDir, const FPerSegmentData& Data) {
 		return BendFur(Data.Dir, Data.Normal, BendDir * Data.Strength * 0.1f);
 	});
 }
 
 void FFurComb::CombTwist(UFurSplines* FurSplines, const CombParams& Params)
 {
-	FVector BendDir;
-	Comb<true>(FurSplines, Params, [&Params, &BendDir](const FPerSplineData& Data) {
-		BendDir = FVector::CrossProduct(MirrorVector(Params.Location, Data.BaseVertex, Params) - Data.BaseVertex, Params.Normal);
-		BendDir = MirrorVector(BendDir, Data.BaseVertex, Params);
-	}, [&BendDir](const FPerSegmentData& Data) {
+	Comb<true>(FurSplines, Params, [&Params](const FPerSplineData& Data) {
+		FVector BendDir = FVector::CrossProduct(MirrorVector(Params.Location, Data.BaseVertex, Params) - Data.BaseVertex, Params.Normal);
+		return MirrorVector(BendDir, Data.BaseVertex, Params);
+	}, [](const FVector& BendDir, const FPerSegmentData& Data) {
 		return BendFur(Data.Dir, Data.Normal, BendDir * Data.Strength * 0.1f);
 	});
 }
 
 void FFurComb::CombNoise(UFurSplines* FurSplines, const CombParams& Params)
 {
-	FVector BendDir;
-	Comb<true>(FurSplines, Params, [&Params, &BendDir](const FPerSplineData& Data) {
+	Comb<true>(FurSplines, Params, [](const FPerSplineData& Data) {
+		FVector BendDir;
 		BendDir.X = FMath::Sin(Data.BaseVertex.X * 50.0f) + FMath::Sin(Data.BaseVertex.Y * 35.0f) + FMath::Sin(Data.BaseVertex.Z * 96.0f);
 		BendDir.X += FMath::Sin(Data.Normal.X * 122.0f) + FMath::Sin(Data.Normal.Y * 67.0f) + FMath::Sin(Data.Normal.Z * 16.0f);
 
@@ -849,7 +1196,8 @@ void FFurComb::CombNoise(UFurSplines* FurSplines, const CombParams& Params)
 
 		BendDir.Z = FMath::Sin(Data.BaseVertex.X * 88.0f) + FMath::Sin(Data.BaseVertex.Y * 47.0f) + FMath::Sin(Data.BaseVertex.Z * 94.0f);
 		BendDir.Z += FMath::Sin(Data.Normal.X * 42.0f) + FMath::Sin(Data.Normal.Y * 21.0f) + FMath::Sin(Data.Normal.Z * 74.0f);
-	}, [&BendDir](const FPerSegmentData& Data) {
+		return BendDir;
+	}, [](const FVector& BendDir, const FPerSegmentData& Data) {
 		return BendFur(Data.Dir, Data.Normal, BendDir * Data.Strength * 0.2f);
 	});
 }
@@ -857,7 +1205,8 @@ void FFurComb::CombNoise(UFurSplines* FurSplines, const CombParams& Params)
 void FFurComb::CombCurl(UFurSplines* FurSplines, const CombParams& Params)
 {
 	Comb<true>(FurSplines, Params, [](const FPerSplineData& Data) {
-	}, [&Params](const FPerSegmentData& Data) {
+		return 0;
+	}, [&Params](int32, const FPerSegmentData& Data) {
 		FVector v = FMath::Abs(Data.Normal.X) < 0.707f ? FVector(1, 0, 0) : FVector(0, 1, 0);
 		FVector u = FVector::CrossProduct(v, Data.Normal);
 		u.Normalize();
@@ -872,7 +1221,8 @@ void FFurComb::CombCurl(UFurSplines* FurSplines, const CombParams& Params)
 void FFurComb::CombRelax(UFurSplines* FurSplines, const CombParams& Params)
 {
 	Comb<true>(FurSplines, Params, [](const FPerSplineData& Data) {
-	}, [](const FPerSegmentData& Data) {
+		return 0;
+	}, [](int32, const FPerSegmentData& Data) {
 		float Size = Data.Dir.Size();
 		FVector Dest = Data.Normal * Size;
 		FVector BendDir = Dest - Data.Dir;
@@ -880,23 +1230,59 @@ void FFurComb::CombRelax(UFurSplines* FurSplines, const CombParams& Params)
 	});
 }
 
+// cells as large as the tolerance keep all roots closer than the tolerance in the neighbouring cells
+static FIntVector GetRootCell(const FVector& p)
+{
+	return FIntVector(FMath::FloorToInt(p.X / CombAddRootTolerance), FMath::FloorToInt(p.Y / CombAddRootTolerance), FMath::FloorToInt(p.Z / CombAddRootTolerance));
+}
+
+FFurComb::FRootHash& FFurComb::GetRootHash(UFurSplines* FurSplines)
+{
+	FRootHash& RootHash = RootHashes.FindOrAdd(FurSplines);
+	const int32 SplineCount = FurSplines->SplineCount();
+	if (RootHash.SplineCount != SplineCount)
+	{
+		RootHash.Roots.Reset();
+		for (int32 i = 0; i < SplineCount; i++)
+		{
+			FVector Root = FurSplines->GetFirstControlPoint(i);
+			RootHash.Roots.Add(GetRootCell(Root), Root);
+		}
+		RootHash.SplineCount = SplineCount;
+	}
+	return RootHash;
+}
+
 void FFurComb::CombAdd(UFurSplines* FurSplines, const FPositionVertexBuffer& Positions, const TArray<FVector>& Normals)
 {
 	auto& Vertices = FurSplines->Vertices;
 	int32 Count = FurSplines->ControlPointCount;
 	const float Length = 1.0f;
-	int32 OldSplineCount = FurSplines->SplineCount();
-	int32 NewSplineCount = OldSplineCount;
+
+	FRootHash& RootHash = GetRootHash(FurSplines);
+	TMultiMap<FIntVector, FVector>& Roots = RootHash.Roots;
+
+	Vertices.Reserve(Vertices.Num() + VertexSet.Num() * Count);
 	for (uint32 VertexIndex : VertexSet)
 	{
 		FVector v = FVector(Positions.VertexPosition(VertexIndex));
+		FIntVector Cell = GetRootCell(v);
 		bool found = false;
-		for (int32 i = OldSplineCount; i < NewSplineCount; i++)
+		for (int32 z = -1; z <= 1 && !found; z++)
 		{
-			if (FVector::DistSquared(v, Vertices[i * Count]) <= 0.01f)
+			for (int32 y = -1; y <= 1 && !found; y++)
 			{
-				found = true;
-				break;
+				for (int32 x = -1; x <= 1 && !found; x++)
+				{
+					for (auto It = Roots.CreateConstKeyIterator(Cell + FIntVector(x, y, z)); It; ++It)
+					{
+						if (FVector::DistSquared(v, It.Value()) <= CombAddRootTolerance * CombAddRootTolerance)
+						{
+							found = true;
+							break;
+						}
+					}
+				}
 			}
 		}
 
@@ -910,36 +1296,43 @@ void FFurComb::CombAdd(UFurSplines* FurSplines, const FPositionVertexBuffer& Pos
 				float t = i / (float)(Count - 1);
 				Vertices[s + i] = v + n * t * Length;
 			}
+			Roots.Add(Cell, v);
 		}
 	}
+	RootHash.SplineCount = FurSplines->SplineCount();
 }
 
 void FFurComb::CombRemove(UFurSplines* FurSplines)
 {
-	auto SplineIterator = SplineSet.CreateConstIterator();
+	// removed splines in ascending order, splines between two of them move down together
+	CombSplines.Reset(SplineSet.Num());
+	for (int32 Index : SplineSet)
+		CombSplines.Add(Index);
+	CombSplines.Sort();
 
-	auto& Vertices = FurSplines->Vertices;
-	uint32 Count = FurSplines->ControlPointCount;
-	uint32 Dst = *SplineIterator * Count;
-	for (int32 i = *SplineIterator, SplineCount = FurSplines->SplineCount(); i < SplineCount; i++)
+	if (FRootHash* RootHash = RootHashes.Find(FurSplines))
 	{
-		if (i != *SplineIterator)
+		if (RootHash->SplineCount == FurSplines->SplineCount())
 		{
-			int32 Offset = i * Count;
-			for (int32 j = Offset, e = Offset + Count; j < e; j++)
-				Vertices[Dst++] = Vertices[j];
-		}
-		else
-		{
-			if (!(++SplineIterator))
+			for (int32 SplineIndex : CombSplines)
 			{
-				int32 Offset = (i + 1) * Count;
-				for (int32 j = Offset, e = Vertices.Num(); j < e; j++)
-					Vertices[Dst++] = Vertices[j];
-				break;
+				const FVector Root = FurSplines->GetFirstControlPoint(SplineIndex);
+				RootHash->Roots.RemoveSingle(GetRootCell(Root), Root);
 			}
+			RootHash->SplineCount -= CombSplines.Num();
 		}
 	}
+
+	auto& Vertices = FurSplines->Vertices;
+	int32 Count = FurSplines->ControlPointCount;
+	int32 Dst = CombSplines[0] * Count;
+	for (int32 i = 0; i < CombSplines.Num(); i++)
+	{
+		int32 Begin = (CombSplines[i] + 1) * Count;
+		int32 End = i + 1 < CombSplines.Num() ? CombSplines[i + 1] * Count : Vertices.Num();
+		for (int32 j = Begin; j < End; j++)
+			Vertices[Dst++] = Vertices[j];
+	}
 	Vertices.SetNum(Dst);
 }
 
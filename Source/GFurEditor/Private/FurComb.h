@@ -7,6 +7,7 @@
 #include "Engine/EngineTypes.h"
 #include "Engine/EngineBaseTypes.h"
 #include "InputCoreTypes.h"
+#include "UObject/ObjectKey.h"
 
 class UFurCombSettings;
 class UMeshComponent;
@@ -22,6 +23,10 @@ class FEditorViewportClient;
 class FSceneView;
 class AActor;
 class SFurCombModeWidget;
+class FFurMeshBVH;
+class FFurVertexGrid;
+class FPositionVertexBuffer;
+class UFurSplinePreviewComponent;
 
 enum class ECombAction
 {
@@ -87,6 +92,8 @@ public:
 	void ActorSelected(AActor* Actor);
 	/** Is called by the owning EdMode when an actor is selected in the viewport */
 	void ActorDeselected(AActor* Actor);
+	/** Is called by the owning EdMode when the mode is left, removes spline previews from the scene */
+	void Exit();
 
 	/** Tries to retrieves a valid mesh adapter for the given component (derived painters can cache these hence no base implementation) */
 //	TSharedPtr<IMeshPaintGeometryAdapter> GetMeshAdapterForComponent(const UMeshComponent* Component);//TODO
@@ -105,7 +112,36 @@ public:
 
 	void PostUndo();
 
+	/** Drops acceleration structures of a grow mesh, called when the mesh is (re)imported. */
+	void InvalidateMeshCache(const UObject* Mesh);
+
 	void SetMode(EFurCombMode InMode) { Mode = InMode; }
+
+#if WITH_DEV_AUTOMATION_TESTS
+	/** Brush dab in the space of the splines. */
+	struct FTestDab
+	{
+		FVector Location;
+		FVector OldLocation;
+		FVector Normal;
+		float Radius;
+		float Strength;
+		float Falloff;
+		float ApplyHeight;
+		float ApplySpread;
+		float TwistCount;
+	};
+	/** Combs InSplines with a comb mode other than AddRemove like a dab of the brush, normals point along the splines. */
+	void CombForTest(EFurCombMode InMode, UFurSplines* FurSplines, const TArray<int32>& InSplines, const FTestDab& InDab);
+	/** Returns the undo record of the dabs combed since the last call, like the one stored when a stroke ends. */
+	TUniquePtr<class FFurSplinesCombChange> EndStrokeForTest(UFurSplines* FurSplines);
+	/** Adds splines to InVertices which don't have a root within the tolerance yet, like a dab of the AddRemove mode. */
+	void AddSplinesForTest(UFurSplines* FurSplines, const FPositionVertexBuffer& Positions, const TArray<FVector>& Normals, const TArray<uint32>& InVertices);
+	/** Removes splines like a dab of the AddRemove mode with negative strength. */
+	void RemoveSplinesForTest(UFurSplines* FurSplines, const TArray<int32>& InSplines);
+	/** Gathers vertices under the brush like a dab, mirrored brushes included, sorted by index. */
+	const TArray<uint32>& GatherBrushVerticesForTest(const FFurVertexGrid& VertexGrid, const FPositionVertexBuffer& Positions, const FVector& InLocation, float InRadius, bool InMirrorX, bool InMirrorY, bool InMirrorZ);
+#endif // WITH_DEV_AUTOMATION_TESTS
 	EFurCombMode GetMode() const { return Mode; }
 
 protected:
@@ -143,6 +179,22 @@ protected:
 	/** Painting transaction instance which is currently active */
 	FScopedTransaction* CombTransaction;
 
+	/** Control points of splines before the current stroke touched them. */
+	struct FStrokeSplines
+	{
+		TMap<int32, int32> SplineSlots;
+		TArray<int32> Splines;
+		TArray<FVector> OldVertices;
+		TSet<uint32> CombedVertices;
+	};
+	TMap<TWeakObjectPtr<UFurSplines>, FStrokeSplines> StrokeSplines;
+
+	/** Saves control points of splines in SplineSet the stroke didn't touch yet. */
+	void RecordStrokeSplines(UFurSplines* FurSplines);
+	/** Stores changes of the stroke into the current transaction. */
+	void StoreStrokeChanges();
+	static TUniquePtr<class FFurSplinesCombChange> MakeStrokeChange(UFurSplines* FurSplines, FStrokeSplines& Stroke);
+
 private:
 	struct CombParams
 	{
@@ -188,18 +240,81 @@ private:
 	TArray<uint32> VertexSet;
 	TSet<int32> SplineSet;
 	TArray<FVector> SplineNormals;
+	/** SplineSet in its order for parallel combing, sorted by CombRemove. */
+	TArray<int32> CombSplines;
+	/** Segment lengths of CombSplines gathered by CombAverageLength. */
+	TArray<float> CombSegmentLengths;
 
 	/** UI command list object */
 	TSharedPtr<FUICommandList> UICommandList;
 
+	/** Acceleration structures of a grow mesh, built when its components get selected and reused until deselected. */
+	struct FMeshCache
+	{
+		/** Ray casts against triangles of LOD0. */
+		TSharedPtr<FFurMeshBVH> BVH;
+		/** Brush neighbourhoods of vertices of LOD0. */
+		TSharedPtr<FFurVertexGrid> VertexGrid;
+	};
+	mutable TMap<FObjectKey, FMeshCache> MeshCaches;
+
+	/** Editor only component showing splines of a selected fur component, splines under the brush only are drawn by RenderSplines. */
+	struct FSplinePreview
+	{
+		TWeakObjectPtr<UFurSplinePreviewComponent> Component;
+		TWeakObjectPtr<UFurSplines> Splines;
+		/** Invalidates the preview when the splines change outside of the comb, e.g. by a reimport. */
+		FDelegateHandle SplinesChangedHandle;
+	};
+	TMap<FObjectKey, FSplinePreview> SplinePreviews;
+
+	/**
+	 * First control points of splines hashed in cells of the duplicate tolerance of CombAdd. Built on first use and kept up to
+	 * date by CombAdd and CombRemove, so a dab only tests roots near its vertices.
+	 */
+	struct FRootHash
+	{
+		TMultiMap<FIntVector, FVector> Roots;
+		/** Number of splines the hash is up to date with, splines added or removed elsewhere rebuild it. */
+		int32 SplineCount = INDEX_NONE;
+	};
+	TMap<TWeakObjectPtr<UFurSplines>, FRootHash> RootHashes;
+	FRootHash& GetRootHash(UFurSplines* FurSplines);
+
+	/** Brush location of the last rendered frame for showing splines under the brush only. */
+	FVector BrushLocation;
+	bool HasBrushLocation = false;
+
+	/** Vertices under the brush sorted by index, gathered by GatherBrushVertices. */
+	TArray<uint32> BrushVertices;
+	TArray<uint32> BrushCandidates;
+
 	bool LineTraceComponent(struct FHitResult& OutHit, const FVector Start, const FVector End, const struct FCollisionQueryParams& Params, UGFurComponent* FurComponent) const;
+	const FFurMeshBVH* GetMeshBVH(const UGFurComponent* FurComponent) const;
+	const FFurVertexGrid* GetMeshVertexGrid(const UGFurComponent* FurComponent) const;
+	void GatherBrushVertices(const FFurVertexGrid& VertexGrid, const FPositionVertexBuffer& Positions, const CombParams& Params);
 
 	static FVector MirrorVector(const FVector& Vec, const FVector& Vertex, const CombParams& Params);
 	static FVector BendFur(const FVector& Dir, const FVector& Normal, const FVector& Offset);
 
+	void GatherCombSplines();
+
+	/** Returns the preview component of a fur component, created or updated when its splines, transform or settings changed. */
+	UFurSplinePreviewComponent* GetSplinePreview(const UGFurComponent* FurComponent);
+	/** Shows preview components of selected fur components when all splines are shown, hides them otherwise. */
+	void UpdateSplinePreviewVisibility();
+	/** Uploads splines in SplineSet to previews of the splines after a comb dab. */
+	void UpdateSplinePreviews(const UFurSplines* FurSplines);
+	/** Forgets previews and root hashes of splines changed outside of the comb. */
+	void InvalidateSplineCaches(const UFurSplines* FurSplines);
+	void ResetSplinePreviews();
+
+	/** FuncPerSpline returns data of a spline passed to FuncPerSegment with every segment, splines are combed in parallel. */
 	template<bool UseStrengthHeight, typename F, typename G>
 	void Comb(UFurSplines* FurSplines, const CombParams& Params, const F& FuncPerSpline, const G& FuncPerSegment);
 
+	/** Combs splines in SplineSet with a comb mode other than AddRemove. */
+	void CombSplineSet(EFurCombMode InMode, UFurSplines* FurSplines, const CombParams& Params);
 	void CombLength(UFurSplines* FurSplines, const CombParams& Params);
 	void CombAverageLength(UFurSplines* FurSplines, const CombParams& Params);
 	void CombBend(UFurSplines* FurSplines, const CombParams& Params);
@@ -131,6 +131,7 @@ void FEdModeFurComb::Exit()
 	}
 
 	/** Reset paint state and unregister commands */
+	FurComb->Exit();
 	if (UsesToolkits())
 	{
 		FurComb->UnregisterCommands(Toolkit->GetToolkitCommands());
@@ -332,10 +333,12 @@ void FEdModeFurComb::OnPostSaveWorld(UWorld* World, FObjectPostSaveContext Objec
 
 void FEdModeFurComb::OnPostImportAsset(UFactory* Factory, UObject* Object)
 {
+	FurComb->InvalidateMeshCache(Object);
 }
 
 void FEdModeFurComb::OnPostReimportAsset(UObject* Object, bool bSuccess)
 {
+	FurComb->InvalidateMeshCache(Object);
 }
 
 void FEdModeFurComb::OnAssetRemoved(const FAssetData& AssetData)
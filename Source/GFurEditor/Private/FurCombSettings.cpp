@@ -19,7 +19,9 @@ UFurCombSettings::UFurCombSettings(const FObjectInitializer& ObjectInitializer)
 	bMirrorX(false),
 	bMirrorY(false),
 	bMirrorZ(false),
-	bShowSplines(false)
+	bShowSplines(false),
+	bShowSplinesUnderBrushOnly(false),
+	SplineDecimationDistance(0.0f)
 {
 	RadiusMin = 0.01f, RadiusMax = 250.0f;
 
@@ -49,6 +51,8 @@ void UFurCombSettings::Load()
 	GConfig->GetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorY"), bMirrorY, GEditorPerProjectIni);
 	GConfig->GetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorZ"), bMirrorZ, GEditorPerProjectIni);
 	GConfig->GetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplines"), bShowSplines, GEditorPerProjectIni);
+	GConfig->GetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplinesUnderBrushOnly"), bShowSplinesUnderBrushOnly, GEditorPerProjectIni);
+	GConfig->GetFloat(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombSplineDecimationDistance"), SplineDecimationDistance, GEditorPerProjectIni);
 }
 
 void UFurCombSettings::DeleteFromConfig()
@@ -64,6 +68,8 @@ void UFurCombSettings::DeleteFromConfig()
 	GConfig->RemoveKey(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorY"), GEditorPerProjectIni);
 	GConfig->RemoveKey(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorZ"), GEditorPerProjectIni);
 	GConfig->RemoveKey(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplines"), GEditorPerProjectIni);
+	GConfig->RemoveKey(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplinesUnderBrushOnly"), GEditorPerProjectIni);
+	GConfig->RemoveKey(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombSplineDecimationDistance"), GEditorPerProjectIni);
 }
 
 void UFurCombSettings::CopyFrom(const UFurCombSettings* other)
@@ -79,6 +85,8 @@ void UFurCombSettings::CopyFrom(const UFurCombSettings* other)
 	bMirrorY = other->bMirrorY;
 	bMirrorZ = other->bMirrorZ;
 	bShowSplines = other->bShowSplines;
+	bShowSplinesUnderBrushOnly = other->bShowSplinesUnderBrushOnly;
+	SplineDecimationDistance = other->SplineDecimationDistance;
 
 	GConfig->SetFloat(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombRadius"), Radius, GEditorPerProjectIni);
 	GConfig->SetFloat(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombStrength"), Strength, GEditorPerProjectIni);
@@ -91,6 +99,8 @@ void UFurCombSettings::CopyFrom(const UFurCombSettings* other)
 	GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorY"), bMirrorY, GEditorPerProjectIni);
 	GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorZ"), bMirrorZ, GEditorPerProjectIni);
 	GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplines"), bShowSplines, GEditorPerProjectIni);
+	GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplinesUnderBrushOnly"), bShowSplinesUnderBrushOnly, GEditorPerProjectIni);
+	GConfig->SetFloat(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombSplineDecimationDistance"), SplineDecimationDistance, GEditorPerProjectIni);
 }
 
 bool UFurCombSettings::Equals(const UFurCombSettings* other)
@@ -107,6 +117,8 @@ bool UFurCombSettings::Equals(const UFurCombSettings* other)
 	b &= bMirrorY == other->bMirrorY;
 	b &= bMirrorZ == other->bMirrorZ;
 	b &= bShowSplines == other->bShowSplines;
+	b &= bShowSplinesUnderBrushOnly == other->bShowSplinesUnderBrushOnly;
+	b &= SplineDecimationDistance == other->SplineDecimationDistance;
 	return b;
 }
 
@@ -141,6 +153,10 @@ void UFurCombSettings::PostEditChangeProperty(struct FPropertyChangedEvent& Prop
 			GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombMirrorZ"), bMirrorZ, GEditorPerProjectIni);
 		else if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UFurCombSettings, bShowSplines))
 			GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplines"), bShowSplines, GEditorPerProjectIni);
+		else if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UFurCombSettings, bShowSplinesUnderBrushOnly))
+			GConfig->SetBool(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombShowSplinesUnderBrushOnly"), bShowSplinesUnderBrushOnly, GEditorPerProjectIni);
+		else if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UFurCombSettings, SplineDecimationDistance))
+			GConfig->SetFloat(TEXT("FurCombEdit"), *(ConfigPrefix + "DefaultCombSplineDecimationDistance"), SplineDecimationDistance, GEditorPerProjectIni);
 		if (Widget)
 			Widget->UpdateSelectedPresset(this);
 	}
@@ -80,6 +80,14 @@ public:
 	UPROPERTY(EditAnywhere, Category = Comb)
 	bool bShowSplines;
 
+	/** Shows only the spline guides under the brush.*/
+	UPROPERTY(EditAnywhere, Category = Comb, meta = (EditCondition = "bShowSplines"))
+	bool bShowSplinesUnderBrushOnly;
+
+	/** Distance beyond which only every n-th spline guide is shown, n growing with the distance. 0 shows all of them.*/
+	UPROPERTY(EditAnywhere, Category = Comb, meta = (DisplayName = "Spline Decimation Distance", EditCondition = "bShowSplines", UIMin = "0.0", UIMax = "1000.0", ClampMin = "0.0"))
+	float SplineDecimationDistance;
+
 private:
 	FString ConfigPrefix;
 	SFurCombModeWidget* Widget = nullptr;
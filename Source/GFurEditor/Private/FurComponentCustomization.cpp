@@ -30,6 +30,7 @@
 #include "Runtime/Engine/Public/ComponentRecreateRenderStateContext.h"
 //#include "Runtime/AssetRegistry/Public/AssetRegistryModule.h"
 #include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
 #include "Framework/Application/SlateApplication.h"
 #include "Editor/MainFrame/Public/Interfaces/IMainFrameModule.h"
 
@@ -569,7 +570,7 @@ ExportInfo FFurComponentCustomization::ExportHairSplines(const FString& Filename
 	TArray<uint32> SourceIndices;
 	LodRenderData.MultiSizeIndexContainer.GetIndexBuffer(SourceIndices);
 
-	float CountRemainder = 0.0f;
+	TArray<FStrandTriangle> Triangles;
 	for (const auto& RenderSection : LodRenderData.RenderSections)
 	{
 		for (uint32 t = 0; t < RenderSection.NumTriangles; ++t)
@@ -585,25 +586,26 @@ ExportInfo FFurComponentCustomization::ExportHairSplines(const FString& Filename
 
 			if (SplineIndices[0] >= 0 && SplineIndices[1] >= 0 && SplineIndices[2] >= 0)
 			{
-				FVector3f Vertices[3];
-				Vertices[0] = SourcePositions.VertexPosition(Idx[0]);
-				Vertices[1] = SourcePositions.VertexPosition(Idx[1]);
-				Vertices[2] = SourcePositions.VertexPosition(Idx[2]);
-				FVector2f SrcUVs[3];
-				SrcUVs[0] = SourceUVs.GetVertexUV(Idx[0], 0);
-				SrcUVs[1] = SourceUVs.GetVertexUV(Idx[1], 0);
-				SrcUVs[2] = SourceUVs.GetVertexUV(Idx[2], 0);
-				GenerateInterpolatedSplines(Points, UVs, Vertices, SrcUVs, SplineIndices, ControlPointCount, CountRemainder, CountFactor);
+				FStrandTriangle& Triangle = Triangles.AddUninitialized_GetRef();
+				for (int32 Corner = 0; Corner < 3; Corner++)
+				{
+					Triangle.Vertices[Corner] = SourcePositions.VertexPosition(Idx[Corner]);
+					Triangle.UVs[Corner] = SourceUVs.GetVertexUV(Idx[Corner], 0);
+					Triangle.SplineIndices[Corner] = SplineIndices[Corner];
+				}
 			}
 		}
 	}
 
+	// only the counts are needed when the export isn't saved
+	const int32 StrandCount = GenerateInterpolatedSplines(Points, UVs, Triangles, ControlPointCount, CountFactor, Save);
+
 	if (Save)
 		::ExportFurSplines(Filename, Points, UVs, ControlPointCount, GroomSplineCount);
 
 	ExportInfo Info;
 	Info.GuideCount = GroomSplineCount;
-	Info.TotalCount = Points.Num() / ControlPointCount;
+	Info.TotalCount = GroomSplineCount + StrandCount;
 	return Info;
 }
 
@@ -629,17 +631,18 @@ ExportInfo FFurComponentCustomization::ExportHairSplines(const FString& Filename
 	GenerateSplineMap(SplineMap, FurSplines, SourcePositions, MinFurLength);
 
 	TArray<FVector2f> UVs;
-	UVs.AddUninitialized(FurSplines->Vertices.Num() * ControlPointCount);
+	UVs.AddUninitialized(FurSplines->SplineCount());
 	for (uint32 Index = 0, Count = SourceUVs.GetNumVertices(); Index < Count; Index++)
 	{
 		int32 SplineIndex = SplineMap[Index];
-		UVs[SplineIndex] = SourceUVs.GetVertexUV(Index, 0);
+		if (SplineIndex >= 0)
+			UVs[SplineIndex] = SourceUVs.GetVertexUV(Index, 0);
 	}
 
 	TArray<uint32> SourceIndices;
 	LodRenderData.IndexBuffer.GetCopy(SourceIndices);
 
-	float CountRemainder = 0.0f;
+	TArray<FStrandTriangle> Triangles;
 	for (const auto& RenderSection : LodRenderData.Sections)
 	{
 		for (uint32 t = 0; t < RenderSection.NumTriangles; ++t)
@@ -655,79 +658,113 @@ ExportInfo FFurComponentCustomization::ExportHairSplines(const FString& Filename
 
 			if (SplineIndices[0] >= 0 && SplineIndices[1] >= 0 && SplineIndices[2] >= 0)
 			{
-				FVector3f Vertices[3];
-				Vertices[0] = SourcePositions.VertexPosition(Idx[0]);
-				Vertices[1] = SourcePositions.VertexPosition(Idx[1]);
-				Vertices[2] = SourcePositions.VertexPosition(Idx[2]);
-				FVector2f SrcUVs[3];
-				SrcUVs[0] = SourceUVs.GetVertexUV(Idx[0], 0);
-				SrcUVs[1] = SourceUVs.GetVertexUV(Idx[1], 0);
-				SrcUVs[2] = SourceUVs.GetVertexUV(Idx[2], 0);
-				GenerateInterpolatedSplines(Points, UVs, Vertices, SrcUVs, SplineIndices, ControlPointCount, CountRemainder, CountFactor);
+				FStrandTriangle& Triangle = Triangles.AddUninitialized_GetRef();
+				for (int32 Corner = 0; Corner < 3; Corner++)
+				{
+					Triangle.Vertices[Corner] = SourcePositions.VertexPosition(Idx[Corner]);
+					Triangle.UVs[Corner] = SourceUVs.GetVertexUV(Idx[Corner], 0);
+					Triangle.SplineIndices[Corner] = SplineIndices[Corner];
+				}
 			}
 		}
 	}
 
+	// only the counts are needed when the export isn't saved
+	const int32 StrandCount = GenerateInterpolatedSplines(Points, UVs, Triangles, ControlPointCount, CountFactor, Save);
+
 	if (Save)
 		::ExportFurSplines(Filename, Points, UVs, ControlPointCount, GroomSplineCount);
 
 	ExportInfo Info;
 	Info.GuideCount = GroomSplineCount;
-	Info.TotalCount = Points.Num() / ControlPointCount;
+	Info.TotalCount = GroomSplineCount + StrandCount;
 	return Info;
 }
 
-void FFurComponentCustomization::GenerateInterpolatedSplines(TArray<FVector3f>& Points, TArray<FVector2f>& DestUVs, FVector3f* Vertices, FVector2f* SrcUVs,
-	int32* SplineIndices, int32 ControlPointCount, float& CountRemainder, float CountFactor)
+int32 FFurComponentCustomization::GenerateInterpolatedSplines(TArray<FVector3f>& Points, TArray<FVector2f>& DestUVs, const TArray<FStrandTriangle>& Triangles,
+	int32 ControlPointCount, float CountFactor, bool bGenerate)
 {
-	FVector u = FVector(Vertices[1] - Vertices[0]);
-	FVector v = FVector(Vertices[2] - Vertices[0]);
-	FVector n = FVector::CrossProduct(u, v);
+	TRACE_CPUPROFILER_EVENT_SCOPE(GenerateInterpolatedSplines);
+
+	// the fractional parts of the counts are carried over in mesh order, so the strand ranges of triangles are known up front
+	TArray<int32> FirstStrands;
+	FirstStrands.SetNumUninitialized(Triangles.Num() + 1);
+	int32 StrandCount = 0;
+	float CountRemainder = 0.0f;
+	for (int32 TriangleIndex = 0; TriangleIndex < Triangles.Num(); TriangleIndex++)
+	{
+		const FStrandTriangle& Triangle = Triangles[TriangleIndex];
+		FirstStrands[TriangleIndex] = StrandCount;
 
-	float fCount = n.Size() * CountFactor + CountRemainder;
-	int32 Count = (int32)fCount;
-	CountRemainder = fCount - Count;
+		const FVector3f n = FVector3f::CrossProduct(Triangle.Vertices[1] - Triangle.Vertices[0], Triangle.Vertices[2] - Triangle.Vertices[0]);
+		float fCount = n.Size() * CountFactor + CountRemainder;
+		int32 Count = (int32)fCount;
+		CountRemainder = fCount - Count;
 
-	u.Normalize();
-	n.Normalize();
-	if (!n.IsNormalized())
-		return;
-	FMatrix matHelper(u, FVector::CrossProduct(u, n), n, FVector(Vertices[0]));
-	FMatrix mat = matHelper.InverseFast();
+		if (n.GetSafeNormal().IsNormalized())
+			StrandCount += Count;
+	}
+	FirstStrands[Triangles.Num()] = StrandCount;
 
-	FVector4 p[3];
-	p[0] = mat.TransformPosition(FVector(Vertices[0]));
-	p[1] = mat.TransformPosition(FVector(Vertices[1]));
-	p[2] = mat.TransformPosition(FVector(Vertices[2]));
+	if (!bGenerate || StrandCount == 0)
+		return StrandCount;
 
-	FVector2D min, max;
-	min.X = FMath::Min3(p[0].X, p[1].X, p[2].X);
-	min.Y = FMath::Min3(p[0].Y, p[1].Y, p[2].Y);
-	max.X = FMath::Max3(p[0].X, p[1].X, p[2].X);
-	max.Y = FMath::Max3(p[0].Y, p[1].Y, p[2].Y);
+	const int32 GuidePointCount = Points.Num();
+	const int32 GuideCount = DestUVs.Num();
+	Points.AddUninitialized(StrandCount * ControlPointCount);
+	DestUVs.AddUninitialized(StrandCount);
 
-	while (Count > 0)
+	ParallelFor(Triangles.Num(), [&](int32 TriangleIndex)
 	{
-		FVector q;
-		q.X = FMath::FRandRange(min.X, max.X);
-		q.Y = FMath::FRandRange(min.Y, max.Y);
-		q.Z = 0;
+		const int32 FirstStrand = FirstStrands[TriangleIndex];
+		const int32 Count = FirstStrands[TriangleIndex + 1] - FirstStrand;
+		if (Count == 0)
+			return;
+
+		// every triangle has its own stream, strands don't depend on the order triangles are processed in
+		FRandomStream RandomStream(FCrc::MemCrc32(&TriangleIndex, sizeof(TriangleIndex)));
+
+		const FStrandTriangle& Triangle = Triangles[TriangleIndex];
+		const FVector3f* GuidePoints = Points.GetData();
+		FVector3f* StrandPoints = Points.GetData() + GuidePointCount + FirstStrand * ControlPointCount;
+		FVector2f* StrandUVs = DestUVs.GetData() + GuideCount + FirstStrand;
+		for (int32 Strand = 0; Strand < Count; Strand++)
+		{
+			// uniform point of the triangle from two uniform numbers
+			const float s = FMath::Sqrt(RandomStream.GetFraction());
+			const float t = RandomStream.GetFraction();
+			const FVector3f b(1.0f - s, s * (1.0f - t), s * t);
+
+			GenerateInterpolatedSpline(StrandPoints + Strand * ControlPointCount, GuidePoints, b, Triangle.SplineIndices, ControlPointCount);
+			StrandUVs[Strand] = Triangle.UVs[0] * b.X + Triangle.UVs[1] * b.Y + Triangle.UVs[2] * b.Z;
+		}
+	});
+
+	return StrandCount;
+}
 
-		FVector b = FMath::GetBaryCentric2D(q, p[0], p[1], p[2]);
-		if (b.X >= 0.0f && b.Y >= 0.0f && b.Z >= 0.0f)
+#if WITH_DEV_AUTOMATION_TESTS
+int32 FFurComponentCustomization::GenerateStrandsForTest(TArray<FVector3f>& Points, TArray<FVector2f>& UVs, const TArray<FVector3f>& TriangleVertices, const TArray<FVector2f>& TriangleUVs,
+	const TArray<int32>& TriangleSplines, int32 ControlPointCount, float CountFactor)
+{
+	TArray<FStrandTriangle> Triangles;
+	Triangles.SetNumUninitialized(TriangleVertices.Num() / 3);
+	for (int32 TriangleIndex = 0; TriangleIndex < Triangles.Num(); TriangleIndex++)
+	{
+		for (int32 Corner = 0; Corner < 3; Corner++)
 		{
-			GenerateInterpolatedSpline(Points, FVector3f(b), SplineIndices, ControlPointCount);
-			DestUVs.Add(SrcUVs[0] * b.X + SrcUVs[1] * b.Y + SrcUVs[2] * b.Z);
-			Count--;
+			Triangles[TriangleIndex].Vertices[Corner] = TriangleVertices[TriangleIndex * 3 + Corner];
+			Triangles[TriangleIndex].UVs[Corner] = TriangleUVs[TriangleIndex * 3 + Corner];
+			Triangles[TriangleIndex].SplineIndices[Corner] = TriangleSplines[TriangleIndex * 3 + Corner];
 		}
 	}
+	return GenerateInterpolatedSplines(Points, UVs, Triangles, ControlPointCount, CountFactor, true);
 }
+#endif // WITH_DEV_AUTOMATION_TESTS
 
-void FFurComponentCustomization::GenerateInterpolatedSpline(TArray<FVector3f>& Points, const FVector3f& BarycentricCoords, int32* SplineIndices, int32 ControlPointCount)
+void FFurComponentCustomization::GenerateInterpolatedSpline(FVector3f* p, const FVector3f* Points, const FVector3f& BarycentricCoords, const int32* SplineIndices,
+	int32 ControlPointCount)
 {
-	Points.AddUninitialized(ControlPointCount);
-	FVector3f* p = &Points[Points.Num() - ControlPointCount];
-
 	int32 Indices[3] = { SplineIndices[0] * ControlPointCount, SplineIndices[1] * ControlPointCount, SplineIndices[2] * ControlPointCount };
 
 	FVector3f PrevPoint;
@@ -107,6 +107,15 @@ public:
 	/** IDetailCustomization interface */
 	virtual void CustomizeDetails(IDetailLayoutBuilder& DetailBuilder) override;
 
+#if WITH_DEV_AUTOMATION_TESTS
+	/**
+	 * Appends strands interpolated across triangles to the guide splines in Points and UVs like the groom export. Every triangle
+	 * has three consecutive corners in TriangleVertices, TriangleUVs and TriangleSplines, the last ones index guide splines.
+	 */
+	static int32 GenerateStrandsForTest(TArray<FVector3f>& Points, TArray<FVector2f>& UVs, const TArray<FVector3f>& TriangleVertices, const TArray<FVector2f>& TriangleUVs,
+		const TArray<int32>& TriangleSplines, int32 ControlPointCount, float CountFactor);
+#endif // WITH_DEV_AUTOMATION_TESTS
+
 private:
 	float NewLength = 3.0f;
 	int NewControlPointCount = 7;
@@ -127,9 +136,18 @@ private:
 	static ExportInfo ExportHairSplines(const FString& filename, UFurSplines* FurSplines, USkeletalMesh* Mesh, float MinFurLength, float CountFactor, bool Save);
 	static ExportInfo ExportHairSplines(const FString& filename, UFurSplines* FurSplines, UStaticMesh* Mesh, float MinFurLength, float CountFactor, bool Save);
 
-	static void GenerateInterpolatedSplines(TArray<FVector3f>& Points, TArray<FVector2f>& DestUVs, FVector3f* Vertices, FVector2f* SrcUVs,
-		int32* SplineIndices, int32 ControlPointCount, float& CountRemainder, float CountFactor);
-	static void GenerateInterpolatedSpline(TArray<FVector3f>& Points, const FVector3f& BarycentricCoords, int32* SplineIndices, int32 ControlPointCount);
+	/** Triangle of the grow mesh with guide splines in all corners, strands are interpolated across it. */
+	struct FStrandTriangle
+	{
+		FVector3f Vertices[3];
+		FVector2f UVs[3];
+		int32 SplineIndices[3];
+	};
+
+	static int32 GenerateInterpolatedSplines(TArray<FVector3f>& Points, TArray<FVector2f>& DestUVs, const TArray<FStrandTriangle>& Triangles,
+		int32 ControlPointCount, float CountFactor, bool bGenerate);
+	static void GenerateInterpolatedSpline(FVector3f* OutPoints, const FVector3f* GuidePoints, const FVector3f& BarycentricCoords, const int32* SplineIndices,
+		int32 ControlPointCount);
 	static void GenerateSplineMap(TArray<int32>& SplineMap, UFurSplines* FurSplines, const class FPositionVertexBuffer& InPositions, float MinFurLength);
 
 	void ShowExportOptionsWindow(TSharedPtr<SGFurExportOptions>& Options, FString FilePath) const;
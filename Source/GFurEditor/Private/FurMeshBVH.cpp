@@ -0,0 +1,192 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurMeshBVH.h"
+#include "GFurEditor.h"
+#include "Algo/Sort.h"
+#include "Rendering/PositionVertexBuffer.h"
+
+static const int32 MaxLeafTriangles = 4;
+
+void FFurMeshBVH::Build(const FPositionVertexBuffer& Positions, int32 NumIndices, TFunctionRef<uint32(int32)> GetIndex)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	NumSourceIndices = NumIndices;
+	Nodes.Reset();
+	Triangles.Reset();
+
+	const int32 NumTriangles = NumIndices / 3;
+	TArray<FTriangle> SourceTriangles;
+	TArray<FVector> Centroids;
+	SourceTriangles.Reserve(NumTriangles);
+	Centroids.Reserve(NumTriangles);
+	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
+	{
+		const FVector P0 = FVector(Positions.VertexPosition(GetIndex((TriangleIndex * 3) + 0)));
+		const FVector P1 = FVector(Positions.VertexPosition(GetIndex((TriangleIndex * 3) + 1)));
+		const FVector P2 = FVector(Positions.VertexPosition(GetIndex((TriangleIndex * 3) + 2)));
+
+		//check collinearity of A,B,C
+		const FVector TriNorm = (P1 - P0) ^ (P2 - P0);
+		if (TriNorm.SizeSquared() > SMALL_NUMBER)
+		{
+			SourceTriangles.Add({ P0, P1, P2, TriangleIndex });
+			Centroids.Add((P0 + P1 + P2) / 3.0);
+		}
+	}
+	if (SourceTriangles.Num() == 0)
+		return;
+
+	TArray<int32> Order;
+	Order.SetNumUninitialized(SourceTriangles.Num());
+	for (int32 Index = 0; Index < Order.Num(); Index++)
+		Order[Index] = Index;
+
+	// a binary tree with leaves of at least one triangle has less than twice as many nodes as triangles
+	Nodes.Reserve(SourceTriangles.Num() * 2);
+	Nodes.AddUninitialized();
+	BuildNode(0, 0, Order.Num(), SourceTriangles, Centroids, Order);
+	Nodes.Shrink();
+
+	// leaves reference consecutive triangles
+	Triangles.SetNumUninitialized(Order.Num());
+	for (int32 Index = 0; Index < Order.Num(); Index++)
+		Triangles[Index] = SourceTriangles[Order[Index]];
+
+	UE_LOG(GFurEditor, Verbose, TEXT("Fur comb BVH of %d triangles built in %.2f ms."), Triangles.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void FFurMeshBVH::BuildNode(int32 NodeIndex, int32 Begin, int32 End, TArray<FTriangle>& InTriangles, const TArray<FVector>& Centroids, TArray<int32>& Order)
+{
+	FBox Bounds(ForceInit);
+	FBox CentroidBounds(ForceInit);
+	for (int32 Index = Begin; Index < End; Index++)
+	{
+		const FTriangle& Triangle = InTriangles[Order[Index]];
+		Bounds += Triangle.P0;
+		Bounds += Triangle.P1;
+		Bounds += Triangle.P2;
+		CentroidBounds += Centroids[Order[Index]];
+	}
+	// intersection points may be off the triangle by rounding errors, a slightly larger box never misses them
+	Nodes[NodeIndex].Bounds = Bounds.ExpandBy(KINDA_SMALL_NUMBER * (1.0 + Bounds.GetExtent().GetMax()));
+
+	const FVector CentroidExtent = CentroidBounds.GetExtent();
+	if (End - Begin <= MaxLeafTriangles || CentroidExtent.GetMax() <= 0.0)
+	{
+		Nodes[NodeIndex].First = Begin;
+		Nodes[NodeIndex].Count = End - Begin;
+		return;
+	}
+
+	// median split along the longest axis of the centroids
+	const int32 Axis = CentroidExtent.X >= CentroidExtent.Y && CentroidExtent.X >= CentroidExtent.Z ? 0 : (CentroidExtent.Y >= CentroidExtent.Z ? 1 : 2);
+	Algo::Sort(MakeArrayView(Order.GetData() + Begin, End - Begin), [&Centroids, Axis](int32 A, int32 B)
+	{
+		return Centroids[A][Axis] < Centroids[B][Axis];
+	});
+	const int32 Middle = (Begin + End) / 2;
+
+	const int32 FirstChild = Nodes.Num();
+	Nodes.AddUninitialized(2);
+	Nodes[NodeIndex].First = FirstChild;
+	Nodes[NodeIndex].Count = 0;
+	BuildNode(FirstChild, Begin, Middle, InTriangles, Centroids, Order);
+	BuildNode(FirstChild + 1, Middle, End, InTriangles, Centroids, Order);
+}
+
+/** Clips the segment Start + Dir * [0, 1] by the box, returns the parameter where the segment enters it. */
+static bool IntersectSegmentBox(const FBox& Box, const FVector& Start, const FVector& Dir, double& OutEntry)
+{
+	double Entry = 0.0;
+	double Exit = 1.0;
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if (FMath::Abs(Dir[Axis]) < UE_DOUBLE_SMALL_NUMBER)
+		{
+			if (Start[Axis] < Box.Min[Axis] || Start[Axis] > Box.Max[Axis])
+				return false;
+			continue;
+		}
+		const double InvDir = 1.0 / Dir[Axis];
+		double Near = (Box.Min[Axis] - Start[Axis]) * InvDir;
+		double Far = (Box.Max[Axis] - Start[Axis]) * InvDir;
+		if (Near > Far)
+			Swap(Near, Far);
+		Entry = FMath::Max(Entry, Near);
+		Exit = FMath::Min(Exit, Far);
+		if (Entry > Exit)
+			return false;
+	}
+	OutEntry = Entry;
+	return true;
+}
+
+bool FFurMeshBVH::LineTrace(const FVector& Start, const FVector& End, FVector& OutIntersect, FVector& OutNormal) const
+{
+	if (Nodes.Num() == 0)
+		return false;
+
+	const FVector Dir = End - Start;
+	const double DirSizeSquared = Dir.SizeSquared();
+
+	struct FStackEntry
+	{
+		int32 Node;
+		double Entry;
+	};
+	TArray<FStackEntry, TInlineAllocator<64>> Stack;
+	double RootEntry;
+	if (!IntersectSegmentBox(Nodes[0].Bounds, Start, Dir, RootEntry))
+		return false;
+	Stack.Add({ 0, RootEntry });
+
+	float MinDistance = FLT_MAX;
+	int32 MinTriangleIndex = MAX_int32;
+	while (Stack.Num() > 0)
+	{
+		const FStackEntry Entry = Stack.Pop(EAllowShrinking::No);
+		// boxes entered farther than the closest hit can't hold a closer one
+		if (Entry.Entry * Entry.Entry * DirSizeSquared > MinDistance)
+			continue;
+
+		const FNode& Node = Nodes[Entry.Node];
+		if (Node.Count > 0)
+		{
+			for (int32 Index = Node.First; Index < Node.First + Node.Count; Index++)
+			{
+				const FTriangle& Triangle = Triangles[Index];
+				FVector IntersectPoint;
+				FVector HitNormal;
+				if (FMath::SegmentTriangleIntersection(Start, End, Triangle.P0, Triangle.P1, Triangle.P2, IntersectPoint, HitNormal))
+				{
+					const float Distance = (Start - IntersectPoint).SizeSquared();
+					if (Distance < MinDistance || (Distance == MinDistance && Triangle.Index < MinTriangleIndex))
+					{
+						MinDistance = Distance;
+						MinTriangleIndex = Triangle.Index;
+						OutIntersect = IntersectPoint;
+						OutNormal = HitNormal;
+					}
+				}
+			}
+			continue;
+		}
+
+		// the nearer child is visited first
+		double Entries[2];
+		const bool Hits[2] =
+		{
+			IntersectSegmentBox(Nodes[Node.First].Bounds, Start, Dir, Entries[0]),
+			IntersectSegmentBox(Nodes[Node.First + 1].Bounds, Start, Dir, Entries[1])
+		};
+		const int32 Near = Hits[0] && Hits[1] ? (Entries[0] <= Entries[1] ? 0 : 1) : (Hits[0] ? 0 : 1);
+		const int32 Far = 1 - Near;
+		if (Hits[Far])
+			Stack.Add({ Node.First + Far, Entries[Far] });
+		if (Hits[Near])
+			Stack.Add({ Node.First + Near, Entries[Near] });
+	}
+
+	return MinDistance != FLT_MAX;
+}
@@ -0,0 +1,47 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FPositionVertexBuffer;
+
+/**
+ * Bounding volume hierarchy over triangles of a grow mesh in component space. Accelerates ray casts of the comb, hits are
+ * the same as testing all triangles one by one.
+ */
+class FFurMeshBVH
+{
+public:
+	/** Builds the hierarchy, degenerate triangles are left out like by the brute force trace. */
+	void Build(const FPositionVertexBuffer& Positions, int32 NumIndices, TFunctionRef<uint32(int32)> GetIndex);
+
+	/** Finds the hit closest to Start of the segment Start-End, ties go to the triangle first in the index buffer. */
+	bool LineTrace(const FVector& Start, const FVector& End, FVector& OutIntersect, FVector& OutNormal) const;
+
+	/** Number of indices the hierarchy was built from, a different number means the mesh changed. */
+	int32 GetNumSourceIndices() const { return NumSourceIndices; }
+
+private:
+	struct FTriangle
+	{
+		FVector P0;
+		FVector P1;
+		FVector P2;
+		int32 Index;
+	};
+
+	/** Leaf if Count is not zero with triangles [First, First + Count), otherwise children are First and First + 1. */
+	struct FNode
+	{
+		FBox Bounds;
+		int32 First;
+		int32 Count;
+	};
+
+	void BuildNode(int32 NodeIndex, int32 Begin, int32 End, TArray<FTriangle>& InTriangles, const TArray<FVector>& Centroids, TArray<int32>& Order);
+
+	TArray<FNode> Nodes;
+	TArray<FTriangle> Triangles;
+	int32 NumSourceIndices = 0;
+};
@@ -17,6 +17,7 @@
 #include "Editor/MainFrame/Public/Interfaces/IMainFrameModule.h"
 #include "Widgets/Input/SNumericEntryBox.h"
 #include "Widgets/Layout/SUniformGridPanel.h"
+#include "Async/ParallelFor.h"
 
 #if PLATFORM_WINDOWS
 #include "Windows/AllowWindowsPlatformTypes.h"
@@ -38,9 +39,37 @@ PRAGMA_DEFAULT_VISIBILITY_END
 
 #define LOCTEXT_NAMESPACE "GFurEditor"
 
-static void ParseObject(const Alembic::Abc::IObject& InObject, UFurSplines* Splines, const FMatrix& ParentMatrix, const FMatrix& ConversionMatrix, float Scale, bool bCheckGroomAttributes)
+/** ICurves object found in the hierarchy with the transformation inherited from its parent IXforms. */
+struct FAbcCurvesObject
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(ParseObject);
+	Alembic::AbcGeom::ICurves Curves;
+	FMatrix Matrix;
+
+	Alembic::Abc::P3fArraySamplePtr Positions;
+	Alembic::Abc::Int32ArraySamplePtr NumVertices;
+	/** Curves and points kept of the object, curves past a mismatch with the number of points are skipped. */
+	int32 NumCurves = 0;
+	int32 NumPoints = 0;
+	/** Offsets of the object in the spline arrays. */
+	int32 FirstSpline = 0;
+	int32 FirstVertex = 0;
+};
+
+static FMatrix ConvertAlembicMatrix(const Alembic::Abc::M44d& InMatrix)
+{
+	// Alembic matrices transform row vectors like FMatrix, translation is in the last row
+	FMatrix Result;
+	for (int32 Row = 0; Row < 4; ++Row)
+	{
+		for (int32 Column = 0; Column < 4; ++Column)
+			Result.M[Row][Column] = InMatrix[Row][Column];
+	}
+	return Result;
+}
+
+static void CollectCurvesObjects(const Alembic::Abc::IObject& InObject, const FMatrix& ParentMatrix, TArray<FAbcCurvesObject>& OutObjects)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(CollectCurvesObjects);
 
 	// Get MetaData info from current Alembic Object
 	const Alembic::Abc::MetaData ObjectMetaData = InObject.getMetaData();
@@ -50,105 +79,110 @@ static void ParseObject(const Alembic::Abc::IObject& InObject, UFurSplines* Spli
 
 	if (Alembic::AbcGeom::ICurves::matches(ObjectMetaData))
 	{
-		TRACE_CPUPROFILER_EVENT_SCOPE(ParseICurves);
+		FAbcCurvesObject& Object = OutObjects.AddDefaulted_GetRef();
+		Object.Curves = Alembic::AbcGeom::ICurves(InObject, Alembic::Abc::kWrapExisting);
+		Object.Matrix = ParentMatrix;
+	}
+	else if (Alembic::AbcGeom::IXform::matches(ObjectMetaData))
+	{
+		Alembic::AbcGeom::IXform Xform = Alembic::AbcGeom::IXform(InObject, Alembic::Abc::kWrapExisting);
+		Alembic::AbcGeom::XformSample MatrixSample;
+		Xform.getSchema().get(MatrixSample);
 
-		Alembic::AbcGeom::ICurves Curves = Alembic::AbcGeom::ICurves(InObject, Alembic::Abc::kWrapExisting);
-		Alembic::AbcGeom::ICurves::schema_type::Sample Sample = Curves.getSchema().getValue();
+		const FMatrix XformMatrix = ConvertAlembicMatrix(MatrixSample.getMatrix());
+		LocalMatrix = MatrixSample.getInheritsXforms() ? XformMatrix * ParentMatrix : XformMatrix;
+	}
 
-		Alembic::Abc::P3fArraySamplePtr Positions = Sample.getPositions();
-		Alembic::Abc::Int32ArraySamplePtr NumVertices = Sample.getCurvesNumVertices();
+	for (uint32 ChildIndex = 0; ChildIndex < NumChildren; ++ChildIndex)
+		CollectCurvesObjects(InObject.getChild(ChildIndex), LocalMatrix, OutObjects);
+}
 
-		uint32 NumPoints = Positions ? Positions->size() : 0;
-		uint32 NumCurves = NumVertices ? NumVertices->size() : 0; // equivalent to Sample.getNumCurves()
+static void ReadCurvesObject(FAbcCurvesObject& Object)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ReadCurvesObject);
 
-		// Get the starting strand and vertex IDs for this group of ICurves
+	Alembic::AbcGeom::ICurves::schema_type::Sample Sample = Object.Curves.getSchema().getValue();
+	Object.Positions = Sample.getPositions();
+	Object.NumVertices = Sample.getCurvesNumVertices();
 
-		FMatrix ConvertedMatrix = ParentMatrix * ConversionMatrix;
-		uint32 GlobalIndex = 0;
-		uint32 TotalVertices = 0;
-		for (uint32 CurveIndex = 0; CurveIndex < NumCurves; ++CurveIndex)
-		{
-			const uint32 CurveNumVertices = (*NumVertices)[CurveIndex];
+	const uint32 NumPoints = Object.Positions ? Object.Positions->size() : 0;
+	const uint32 NumCurves = Object.NumVertices ? Object.NumVertices->size() : 0; // equivalent to Sample.getNumCurves()
 
-			// Check the running total number of vertices and skip processing the rest of the node if there is mismatch with the number of points
-			TotalVertices += CurveNumVertices;
-			if (TotalVertices > NumPoints)
-			{
-				// TODO
-//				UE_LOG(LogAlembicHairImporter, Warning, TEXT("Curve %u of %u has %u vertices which causes total vertices (%u) to exceed the expected vertices (%u) in ICurves node. This curve and the remaining ones in the node will be skipped."),
-//					CurveIndex + 1, NumCurves, CurveNumVertices, TotalVertices, NumPoints);
-				break;
-			}
-
-			Splines->Index.Add(Splines->Vertices.Num());
-			Splines->Count.Add(CurveNumVertices);
-			for (uint32 PointIndex = 0; PointIndex < CurveNumVertices; ++PointIndex, ++GlobalIndex)
-			{
-				Alembic::Abc::P3fArraySample::value_type Position = (*Positions)[GlobalIndex];
+	uint32 TotalVertices = 0;
+	for (uint32 CurveIndex = 0; CurveIndex < NumCurves; ++CurveIndex)
+	{
+		const uint32 CurveNumVertices = (*Object.NumVertices)[CurveIndex];
 
-				FVector ConvertedPosition = ConvertedMatrix.TransformPosition(FVector(Position.x, Position.y, Position.z));
-				Splines->Vertices.Add(ConvertedPosition);
-			}
+		// Check the running total number of vertices and skip the rest of the node if there is mismatch with the number of points
+		if (TotalVertices + CurveNumVertices > NumPoints)
+		{
+			UE_LOG(GFurEditor, Warning, TEXT("Curve %u of %u has %u vertices which causes total vertices (%u) to exceed the expected vertices (%u) in ICurves node. This curve and the remaining ones in the node will be skipped."),
+				CurveIndex + 1, NumCurves, CurveNumVertices, TotalVertices + CurveNumVertices, NumPoints);
+			break;
 		}
+		TotalVertices += CurveNumVertices;
+		Object.NumCurves++;
+	}
+	Object.NumPoints = TotalVertices;
+}
 
-/*		if (bCheckGroomAttributes) TODO
-		{
-			// Groom attributes as UserProperties on ICurves, 1.3+
-			Alembic::AbcGeom::ICompoundProperty Properties = Curves.getSchema().getUserProperties();
-			if (Properties)
-			{
-				if (Properties.getNumProperties() > 0)
-				{
-					AlembicHairTranslatorUtils::SetGroomAttributes(HairDescription, Properties);
-					bCheckGroomAttributes = false;
-				}
-			}
-		}*/
+static void ConvertCurvesObject(const FAbcCurvesObject& Object, UFurSplines* Splines, const FMatrix& ConversionMatrix)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ConvertCurvesObject);
+
+	const FMatrix ConvertedMatrix = Object.Matrix * ConversionMatrix;
+	int32 VertexIndex = Object.FirstVertex;
+	for (int32 CurveIndex = 0; CurveIndex < Object.NumCurves; ++CurveIndex)
+	{
+		const int32 CurveNumVertices = (*Object.NumVertices)[CurveIndex];
+		Splines->Index[Object.FirstSpline + CurveIndex] = VertexIndex;
+		Splines->Count[Object.FirstSpline + CurveIndex] = CurveNumVertices;
+		VertexIndex += CurveNumVertices;
 	}
-/*	else if (Alembic::AbcGeom::IXform::matches(ObjectMetaData))TODO
+
+	const Alembic::Abc::P3fArraySample::value_type* Positions = Object.Positions ? Object.Positions->get() : nullptr;
+	FVector* Vertices = Splines->Vertices.GetData() + Object.FirstVertex;
+	for (int32 PointIndex = 0; PointIndex < Object.NumPoints; ++PointIndex)
 	{
-		TRACE_CPUPROFILER_EVENT_SCOPE(ParseIXform);
+		const Alembic::Abc::P3fArraySample::value_type& Position = Positions[PointIndex];
+		Vertices[PointIndex] = ConvertedMatrix.TransformPosition(FVector(Position.x, Position.y, Position.z));
+	}
+}
 
-		Alembic::AbcGeom::IXform Xform = Alembic::AbcGeom::IXform(InObject, Alembic::Abc::kWrapExisting);
-		Alembic::AbcGeom::XformSample MatrixSample;
-		Xform.getSchema().get(MatrixSample);
+/**
+ * Reads all ICurves of the hierarchy into the splines. Objects are found first, then their samples are read and counted
+ * in parallel so the spline arrays are sized once, and finally each object transforms its points into its own range.
+ */
+static void ParseCurvesObjects(const Alembic::Abc::IObject& InObject, UFurSplines* Splines, const FMatrix& ConversionMatrix, bool bParallelRead)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ParseCurvesObjects);
 
-		// The groom attributes should only be on the first IXform under the top node, no need to check for them once they are found
-		if (bCheckGroomAttributes)
-		{
-			// Groom attributes as UserProperties, 1.1+
-			Alembic::AbcGeom::ICompoundProperty Properties = Xform.getSchema().getUserProperties();
-			if (Properties)
-			{
-				if (Properties.getNumProperties() > 0)
-				{
-					AlembicHairTranslatorUtils::SetGroomAttributes(HairDescription, Properties);
-					bCheckGroomAttributes = false;
-				}
-			}
-
-			// Groom attributes as GeomParams, as fallback to 1.0
-			Alembic::AbcGeom::ICompoundProperty ArbParams = Xform.getSchema().getArbGeomParams();
-			if (bCheckGroomAttributes && ArbParams)
-			{
-				if (ArbParams.getNumProperties() > 0)
-				{
-					AlembicHairTranslatorUtils::SetGroomAttributes(HairDescription, ArbParams);
-					bCheckGroomAttributes = false;
-				}
-			}
-		}
+	TArray<FAbcCurvesObject> Objects;
+	CollectCurvesObjects(InObject, FMatrix::Identity, Objects);
 
-		LocalMatrix = ParentMatrix * ConvertAlembicMatrix(MatrixSample.getMatrix());
-	}*/
+	// only Ogawa archives read samples from several threads, it has a stream per thread
+	ParallelFor(Objects.Num(), [&Objects](int32 ObjectIndex)
+	{
+		ReadCurvesObject(Objects[ObjectIndex]);
+	}, bParallelRead ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
 
-	if (NumChildren > 0)
+	int32 NumSplines = Splines->Index.Num();
+	int32 NumVertices = Splines->Vertices.Num();
+	for (FAbcCurvesObject& Object : Objects)
 	{
-		for (uint32 ChildIndex = 0; ChildIndex < NumChildren; ++ChildIndex)
-		{
-			ParseObject(InObject.getChild(ChildIndex), Splines, LocalMatrix, ConversionMatrix, Scale, bCheckGroomAttributes);
-		}
+		Object.FirstSpline = NumSplines;
+		Object.FirstVertex = NumVertices;
+		NumSplines += Object.NumCurves;
+		NumVertices += Object.NumPoints;
 	}
+	Splines->Index.SetNumUninitialized(NumSplines);
+	Splines->Count.SetNumUninitialized(NumSplines);
+	Splines->Vertices.SetNumUninitialized(NumVertices);
+
+	ParallelFor(Objects.Num(), [&Objects, Splines, &ConversionMatrix](int32 ObjectIndex)
+	{
+		ConvertCurvesObject(Objects[ObjectIndex], Splines, ConversionMatrix);
+	});
 }
 
 static bool HasObjectCurves(const Alembic::Abc::IObject& InObject)
@@ -222,8 +256,9 @@ static bool ImportFurSplinesFromAlembic(const FString& Filename, UFurSplines* Fu
 		ConversionMatrix = FMatrix(FPlane(1, 0, 0, 0), FPlane(0, 0, 1, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
 		break;
 	}
-	FMatrix ParentMatrix = FMatrix::Identity;
-	ParseObject(TopObject, FurSplines, ParentMatrix, ConversionMatrix, 1.0f, true);
+	const double StartTime = FPlatformTime::Seconds();
+	ParseCurvesObjects(TopObject, FurSplines, ConversionMatrix, CompressionType == Alembic::AbcCoreFactory::IFactory::kOgawa);
+	UE_LOG(GFurEditor, Log, TEXT("Alembic fur splines import of %s read %d splines in %.2f ms."), *Filename, FurSplines->Index.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 	FurSplines->ImportFilename = Filename;
 	FurSplines->ImportTransformation = InConversion;
 	FurSplines->Version = 1;
@@ -232,6 +267,13 @@ static bool ImportFurSplinesFromAlembic(const FString& Filename, UFurSplines* Fu
 	return FurSplines->Vertices.Num() > 0;
 }
 
+#if WITH_DEV_AUTOMATION_TESTS
+bool ImportFurSplinesFromAlembicForTest(const FString& Filename, UFurSplines* FurSplines, int InConversion)
+{
+	return ImportFurSplinesFromAlembic(Filename, FurSplines, InConversion);
+}
+#endif // WITH_DEV_AUTOMATION_TESTS
+
 void SGFurImportOptions::Construct(const FArguments& InArgs)
 {
 	WidgetWindow = InArgs._WidgetWindow;
@@ -8,6 +8,11 @@
 
 class UFurSplines;
 
+#if WITH_DEV_AUTOMATION_TESTS
+/** Imports splines of an Alembic file like the factory, without showing the import options. */
+bool ImportFurSplinesFromAlembicForTest(const FString& Filename, UFurSplines* FurSplines, int InConversion);
+#endif // WITH_DEV_AUTOMATION_TESTS
+
 class SGFurImportOptions : public SCompoundWidget
 {
 public:
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "EditorReimportHandler.h"
+#include "HAL/FileManager.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Modules/ModuleManager.h"
@@ -12,6 +13,7 @@
 #include "Editor.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "PackageTools.h"
+#include "Subsystems/ImportSubsystem.h"
 #include "FurSplines.h"
 
 #include <fbxsdk.h>
@@ -77,6 +79,49 @@ private:
 	int ReaderId;
 };
 
+/** Scene parsed by FactoryCanImport, kept for the import of the same file which follows the check. */
+struct FFurSplineSceneCache
+{
+	FString Filename;
+	int64 Size = -1;
+	FDateTime Timestamp;
+	FbxManager* SdkManager = nullptr;
+	FbxScene* Scene = nullptr;
+
+	void Reset()
+	{
+		if (SdkManager)
+			SdkManager->Destroy();
+		SdkManager = nullptr;
+		Scene = nullptr;
+		Filename.Reset();
+	}
+};
+static FFurSplineSceneCache SceneCache;
+static FDelegateHandle SceneCachePreImportHandle;
+
+/** Imports of other files or by other factories won't reuse the cached scene. */
+static void OnAssetPreImport(UFactory* InFactory, UClass* InClass, UObject* InParent, const FName& InName, const TCHAR* InType)
+{
+	if (!Cast<UFurSplineImporterFactory>(InFactory) || UFactory::GetCurrentFilename() != SceneCache.Filename)
+		SceneCache.Reset();
+}
+
+/** Only nodes and geometry are read, splines don't need materials, animations, deformers or embedded media. */
+static FbxIOSettings* CreateSplineIOSettings(FbxManager* SdkManager)
+{
+	FbxIOSettings* ios = FbxIOSettings::Create(SdkManager, IOSROOT);
+	ios->SetBoolProp(IMP_FBX_MATERIAL, false);
+	ios->SetBoolProp(IMP_FBX_TEXTURE, false);
+	ios->SetBoolProp(IMP_FBX_LINK, false);
+	ios->SetBoolProp(IMP_FBX_SHAPE, false);
+	ios->SetBoolProp(IMP_FBX_GOBO, false);
+	ios->SetBoolProp(IMP_FBX_ANIMATION, false);
+	ios->SetBoolProp(IMP_FBX_CHARACTER, false);
+	ios->SetBoolProp(IMP_FBX_CONSTRAINT, false);
+	ios->SetBoolProp(IMP_FBX_EXTRACT_EMBEDDED_DATA, false);
+	return ios;
+}
 
 UFurSplineImporterFactory::UFurSplineImporterFactory(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -100,6 +145,9 @@ FText UFurSplineImporterFactory::GetToolTip() const
 
 bool UFurSplineImporterFactory::FactoryCanImport(const FString& Filename)
 {
+	const double StartTime = FPlatformTime::Seconds();
+	SceneCache.Reset();
+
 	FbxManager* SdkManager = FbxManager::Create();
 	check(SdkManager);
 	FbxScene* Scene = ImportFbxScene(SdkManager, Filename);
@@ -126,19 +174,55 @@ bool UFurSplineImporterFactory::FactoryCanImport(const FString& Filename)
 		}
 	}
 
-	SdkManager->Destroy();
-	return hasSpline;
+	UE_LOG(GFurEditor, Log, TEXT("Fur splines check of %s took %.2f ms."), *Filename, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	if (!hasSpline)
+	{
+		SdkManager->Destroy();
+		return false;
+	}
+
+	SceneCache.Filename = Filename;
+	SceneCache.Size = IFileManager::Get().FileSize(*Filename);
+	SceneCache.Timestamp = IFileManager::Get().GetTimeStamp(*Filename);
+	SceneCache.SdkManager = SdkManager;
+	SceneCache.Scene = Scene;
+	if (!SceneCachePreImportHandle.IsValid() && GEditor)
+	{
+		if (UImportSubsystem* ImportSubsystem = GEditor->GetEditorSubsystem<UImportSubsystem>())
+			SceneCachePreImportHandle = ImportSubsystem->OnAssetPreImport.AddStatic(&OnAssetPreImport);
+	}
+	return true;
 }
 
 UObject* UFurSplineImporterFactory::FactoryCreateBinary(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, const TCHAR* Type, const uint8*& Buffer, const uint8* BufferEnd, FFeedbackContext* Warn)
 {
-	FbxManager* SdkManager = FbxManager::Create();
-	check(SdkManager);
-	FbxScene* Scene = ImportFbxScene(SdkManager, (const char*)Buffer, BufferEnd - Buffer);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// the file checked last is parsed already unless it changed since
+	FbxManager* SdkManager = nullptr;
+	FbxScene* Scene = NULL;
+	const FString Filename = GetCurrentFilename();
+	if (SceneCache.Scene && SceneCache.Filename == Filename && SceneCache.Size == BufferEnd - Buffer && SceneCache.Timestamp == IFileManager::Get().GetTimeStamp(*Filename))
+	{
+		SdkManager = SceneCache.SdkManager;
+		Scene = SceneCache.Scene;
+		SceneCache.SdkManager = nullptr;
+		SceneCache.Scene = nullptr;
+	}
+	SceneCache.Reset();
+	const bool bSceneCached = Scene != NULL;
+
 	if (Scene == NULL)
 	{
-		SdkManager->Destroy();
-		return NULL;
+		SdkManager = FbxManager::Create();
+		check(SdkManager);
+		Scene = ImportFbxScene(SdkManager, (const char*)Buffer, BufferEnd - Buffer);
+		if (Scene == NULL)
+		{
+			SdkManager->Destroy();
+			return NULL;
+		}
 	}
 
 	UFurSplines* Result = NewObject<UFurSplines>(InParent, InName, Flags);
@@ -148,11 +232,31 @@ UObject* UFurSplineImporterFactory::FactoryCreateBinary(UClass* InClass, UObject
 		SdkManager->Destroy();
 		return nullptr;
 	}
-	Result->ImportFilename = GetCurrentFilename();
+	Result->ImportFilename = Filename;
 	SdkManager->Destroy();
+
+	UE_LOG(GFurEditor, Log, TEXT("Fur splines import of %s took %.2f ms%s."), *Filename, (FPlatformTime::Seconds() - StartTime) * 1000.0, bSceneCached ? TEXT(", scene parsed by the check was reused") : TEXT(""));
 	return Result;
 }
 
+void UFurSplineImporterFactory::CleanUp()
+{
+	Super::CleanUp();
+
+	SceneCache.Reset();
+}
+
+void UFurSplineImporterFactory::ReleaseSceneCache()
+{
+	SceneCache.Reset();
+	if (SceneCachePreImportHandle.IsValid())
+	{
+		if (UImportSubsystem* ImportSubsystem = GEditor ? GEditor->GetEditorSubsystem<UImportSubsystem>() : nullptr)
+			ImportSubsystem->OnAssetPreImport.Remove(SceneCachePreImportHandle);
+		SceneCachePreImportHandle.Reset();
+	}
+}
+
 bool UFurSplineImporterFactory::CanReimport(UObject* Obj, TArray<FString>& OutFilenames)
 {
 	if (UFurSplines* Splines = Cast<UFurSplines>(Obj))
@@ -211,8 +315,7 @@ int32 UFurSplineImporterFactory::GetPriority() const
 
 FbxScene* UFurSplineImporterFactory::ImportFbxScene(FbxManager* SdkManager, const FString& Filename)
 {
-	FbxIOSettings* ios = FbxIOSettings::Create(SdkManager, IOSROOT);
-	SdkManager->SetIOSettings(ios);
+	SdkManager->SetIOSettings(CreateSplineIOSettings(SdkManager));
 	FbxScene* Scene = FbxScene::Create(SdkManager, "My Scene");
 	check(Scene);
 
@@ -231,8 +334,7 @@ FbxScene* UFurSplineImporterFactory::ImportFbxScene(FbxManager* SdkManager, cons
 
 FbxScene* UFurSplineImporterFactory::ImportFbxScene(FbxManager* SdkManager, const char* Buffer, intptr_t Size)
 {
-	FbxIOSettings* ios = FbxIOSettings::Create(SdkManager, IOSROOT);
-	SdkManager->SetIOSettings(ios);
+	SdkManager->SetIOSettings(CreateSplineIOSettings(SdkManager));
 	FbxScene* Scene = FbxScene::Create(SdkManager, "My Scene");
 	check(Scene);
 
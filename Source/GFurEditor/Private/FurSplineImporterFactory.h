@@ -24,6 +24,7 @@ class UFurSplineImporterFactory : public UFactory, public FReimportHandler
 	virtual FText GetToolTip() const override;
 	virtual bool FactoryCanImport(const FString& Filename) override;
 	virtual UObject* FactoryCreateBinary(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, const TCHAR* Type, const uint8*& Buffer, const uint8* BufferEnd, FFeedbackContext* Warn) override;
+	virtual void CleanUp() override;
 	// End of UFactory interface
 
 	// FReimportHandler interface
@@ -33,6 +34,9 @@ class UFurSplineImporterFactory : public UFactory, public FReimportHandler
 	virtual int32 GetPriority() const override;
 	// End of FReimportHandler interface
 
+	/** Releases the scene parsed by FactoryCanImport, called at module shutdown at the latest. */
+	static void ReleaseSceneCache();
+
 protected:
 
 	static UObject* CreateNewAsset(UClass* AssetClass, const FString& TargetPath, const FString& DesiredName, EObjectFlags Flags);
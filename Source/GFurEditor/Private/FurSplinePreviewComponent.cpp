@@ -0,0 +1,311 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurSplinePreviewComponent.h"
+#include "FurSplines.h"
+
+#include "Engine/Engine.h"
+#include "DynamicMeshBuilder.h"
+#include "LocalVertexFactory.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialRenderProxy.h"
+#include "PrimitiveSceneProxy.h"
+#include "SceneManagement.h"
+#include "StaticMeshResources.h"
+
+DEFINE_STAT(STAT_FurCombSplineDisplay);
+DEFINE_STAT(STAT_FurCombSplineDisplayLines);
+DEFINE_STAT(STAT_FurCombSplineDisplaySkippedLines);
+
+/** Draws all splines of the component as one line list, chunks outside of the view are left out of the index ranges. */
+class FFurSplinePreviewSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+	FFurSplinePreviewSceneProxy(UFurSplinePreviewComponent* InComponent)
+		: FPrimitiveSceneProxy(InComponent)
+		, VertexFactory(GetScene().GetFeatureLevel(), "FFurSplinePreviewSceneProxy")
+		, ControlPointCount(InComponent->Splines->ControlPointCount)
+		, SplineCount(InComponent->SplineCount)
+		, DecimationDistance(InComponent->DecimationDistance)
+		, ChunkBounds(InComponent->ChunkBounds)
+		, WireframeMaterial(GEngine->WireframeMaterial->GetRenderProxy())
+	{
+		const TArray<FVector>& Points = InComponent->Splines->Vertices;
+		TArray<FDynamicMeshVertex> Vertices;
+		Vertices.SetNumUninitialized(SplineCount * ControlPointCount);
+		for (int32 Index = 0; Index < Vertices.Num(); Index++)
+			Vertices[Index] = FDynamicMeshVertex(FVector3f(Points[Index]));
+		VertexBuffers.InitFromDynamicVertex(&VertexFactory, Vertices);
+		UFurSplinePreviewComponent::BuildLineIndices(SplineCount, ControlPointCount, IndexBuffer.Indices);
+
+		BeginInitResource(&VertexBuffers.PositionVertexBuffer);
+		BeginInitResource(&VertexBuffers.StaticMeshVertexBuffer);
+		BeginInitResource(&VertexBuffers.ColorVertexBuffer);
+		BeginInitResource(&IndexBuffer);
+		BeginInitResource(&VertexFactory);
+	}
+
+	virtual ~FFurSplinePreviewSceneProxy()
+	{
+		VertexBuffers.PositionVertexBuffer.ReleaseResource();
+		VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+		VertexBuffers.ColorVertexBuffer.ReleaseResource();
+		IndexBuffer.ReleaseResource();
+		VertexFactory.ReleaseResource();
+	}
+
+	virtual SIZE_T GetTypeHash() const override
+	{
+		static size_t UniquePointer;
+		return reinterpret_cast<size_t>(&UniquePointer);
+	}
+
+	/** Overwrites control points of whole chunks, Points holds the chunks one after another. */
+	void UpdateChunks_RenderThread(FRHICommandListBase& RHICmdList, const TArray<int32>& Chunks, const TArray<FVector3f>& Points, const TArray<FBox>& ChunkBoxes)
+	{
+		const int32 NumPoints = SplineCount * ControlPointCount;
+		int32 PointIndex = 0;
+		for (int32 i = 0; i < Chunks.Num(); i++)
+		{
+			const int32 Begin = Chunks[i] * UFurSplinePreviewComponent::ChunkSize * ControlPointCount;
+			const int32 Num = FMath::Min(UFurSplinePreviewComponent::ChunkSize * ControlPointCount, NumPoints - Begin);
+			void* Buffer = RHICmdList.LockBuffer(VertexBuffers.PositionVertexBuffer.VertexBufferRHI, Begin * sizeof(FVector3f), Num * sizeof(FVector3f), RLM_WriteOnly);
+			FMemory::Memcpy(Buffer, &Points[PointIndex], Num * sizeof(FVector3f));
+			RHICmdList.UnlockBuffer(VertexBuffers.PositionVertexBuffer.VertexBufferRHI);
+			PointIndex += Num;
+			ChunkBounds[Chunks[i]] = ChunkBoxes[i];
+		}
+	}
+
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FurCombSplineDisplay);
+
+		const int32 SplineLines = ControlPointCount - 1;
+		int32 NumLines = 0;
+		int32 NumSkippedLines = 0;
+		for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+		{
+			if (!(VisibilityMap & (1 << ViewIndex)))
+				continue;
+
+			const FSceneView* View = Views[ViewIndex];
+			const FVector ViewOrigin = View->ViewMatrices.GetViewOrigin();
+
+			FMeshBatch& Mesh = Collector.AllocateMesh();
+			int32 NumElements = 0;
+			for (int32 ChunkIndex = 0; ChunkIndex < ChunkBounds.Num(); ChunkIndex++)
+			{
+				const FBox ChunkBox = ChunkBounds[ChunkIndex].TransformBy(GetLocalToWorld());
+				const int32 Begin = ChunkIndex * UFurSplinePreviewComponent::ChunkSize;
+				const int32 ChunkSplines = FMath::Min(UFurSplinePreviewComponent::ChunkSize, SplineCount - Begin);
+				if (!View->ViewFrustum.IntersectBox(ChunkBox.GetCenter(), ChunkBox.GetExtent()))
+				{
+					NumSkippedLines += ChunkSplines * SplineLines;
+					continue;
+				}
+
+				// splines of a chunk are ordered by decimation, far chunks draw a prefix of their index range
+				const int32 Stride = UFurSplinePreviewComponent::GetDecimationStride(FMath::Sqrt(ChunkBox.ComputeSquaredDistanceToPoint(ViewOrigin)), DecimationDistance);
+				const int32 ShownSplines = FMath::DivideAndRoundUp(ChunkSplines, Stride);
+				const uint32 FirstIndex = Begin * SplineLines * 2;
+				const uint32 NumPrimitives = ShownSplines * SplineLines;
+				NumLines += NumPrimitives;
+				NumSkippedLines += (ChunkSplines - ShownSplines) * SplineLines;
+
+				// adjacent whole chunks share one element, so an undecimated view draws a single range
+				if (NumElements > 0)
+				{
+					FMeshBatchElement& LastElement = Mesh.Elements[NumElements - 1];
+					if (LastElement.FirstIndex + LastElement.NumPrimitives * 2 == FirstIndex)
+					{
+						LastElement.NumPrimitives += NumPrimitives;
+						continue;
+					}
+				}
+
+				FMeshBatchElement& BatchElement = NumElements == 0 ? Mesh.Elements[0] : Mesh.Elements.AddDefaulted_GetRef();
+				BatchElement.IndexBuffer = &IndexBuffer;
+				BatchElement.PrimitiveUniformBuffer = GetUniformBuffer();
+				BatchElement.FirstIndex = FirstIndex;
+				BatchElement.NumPrimitives = NumPrimitives;
+				BatchElement.MinVertexIndex = 0;
+				BatchElement.MaxVertexIndex = SplineCount * ControlPointCount - 1;
+				NumElements++;
+			}
+			if (NumElements == 0)
+				continue;
+
+			FColoredMaterialRenderProxy* MaterialProxy = new FColoredMaterialRenderProxy(WireframeMaterial, FLinearColor::Red);
+			Collector.RegisterOneFrameMaterialProxy(MaterialProxy);
+
+			Mesh.bWireframe = false;
+			Mesh.VertexFactory = &VertexFactory;
+			Mesh.MaterialRenderProxy = MaterialProxy;
+			Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+			Mesh.Type = PT_LineList;
+			Mesh.DepthPriorityGroup = SDPG_World;
+			Mesh.CastShadow = false;
+			Mesh.bCanApplyViewModeOverrides = false;
+			Collector.AddMesh(ViewIndex, Mesh);
+		}
+
+		SET_DWORD_STAT(STAT_FurCombSplineDisplayLines, NumLines);
+		SET_DWORD_STAT(STAT_FurCombSplineDisplaySkippedLines, NumSkippedLines);
+	}
+
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+	{
+		FPrimitiveViewRelevance Result;
+		Result.bDrawRelevance = IsShown(View);
+		Result.bDynamicRelevance = true;
+		Result.bRenderInMainPass = ShouldRenderInMainPass();
+		Result.bOpaque = true;
+		return Result;
+	}
+
+	virtual uint32 GetMemoryFootprint() const override { return sizeof(*this) + GetAllocatedSize(); }
+
+private:
+	FStaticMeshVertexBuffers VertexBuffers;
+	FDynamicMeshIndexBuffer32 IndexBuffer;
+	FLocalVertexFactory VertexFactory;
+
+	int32 ControlPointCount;
+	int32 SplineCount;
+	float DecimationDistance;
+	TArray<FBox> ChunkBounds;
+	const FMaterialRenderProxy* WireframeMaterial;
+};
+
+UFurSplinePreviewComponent::UFurSplinePreviewComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	bIsEditorOnly = true;
+	bSelectable = false;
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CastShadow = false;
+	SetHiddenInGame(true);
+}
+
+void UFurSplinePreviewComponent::SetSplines(UFurSplines* InSplines, float InDecimationDistance)
+{
+	Splines = InSplines;
+	DecimationDistance = InDecimationDistance;
+	SplineCount = Splines ? Splines->SplineCount() : 0;
+	ChunkBounds.SetNumUninitialized(FMath::DivideAndRoundUp(SplineCount, ChunkSize));
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkBounds.Num(); ChunkIndex++)
+		UpdateChunkBounds(ChunkIndex);
+
+	UpdateBounds();
+	MarkRenderStateDirty();
+}
+
+bool UFurSplinePreviewComponent::IsUpToDate() const
+{
+	return Splines && SplineCount == Splines->SplineCount() && Splines->Vertices.Num() == SplineCount * Splines->ControlPointCount;
+}
+
+void UFurSplinePreviewComponent::UpdateSplines(const TSet<int32>& InSplines)
+{
+	if (!IsUpToDate())
+		return;
+
+	// bounds of a chunk may shrink, chunks of the splines are uploaded as a whole
+	TArray<int32> Chunks;
+	for (int32 SplineIndex : InSplines)
+		Chunks.AddUnique(SplineIndex / ChunkSize);
+
+	const int32 ControlPointCount = Splines->ControlPointCount;
+	TArray<FVector3f> Points;
+	TArray<FBox> ChunkBoxes;
+	Points.Reserve(Chunks.Num() * ChunkSize * ControlPointCount);
+	ChunkBoxes.Reserve(Chunks.Num());
+	for (int32 ChunkIndex : Chunks)
+	{
+		UpdateChunkBounds(ChunkIndex);
+		ChunkBoxes.Add(ChunkBounds[ChunkIndex]);
+		const int32 Begin = ChunkIndex * ChunkSize * ControlPointCount;
+		const int32 End = FMath::Min(Begin + ChunkSize * ControlPointCount, Splines->Vertices.Num());
+		for (int32 Index = Begin; Index < End; Index++)
+			Points.Add(FVector3f(Splines->Vertices[Index]));
+	}
+
+	const FBox OldBox = Bounds.GetBox();
+	UpdateBounds();
+	if (!Bounds.GetBox().Equals(OldBox))
+		MarkRenderTransformDirty();
+
+	if (FFurSplinePreviewSceneProxy* PreviewSceneProxy = static_cast<FFurSplinePreviewSceneProxy*>(SceneProxy))
+	{
+		ENQUEUE_RENDER_COMMAND(UpdateFurSplinePreview)([PreviewSceneProxy, Chunks = MoveTemp(Chunks), Points = MoveTemp(Points), ChunkBoxes = MoveTemp(ChunkBoxes)](FRHICommandListImmediate& RHICmdList) {
+			PreviewSceneProxy->UpdateChunks_RenderThread(RHICmdList, Chunks, Points, ChunkBoxes);
+		});
+	}
+}
+
+void UFurSplinePreviewComponent::BuildLineIndices(int32 InSplineCount, int32 ControlPointCount, TArray<uint32>& OutIndices)
+{
+	// spline k of a chunk is shown with every power of two stride dividing k, splines shown with larger strides go first
+	TArray<int32, TInlineAllocator<ChunkSize>> Order;
+	for (int32 i = 0; i < ChunkSize; i++)
+		Order.Add(i);
+	Order.Sort([](int32 A, int32 B) {
+		const uint32 LevelA = A ? FMath::CountTrailingZeros(uint32(A)) : 32;
+		const uint32 LevelB = B ? FMath::CountTrailingZeros(uint32(B)) : 32;
+		return LevelA != LevelB ? LevelA > LevelB : A < B;
+	});
+
+	OutIndices.Reset(InSplineCount * (ControlPointCount - 1) * 2);
+	for (int32 Begin = 0; Begin < InSplineCount; Begin += ChunkSize)
+	{
+		const int32 ChunkSplines = FMath::Min(ChunkSize, InSplineCount - Begin);
+		for (int32 k : Order)
+		{
+			if (k >= ChunkSplines)
+				continue;
+			const uint32 Base = (Begin + k) * ControlPointCount;
+			for (int32 j = 1; j < ControlPointCount; j++)
+			{
+				OutIndices.Add(Base + j - 1);
+				OutIndices.Add(Base + j);
+			}
+		}
+	}
+}
+
+int32 UFurSplinePreviewComponent::GetDecimationStride(float Distance, float InDecimationDistance)
+{
+	if (InDecimationDistance <= 0.0f)
+		return 1;
+	const int32 Stride = FMath::FloorToInt(FMath::Clamp(Distance / InDecimationDistance, 1.0f, float(ChunkSize)));
+	return 1 << FMath::FloorLog2(Stride);
+}
+
+FPrimitiveSceneProxy* UFurSplinePreviewComponent::CreateSceneProxy()
+{
+	if (!IsUpToDate() || SplineCount == 0 || Splines->ControlPointCount < 2)
+		return nullptr;
+	return new FFurSplinePreviewSceneProxy(this);
+}
+
+FBoxSphereBounds UFurSplinePreviewComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	FBox LocalBox(ForceInit);
+	for (const FBox& ChunkBox : ChunkBounds)
+		LocalBox += ChunkBox;
+	if (!LocalBox.IsValid)
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0f);
+	return FBoxSphereBounds(LocalBox).TransformBy(LocalToWorld);
+}
+
+void UFurSplinePreviewComponent::UpdateChunkBounds(int32 ChunkIndex)
+{
+	const TArray<FVector>& Vertices = Splines->Vertices;
+	const int32 Begin = ChunkIndex * ChunkSize * Splines->ControlPointCount;
+	const int32 End = FMath::Min(Begin + ChunkSize * Splines->ControlPointCount, Vertices.Num());
+	FBox ChunkBox(ForceInit);
+	for (int32 Index = Begin; Index < End; Index++)
+		ChunkBox += Vertices[Index];
+	ChunkBounds[ChunkIndex] = ChunkBox;
+}
@@ -0,0 +1,69 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "GFur.h"
+#include "FurSplinePreviewComponent.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Comb Spline Display"), STAT_FurCombSplineDisplay, STATGROUP_GFur, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Comb Spline Display Lines"), STAT_FurCombSplineDisplayLines, STATGROUP_GFur, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Comb Spline Display Skipped Lines"), STAT_FurCombSplineDisplaySkippedLines, STATGROUP_GFur, );
+
+class UFurSplines;
+
+/**
+ * Editor only component showing splines of a fur component while combing. Control points are uploaded once to a line list
+ * vertex buffer of the scene proxy, which draws all splines as one primitive. Comb dabs upload only chunks of combed splines.
+ */
+UCLASS(Transient)
+class GFUREDITOR_API UFurSplinePreviewComponent : public UPrimitiveComponent
+{
+	GENERATED_UCLASS_BODY()
+public:
+	/** Splines culled and decimated together. */
+	static constexpr int32 ChunkSize = 256;
+
+	/** Shows splines in the space of the component, far chunks show every n-th spline when DecimationDistance is positive. */
+	void SetSplines(UFurSplines* InSplines, float InDecimationDistance);
+	UFurSplines* GetSplines() const { return Splines; }
+	float GetDecimationDistance() const { return DecimationDistance; }
+
+	/** False when splines were added or removed since the scene proxy was created. */
+	bool IsUpToDate() const;
+
+	/** Uploads control points of chunks of the splines after a comb dab, the rest of the vertex buffer is kept. */
+	void UpdateSplines(const TSet<int32>& InSplines);
+
+	/** Bounds of chunks in the space of the component. */
+	const TArray<FBox>& GetChunkBounds() const { return ChunkBounds; }
+
+	/**
+	 * Line list indices of splines, splines of every chunk ordered so that the first DivideAndRoundUp(ChunkSplines, Stride)
+	 * splines are those with a chunk index divisible by Stride for any power of two Stride.
+	 */
+	static void BuildLineIndices(int32 SplineCount, int32 ControlPointCount, TArray<uint32>& OutIndices);
+	/** Stride of splines shown in a chunk at the distance, a power of two. */
+	static int32 GetDecimationStride(float Distance, float DecimationDistance);
+
+	//~ Begin UPrimitiveComponent Interface.
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+	//~ End UPrimitiveComponent Interface.
+
+	//~ Begin USceneComponent Interface.
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+	//~ End USceneComponent Interface.
+
+private:
+	UPROPERTY()
+	TObjectPtr<UFurSplines> Splines;
+
+	float DecimationDistance = 0.0f;
+	int32 SplineCount = 0;
+	TArray<FBox> ChunkBounds;
+
+	void UpdateChunkBounds(int32 ChunkIndex);
+
+	friend class FFurSplinePreviewSceneProxy;
+};
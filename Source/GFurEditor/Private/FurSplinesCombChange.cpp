@@ -0,0 +1,53 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurSplinesCombChange.h"
+#include "FurSplines.h"
+
+FFurSplinesCombChange::FFurSplinesCombChange(int32 InControlPointCount, TArray<int32>&& InSplines, TArray<FVector>&& InOldVertices, TArray<FVector>&& InNewVertices,
+	TArray<uint32>&& InCombedVertices)
+	: ControlPointCount(InControlPointCount)
+	, Splines(MoveTemp(InSplines))
+	, OldVertices(MoveTemp(InOldVertices))
+	, NewVertices(MoveTemp(InNewVertices))
+	, CombedVertices(MoveTemp(InCombedVertices))
+{
+}
+
+void FFurSplinesCombChange::Apply(UObject* Object)
+{
+	SetControlPoints(Object, NewVertices);
+}
+
+void FFurSplinesCombChange::Revert(UObject* Object)
+{
+	SetControlPoints(Object, OldVertices);
+}
+
+FString FFurSplinesCombChange::ToString() const
+{
+	return FString::Printf(TEXT("Fur Comb (%d splines)"), Splines.Num());
+}
+
+SIZE_T FFurSplinesCombChange::GetAllocatedSize() const
+{
+	return Splines.GetAllocatedSize() + OldVertices.GetAllocatedSize() + NewVertices.GetAllocatedSize() + CombedVertices.GetAllocatedSize();
+}
+
+void FFurSplinesCombChange::SetControlPoints(UObject* Object, const TArray<FVector>& InVertices) const
+{
+	UFurSplines* FurSplines = CastChecked<UFurSplines>(Object);
+	if (FurSplines->ControlPointCount != ControlPointCount)
+		return;
+
+	for (int32 Index = 0; Index < Splines.Num(); Index++)
+	{
+		const int32 Idx = Splines[Index] * ControlPointCount;
+		if (Idx + ControlPointCount > FurSplines->Vertices.Num())
+			continue;
+		FMemory::Memcpy(&FurSplines->Vertices[Idx], &InVertices[Index * ControlPointCount], ControlPointCount * sizeof(FVector));
+	}
+
+	// the transaction calls PostEditUndo next, fur is rebuilt here for the combed vertices only
+	FurSplines->CombUndoFrame = GFrameCounter;
+	FurSplines->OnSplinesCombed.Broadcast(CombedVertices);
+}
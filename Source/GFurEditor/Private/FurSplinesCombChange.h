@@ -0,0 +1,35 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Change.h"
+
+/**
+ * Undo record of one comb stroke. Holds only control points of splines the stroke touched instead of a copy of all
+ * control points, undo and redo rebuild fur of the combed grow mesh vertices only.
+ */
+class FFurSplinesCombChange : public FCommandChange
+{
+public:
+	FFurSplinesCombChange(int32 InControlPointCount, TArray<int32>&& InSplines, TArray<FVector>&& InOldVertices, TArray<FVector>&& InNewVertices,
+		TArray<uint32>&& InCombedVertices);
+
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual FString ToString() const override;
+
+	/** Memory held by the change. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	void SetControlPoints(UObject* Object, const TArray<FVector>& InVertices) const;
+
+	int32 ControlPointCount;
+	TArray<int32> Splines;
+	/** Control points of Splines, ControlPointCount per spline. */
+	TArray<FVector> OldVertices;
+	TArray<FVector> NewVertices;
+	/** Grow mesh vertices of the combed splines, passed to UFurSplines::OnSplinesCombed. */
+	TArray<uint32> CombedVertices;
+};
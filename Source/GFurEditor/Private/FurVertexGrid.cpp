@@ -0,0 +1,99 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurVertexGrid.h"
+#include "Algo/Sort.h"
+#include "Rendering/PositionVertexBuffer.h"
+
+// average number of vertices of an occupied cell on a surface mesh
+static const double VerticesPerCell = 16.0;
+
+FIntVector FFurVertexGrid::GetCell(const FVector& Position) const
+{
+	return FIntVector(FMath::FloorToInt32(Position.X * InvCellSize), FMath::FloorToInt32(Position.Y * InvCellSize), FMath::FloorToInt32(Position.Z * InvCellSize));
+}
+
+void FFurVertexGrid::Build(const FPositionVertexBuffer& Positions)
+{
+	const int32 VertexCount = Positions.GetNumVertices();
+	Vertices.Reset();
+	Cells.Reset();
+	Bounds.Init();
+	if (VertexCount == 0)
+		return;
+
+	for (int32 VertexIndex = 0; VertexIndex < VertexCount; VertexIndex++)
+		Bounds += FVector(Positions.VertexPosition(VertexIndex));
+
+	// vertices lie on a surface, the area of the bounding box approximates it
+	const FVector Size = Bounds.GetSize();
+	const double Area = FMath::Max(2.0 * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X), UE_DOUBLE_KINDA_SMALL_NUMBER);
+	const double CellSize = FMath::Max(FMath::Sqrt(Area * VerticesPerCell / VertexCount), UE_DOUBLE_KINDA_SMALL_NUMBER);
+	InvCellSize = 1.0 / CellSize;
+
+	struct FCellVertex
+	{
+		FIntVector Cell;
+		uint32 Vertex;
+	};
+	TArray<FCellVertex> CellVertices;
+	CellVertices.SetNumUninitialized(VertexCount);
+	for (int32 VertexIndex = 0; VertexIndex < VertexCount; VertexIndex++)
+		CellVertices[VertexIndex] = { GetCell(FVector(Positions.VertexPosition(VertexIndex))), (uint32)VertexIndex };
+	Algo::Sort(CellVertices, [](const FCellVertex& A, const FCellVertex& B)
+	{
+		if (A.Cell.X != B.Cell.X)
+			return A.Cell.X < B.Cell.X;
+		if (A.Cell.Y != B.Cell.Y)
+			return A.Cell.Y < B.Cell.Y;
+		if (A.Cell.Z != B.Cell.Z)
+			return A.Cell.Z < B.Cell.Z;
+		return A.Vertex < B.Vertex;
+	});
+
+	Vertices.SetNumUninitialized(VertexCount);
+	for (int32 Index = 0; Index < VertexCount; Index++)
+	{
+		Vertices[Index] = CellVertices[Index].Vertex;
+		if (Index == 0 || CellVertices[Index].Cell != CellVertices[Index - 1].Cell)
+			Cells.Add(CellVertices[Index].Cell, { Index, 0 });
+		Cells.FindChecked(CellVertices[Index].Cell).Count++;
+	}
+}
+
+void FFurVertexGrid::GatherCandidates(const FVector& Center, float Radius, TArray<uint32>& OutVertices) const
+{
+	if (Cells.Num() == 0)
+		return;
+
+	// cells outside of the mesh are empty
+	const FBox QueryBox = FBox(Center - FVector(Radius), Center + FVector(Radius)).Overlap(Bounds);
+	if (!QueryBox.IsValid)
+		return;
+	const FIntVector MinCell = GetCell(QueryBox.Min);
+	const FIntVector MaxCell = GetCell(QueryBox.Max);
+	const int64 NumQueryCells = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1) * int64(MaxCell.Z - MinCell.Z + 1);
+
+	// a brush larger than the mesh covers mostly empty cells, occupied ones are fewer
+	if (NumQueryCells > Cells.Num())
+	{
+		for (const auto& Pair : Cells)
+		{
+			const FIntVector& Cell = Pair.Key;
+			if (Cell.X >= MinCell.X && Cell.X <= MaxCell.X && Cell.Y >= MinCell.Y && Cell.Y <= MaxCell.Y && Cell.Z >= MinCell.Z && Cell.Z <= MaxCell.Z)
+				OutVertices.Append(Vertices.GetData() + Pair.Value.First, Pair.Value.Count);
+		}
+		return;
+	}
+
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+			{
+				if (const FCell* Cell = Cells.Find(FIntVector(X, Y, Z)))
+					OutVertices.Append(Vertices.GetData() + Cell->First, Cell->Count);
+			}
+		}
+	}
+}
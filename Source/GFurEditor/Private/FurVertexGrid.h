@@ -0,0 +1,38 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FPositionVertexBuffer;
+
+/**
+ * Uniform grid over vertices of a grow mesh in component space. Splines grow from vertices, so neighbourhoods of the comb
+ * brush are found in time proportional to the number of vertices near the brush instead of all vertices.
+ */
+class FFurVertexGrid
+{
+public:
+	void Build(const FPositionVertexBuffer& Positions);
+
+	/** Appends vertices of cells overlapping the sphere, callers test the exact distance. Cells are visited in no particular order. */
+	void GatherCandidates(const FVector& Center, float Radius, TArray<uint32>& OutVertices) const;
+
+	/** Number of vertices the grid was built from, a different number means the mesh changed. */
+	int32 GetNumVertices() const { return Vertices.Num(); }
+
+private:
+	struct FCell
+	{
+		int32 First;
+		int32 Count;
+	};
+
+	FIntVector GetCell(const FVector& Position) const;
+
+	/** Vertices sorted by cells, cells reference consecutive ranges. */
+	TArray<uint32> Vertices;
+	TMap<FIntVector, FCell> Cells;
+	FBox Bounds = FBox(ForceInit);
+	double InvCellSize = 1.0;
+};
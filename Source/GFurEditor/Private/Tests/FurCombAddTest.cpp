@@ -0,0 +1,128 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurComb.h"
+#include "FurEditorTestUtils.h"
+#include "Misc/AutomationTest.h"
+#include "Rendering/PositionVertexBuffer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurCombAddTest
+{
+	/** CombAdd as it was before the root hash, every dab scans all roots. */
+	void AddSplinesReference(UFurSplines* FurSplines, const TArray<FVector3f>& Positions, const TArray<FVector>& Normals, const TArray<uint32>& VertexSet)
+	{
+		auto& Vertices = FurSplines->Vertices;
+		const int32 Count = FurSplines->ControlPointCount;
+		const float Tolerance = 0.1f;
+		FBox Bounds(ForceInit);
+		for (uint32 VertexIndex : VertexSet)
+			Bounds += FVector(Positions[VertexIndex]);
+		Bounds = Bounds.ExpandBy(Tolerance);
+
+		TArray<FVector> Roots;
+		for (int32 i = 0, SplineCount = FurSplines->SplineCount(); i < SplineCount; i++)
+		{
+			const FVector Root = FurSplines->GetFirstControlPoint(i);
+			if (Bounds.IsInsideOrOn(Root))
+				Roots.Add(Root);
+		}
+
+		for (uint32 VertexIndex : VertexSet)
+		{
+			const FVector v = FVector(Positions[VertexIndex]);
+			const bool Found = Roots.ContainsByPredicate([&v, Tolerance](const FVector& Root) { return FVector::DistSquared(v, Root) <= Tolerance * Tolerance; });
+			if (Found)
+				continue;
+			const FVector n = Normals[VertexIndex];
+			const int32 s = Vertices.AddUninitialized(Count);
+			for (int32 i = 0; i < Count; i++)
+				Vertices[s + i] = v + n * (i / (float)(Count - 1));
+			Roots.Add(v);
+		}
+	}
+
+	void RemoveSplinesReference(UFurSplines* FurSplines, TArray<int32> Splines)
+	{
+		Splines.Sort();
+		const int32 Count = FurSplines->ControlPointCount;
+		for (int32 i = Splines.Num() - 1; i >= 0; i--)
+			FurSplines->Vertices.RemoveAt(Splines[i] * Count, Count, false);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurCombAddTest, "GFur.Editor.Comb.AddMatchesFullScan", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** Dabs adding and removing splines on a 100k vertex mesh give the same splines as scanning all roots in every dab. */
+bool FFurCombAddTest::RunTest(const FString& Parameters)
+{
+	using namespace FurEditorTest;
+	using namespace FurCombAddTest;
+
+	// vertices of a 400 x 250 grid, some of them duplicated like vertices of UV seams
+	constexpr int32 NumX = 400;
+	constexpr int32 NumY = 250;
+	constexpr float Spacing = 0.15f;
+	FRandomStream Random(17);
+	TArray<FVector3f> PositionArray;
+	TArray<FVector> Normals;
+	PositionArray.Reserve(NumX * NumY);
+	for (int32 Y = 0; Y < NumY; Y++)
+	{
+		for (int32 X = 0; X < NumX; X++)
+		{
+			if (PositionArray.Num() && Random.FRand() < 0.02f)
+				PositionArray.Add(PositionArray.Last() + FVector3f(Random.FRandRange(-0.05f, 0.05f), 0.0f, 0.0f));
+			else
+				PositionArray.Add(FVector3f(X * Spacing, Y * Spacing, FMath::Sin(X * 0.1f) * 0.5f));
+			Normals.Add(FVector(Random.FRandRange(-0.2f, 0.2f), Random.FRandRange(-0.2f, 0.2f), 1.0f).GetSafeNormal());
+		}
+	}
+	TestTrue(TEXT("At least 100k vertices"), PositionArray.Num() >= 100000);
+	FPositionVertexBuffer Positions;
+	Positions.Init(PositionArray, true);
+
+	// existing splines over a part of the mesh
+	UFurSplines* Splines = MakeSplines(150, 100, 4, 0.2f);
+	UFurSplines* Reference = DuplicateObject(Splines, GetTransientPackage());
+
+	FFurComb Comb;
+	for (int32 Dab = 0; Dab < 40; Dab++)
+	{
+		// vertices under a brush at a random location
+		const FVector3f Center(Random.FRandRange(0.0f, NumX * Spacing), Random.FRandRange(0.0f, NumY * Spacing), 0.0f);
+		const float Radius = Random.FRandRange(0.5f, 4.0f);
+		TArray<uint32> BrushVertices;
+		for (int32 VertexIndex = 0; VertexIndex < PositionArray.Num(); VertexIndex++)
+		{
+			if (FVector2f::Distance(FVector2f(PositionArray[VertexIndex]), FVector2f(Center)) < Radius)
+				BrushVertices.Add(VertexIndex);
+		}
+
+		// every fourth dab removes splines under the brush, which moves roots of all following splines
+		if (Dab % 4 == 3)
+		{
+			TArray<int32> Removed;
+			for (int32 SplineIndex = 0; SplineIndex < Splines->SplineCount(); SplineIndex++)
+			{
+				if (FVector2f::Distance(FVector2f(FVector3f(Splines->GetFirstControlPoint(SplineIndex))), FVector2f(Center)) < Radius)
+					Removed.Add(SplineIndex);
+			}
+			if (Removed.Num())
+			{
+				Comb.RemoveSplinesForTest(Splines, Removed);
+				RemoveSplinesReference(Reference, Removed);
+			}
+			continue;
+		}
+
+		Comb.AddSplinesForTest(Splines, Positions, Normals, BrushVertices);
+		AddSplinesReference(Reference, PositionArray, Normals, BrushVertices);
+		if (!TestTrue(FString::Printf(TEXT("Dab %d matches the full scan"), Dab), Splines->Vertices == Reference->Vertices))
+			break;
+	}
+	TestTrue(TEXT("Splines were added"), Splines->SplineCount() > 150 * 100);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
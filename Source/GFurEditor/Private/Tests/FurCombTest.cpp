@@ -0,0 +1,70 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurComb.h"
+#include "FurEditorTestUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurCombParallelTest, "GFur.Editor.Comb.ParallelMatchesSerial", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** Every comb mode gives bit for bit the same control points with gFur.ParallelComb on and off. */
+bool FFurCombParallelTest::RunTest(const FString& Parameters)
+{
+	using namespace FurEditorTest;
+
+	// a brush covering thousands of splines is combed in many batches
+	UFurSplines* Source = MakeSplines(120, 120, 6, 0.1f);
+	const FVector Center(6.0f, 6.0f, 0.0f);
+	const float Radius = 3.0f;
+	TArray<int32> BrushSplines;
+	for (int32 SplineIndex = 0; SplineIndex < Source->SplineCount(); SplineIndex++)
+	{
+		if (FVector::Dist(Source->GetFirstControlPoint(SplineIndex), Center) < Radius)
+			BrushSplines.Add(SplineIndex);
+	}
+	// the order of the spline set of the brush isn't sorted
+	FRandomStream Random(5);
+	for (int32 i = BrushSplines.Num() - 1; i > 0; i--)
+		BrushSplines.Swap(i, Random.RandRange(0, i));
+
+	const EFurCombMode Modes[] = { EFurCombMode::Length, EFurCombMode::AverageLength, EFurCombMode::Bend, EFurCombMode::Clump,
+		EFurCombMode::Twist, EFurCombMode::Noise, EFurCombMode::Curl, EFurCombMode::Relax };
+	const TCHAR* ModeNames[] = { TEXT("Length"), TEXT("AverageLength"), TEXT("Bend"), TEXT("Clump"), TEXT("Twist"), TEXT("Noise"), TEXT("Curl"), TEXT("Relax") };
+
+	for (int32 ModeIndex = 0; ModeIndex < UE_ARRAY_COUNT(Modes); ModeIndex++)
+	{
+		TArray<FVector> Results[2];
+		for (int32 Parallel = 0; Parallel < 2; Parallel++)
+		{
+			FScopedConsoleVariable ParallelComb(TEXT("gFur.ParallelComb"), Parallel);
+			if (!TestTrue(TEXT("gFur.ParallelComb exists"), ParallelComb.IsValid()))
+				return false;
+
+			UFurSplines* Splines = DuplicateObject(Source, GetTransientPackage());
+			FFurComb Comb;
+			// a short stroke of dabs with both signs of the strength
+			for (int32 Dab = 0; Dab < 4; Dab++)
+			{
+				FFurComb::FTestDab TestDab;
+				TestDab.Location = Center + FVector(Dab * 0.3f, Dab * -0.2f, 0.5f);
+				TestDab.OldLocation = Center + FVector((Dab - 1) * 0.3f, (Dab - 1) * -0.2f, 0.5f);
+				TestDab.Normal = FVector::UpVector;
+				TestDab.Radius = Radius;
+				TestDab.Strength = Dab % 2 ? -0.3f : 0.5f;
+				TestDab.Falloff = 0.4f;
+				TestDab.ApplyHeight = 0.6f;
+				TestDab.ApplySpread = Dab % 2 ? -0.3f : 0.3f;
+				TestDab.TwistCount = 1.5f;
+				Comb.CombForTest(Modes[ModeIndex], Splines, BrushSplines, TestDab);
+			}
+			Results[Parallel] = Splines->Vertices;
+		}
+
+		TestTrue(FString::Printf(TEXT("%s changed the splines"), ModeNames[ModeIndex]), Results[0] != Source->Vertices);
+		TestTrue(FString::Printf(TEXT("%s parallel matches serial"), ModeNames[ModeIndex]), Results[0] == Results[1]);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,66 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FurSplines.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurEditorTest
+{
+	/** Splines growing from a NumX by NumY grid of roots in the XY plane, bent randomly but reproducibly. */
+	inline UFurSplines* MakeSplines(int32 NumX, int32 NumY, int32 ControlPointCount, float Spacing, int32 Seed = 1)
+	{
+		UFurSplines* Splines = NewObject<UFurSplines>();
+		Splines->ControlPointCount = ControlPointCount;
+		Splines->Vertices.Reserve(NumX * NumY * ControlPointCount);
+
+		FRandomStream Random(Seed);
+		for (int32 Y = 0; Y < NumY; Y++)
+		{
+			for (int32 X = 0; X < NumX; X++)
+			{
+				FVector Point(X * Spacing + Random.FRandRange(-0.25f, 0.25f) * Spacing, Y * Spacing + Random.FRandRange(-0.25f, 0.25f) * Spacing, 0.0f);
+				const FVector Bend(Random.FRandRange(-0.3f, 0.3f), Random.FRandRange(-0.3f, 0.3f), 1.0f);
+				for (int32 i = 0; i < ControlPointCount; i++)
+				{
+					Splines->Vertices.Add(Point);
+					Point += (Bend + FVector(0.0f, 0.0f, Random.FRandRange(0.0f, 0.5f))) * 0.2f;
+				}
+			}
+		}
+		return Splines;
+	}
+
+	/** Sets an integer console variable for the scope of a test. */
+	class FScopedConsoleVariable
+	{
+	public:
+		FScopedConsoleVariable(const TCHAR* Name, int32 Value)
+			: Variable(IConsoleManager::Get().FindConsoleVariable(Name))
+		{
+			if (Variable)
+			{
+				OldValue = Variable->GetInt();
+				Variable->Set(Value, ECVF_SetByConsole);
+			}
+		}
+
+		~FScopedConsoleVariable()
+		{
+			if (Variable)
+				Variable->Set(OldValue, ECVF_SetByConsole);
+		}
+
+		bool IsValid() const { return Variable != nullptr; }
+
+	private:
+		IConsoleVariable* Variable;
+		int32 OldValue = 0;
+	};
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,134 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurComponentCustomization.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Crc.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurGroomExportTest
+{
+	/** Flat grid with a guide spline in every vertex and UVs following positions, the last triangles are degenerate. */
+	struct FGroom
+	{
+		TArray<FVector3f> Guides;
+		TArray<FVector2f> GuideUVs;
+		TArray<FVector3f> TriangleVertices;
+		TArray<FVector2f> TriangleUVs;
+		TArray<int32> TriangleSplines;
+	};
+
+	const int32 GridSize = 30;
+	const int32 ControlPointCount = 5;
+
+	FGroom MakeGroom()
+	{
+		FRandomStream Random(99);
+		FGroom Groom;
+		for (int32 y = 0; y < GridSize; y++)
+		{
+			for (int32 x = 0; x < GridSize; x++)
+			{
+				for (int32 Point = 0; Point < ControlPointCount; Point++)
+					Groom.Guides.Add(FVector3f(x, y, 0.0f) + FVector3f(Random.FRandRange(-0.2f, 0.2f), Random.FRandRange(-0.2f, 0.2f), 0.5f) * Point);
+				Groom.GuideUVs.Add(FVector2f(x, y) / GridSize);
+			}
+		}
+
+		auto AddTriangle = [&Groom](int32 A, int32 B, int32 C)
+		{
+			for (int32 Spline : { A, B, C })
+			{
+				Groom.TriangleVertices.Add(Groom.Guides[Spline * ControlPointCount]);
+				Groom.TriangleUVs.Add(Groom.GuideUVs[Spline]);
+				Groom.TriangleSplines.Add(Spline);
+			}
+		};
+		for (int32 y = 0; y < GridSize - 1; y++)
+		{
+			for (int32 x = 0; x < GridSize - 1; x++)
+			{
+				const int32 i = y * GridSize + x;
+				AddTriangle(i, i + 1, i + GridSize + 1);
+				AddTriangle(i, i + GridSize + 1, i + GridSize);
+			}
+		}
+		AddTriangle(0, 1, 2);
+		AddTriangle(5, 5, 5);
+		return Groom;
+	}
+
+	/** Generates strands of the first NumTriangles triangles, returns the hash of the exported points and UVs. */
+	uint32 Generate(const FGroom& Groom, int32 NumTriangles, float CountFactor, TArray<FVector3f>& OutPoints, TArray<FVector2f>& OutUVs, int32& OutStrandCount)
+	{
+		OutPoints = Groom.Guides;
+		OutUVs = Groom.GuideUVs;
+		TArray<FVector3f> TriangleVertices(Groom.TriangleVertices.GetData(), NumTriangles * 3);
+		TArray<FVector2f> TriangleUVs(Groom.TriangleUVs.GetData(), NumTriangles * 3);
+		TArray<int32> TriangleSplines(Groom.TriangleSplines.GetData(), NumTriangles * 3);
+		OutStrandCount = FFurComponentCustomization::GenerateStrandsForTest(OutPoints, OutUVs, TriangleVertices, TriangleUVs, TriangleSplines, ControlPointCount, CountFactor);
+		const uint32 PointsHash = FCrc::MemCrc32(OutPoints.GetData(), OutPoints.Num() * sizeof(FVector3f));
+		return FCrc::MemCrc32(OutUVs.GetData(), OutUVs.Num() * sizeof(FVector2f), PointsHash);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurGroomExportTest, "GFur.Editor.Export.DeterministicStrands", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurGroomExportTest::RunTest(const FString& Parameters)
+{
+	using namespace FurGroomExportTest;
+
+	const FGroom Groom = MakeGroom();
+	const int32 NumTriangles = Groom.TriangleSplines.Num() / 3;
+	const int32 NumGuides = GridSize * GridSize;
+	// a fractional count per triangle, so remainders are carried between triangles
+	const float CountFactor = 7.3f;
+
+	TArray<FVector3f> Points;
+	TArray<FVector2f> UVs;
+	int32 StrandCount = 0;
+	const uint32 Hash = Generate(Groom, NumTriangles, CountFactor, Points, UVs, StrandCount);
+
+	// every cell triangle has a cross product of length one, degenerate triangles add nothing
+	const float ExpectedCount = (GridSize - 1) * (GridSize - 1) * 2 * CountFactor;
+	TestTrue(TEXT("Strand count"), FMath::Abs(StrandCount - ExpectedCount) <= 1.0f);
+	TestEqual(TEXT("Exported points"), Points.Num(), (NumGuides + StrandCount) * ControlPointCount);
+	TestEqual(TEXT("Exported UVs"), UVs.Num(), NumGuides + StrandCount);
+	TestTrue(TEXT("Guides are exported first"), FMemory::Memcmp(Points.GetData(), Groom.Guides.GetData(), Groom.Guides.Num() * sizeof(FVector3f)) == 0);
+
+	// the same inputs export the same point set, however the triangles were spread over workers
+	for (int32 Run = 0; Run < 4; Run++)
+	{
+		TArray<FVector3f> RunPoints;
+		TArray<FVector2f> RunUVs;
+		int32 RunStrandCount = 0;
+		TestEqual(FString::Printf(TEXT("Hash of run %d"), Run), Generate(Groom, NumTriangles, CountFactor, RunPoints, RunUVs, RunStrandCount), Hash);
+	}
+
+	// strands of a triangle don't depend on the triangles after it
+	{
+		TArray<FVector3f> PrefixPoints;
+		TArray<FVector2f> PrefixUVs;
+		int32 PrefixStrandCount = 0;
+		Generate(Groom, NumTriangles / 3, CountFactor, PrefixPoints, PrefixUVs, PrefixStrandCount);
+		TestTrue(TEXT("Strands of the first triangles"), PrefixStrandCount < StrandCount
+			&& FMemory::Memcmp(PrefixPoints.GetData(), Points.GetData(), PrefixPoints.Num() * sizeof(FVector3f)) == 0
+			&& FMemory::Memcmp(PrefixUVs.GetData(), UVs.GetData(), PrefixUVs.Num() * sizeof(FVector2f)) == 0);
+	}
+
+	// roots lie in the grid and UVs are interpolated with the same barycentric coordinates
+	for (int32 Strand = 0; Strand < StrandCount; Strand++)
+	{
+		const FVector3f& Root = Points[(NumGuides + Strand) * ControlPointCount];
+		const FVector2f& UV = UVs[NumGuides + Strand];
+		const bool InGrid = Root.X >= -KINDA_SMALL_NUMBER && Root.Y >= -KINDA_SMALL_NUMBER && Root.X <= GridSize - 1 + KINDA_SMALL_NUMBER
+			&& Root.Y <= GridSize - 1 + KINDA_SMALL_NUMBER && FMath::IsNearlyZero(Root.Z);
+		const bool UVMatches = FMath::IsNearlyEqual(UV.X * GridSize, Root.X, 1.0e-3f) && FMath::IsNearlyEqual(UV.Y * GridSize, Root.Y, 1.0e-3f);
+		if (!TestTrue(FString::Printf(TEXT("Strand %d root and UV"), Strand), InGrid && UVMatches))
+			break;
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,125 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurMeshBVH.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Rendering/PositionVertexBuffer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurMeshBVHTest
+{
+	/** Trace of LineTraceComponent before the hierarchy, every triangle is tested and the first one wins ties. */
+	bool LineTraceReference(const TArray<FVector3f>& Positions, const TArray<uint32>& Indices, const FVector& Start, const FVector& End, FVector& OutIntersect, FVector& OutNormal)
+	{
+		float MinDistance = FLT_MAX;
+		for (int32 TriangleIndex = 0; TriangleIndex < Indices.Num() / 3; ++TriangleIndex)
+		{
+			const FVector P0 = FVector(Positions[Indices[TriangleIndex * 3 + 0]]);
+			const FVector P1 = FVector(Positions[Indices[TriangleIndex * 3 + 1]]);
+			const FVector P2 = FVector(Positions[Indices[TriangleIndex * 3 + 2]]);
+			const FVector TriNorm = (P1 - P0) ^ (P2 - P0);
+			if (TriNorm.SizeSquared() <= SMALL_NUMBER)
+				continue;
+
+			FVector IntersectPoint;
+			FVector HitNormal;
+			if (FMath::SegmentTriangleIntersection(Start, End, P0, P1, P2, IntersectPoint, HitNormal))
+			{
+				const float Distance = (Start - IntersectPoint).SizeSquared();
+				if (Distance < MinDistance)
+				{
+					MinDistance = Distance;
+					OutIntersect = IntersectPoint;
+					OutNormal = HitNormal;
+				}
+			}
+		}
+		return MinDistance != FLT_MAX;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurMeshBVHTest, "GFur.Editor.Comb.BVHMatchesBruteForce", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurMeshBVHTest::RunTest(const FString& Parameters)
+{
+	using namespace FurMeshBVHTest;
+
+	FRandomStream Random(2024);
+	TArray<FVector3f> Positions;
+	TArray<uint32> Indices;
+
+	// flat grid of coplanar triangles sharing edges, so rays through edges and vertices hit several triangles at once
+	const int32 GridSize = 40;
+	for (int32 y = 0; y <= GridSize; y++)
+		for (int32 x = 0; x <= GridSize; x++)
+			Positions.Add(FVector3f(x - GridSize * 0.5f, y - GridSize * 0.5f, 0.0f));
+	for (int32 y = 0; y < GridSize; y++)
+	{
+		for (int32 x = 0; x < GridSize; x++)
+		{
+			const uint32 i = y * (GridSize + 1) + x;
+			Indices.Append({ i, i + 1, i + GridSize + 2, i, i + GridSize + 2, i + GridSize + 1 });
+		}
+	}
+
+	// random soup of overlapping triangles, some of them degenerate
+	for (int32 Triangle = 0; Triangle < 3000; Triangle++)
+	{
+		const FVector3f Center = FVector3f(Random.FRandRange(-20.0f, 20.0f), Random.FRandRange(-20.0f, 20.0f), Random.FRandRange(-10.0f, 10.0f));
+		const uint32 First = Positions.Num();
+		for (int32 Corner = 0; Corner < 3; Corner++)
+			Positions.Add(Center + FVector3f(Random.GetUnitVector()) * Random.FRandRange(0.1f, 3.0f));
+		if (Triangle % 100 == 0)
+			Positions[First + 2] = Positions[First + 1];
+		Indices.Append({ First, First + 1, First + 2 });
+	}
+
+	FPositionVertexBuffer PositionBuffer;
+	PositionBuffer.Init(Positions);
+	FFurMeshBVH BVH;
+	BVH.Build(PositionBuffer, Indices.Num(), [&Indices](int32 Index) { return Indices[Index]; });
+	TestEqual(TEXT("Source indices"), BVH.GetNumSourceIndices(), Indices.Num());
+
+	int32 NumHits = 0;
+	for (int32 Ray = 0; Ray < 4000; Ray++)
+	{
+		FVector Start = FVector(Random.GetUnitVector()) * 60.0;
+		FVector End = FVector(Random.FRandRange(-25.0f, 25.0f), Random.FRandRange(-25.0f, 25.0f), Random.FRandRange(-12.0f, 12.0f));
+		if (Ray % 4 == 1)
+		{
+			// axis aligned rays exercise the parallel slabs of the boxes
+			End = Start;
+			End[Ray % 3] = -Start[Ray % 3];
+		}
+		else if (Ray % 4 == 2)
+		{
+			// through a vertex of the grid
+			End = FVector(Positions[Random.RandHelper((GridSize + 1) * (GridSize + 1))]);
+		}
+		else if (Ray % 4 == 3)
+		{
+			// segments ending short of the mesh
+			End = Start + (End - Start) * Random.FRandRange(0.1f, 0.9f);
+		}
+
+		FVector ReferenceIntersect = FVector::ZeroVector;
+		FVector ReferenceNormal = FVector::ZeroVector;
+		FVector Intersect = FVector::ZeroVector;
+		FVector Normal = FVector::ZeroVector;
+		const bool ReferenceHit = LineTraceReference(Positions, Indices, Start, End, ReferenceIntersect, ReferenceNormal);
+		const bool Hit = BVH.LineTrace(Start, End, Intersect, Normal);
+		if (!TestEqual(FString::Printf(TEXT("Ray %d hits"), Ray), Hit, ReferenceHit))
+			return false;
+		if (Hit)
+		{
+			NumHits++;
+			TestTrue(FString::Printf(TEXT("Ray %d intersection"), Ray), Intersect == ReferenceIntersect);
+			TestTrue(FString::Printf(TEXT("Ray %d normal"), Ray), Normal == ReferenceNormal);
+		}
+	}
+	TestTrue(TEXT("Most rays hit"), NumHits > 1000);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
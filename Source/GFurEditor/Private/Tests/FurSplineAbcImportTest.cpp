@@ -0,0 +1,160 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurSplineAbcImporterFactory.h"
+#include "FurSplines.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#endif
+
+PRAGMA_DEFAULT_VISIBILITY_START
+THIRD_PARTY_INCLUDES_START
+#include <Alembic/AbcGeom/All.h>
+#include <Alembic/AbcCoreOgawa/All.h>
+THIRD_PARTY_INCLUDES_END
+PRAGMA_DEFAULT_VISIBILITY_END
+
+#if PLATFORM_WINDOWS
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+namespace FurSplineAbcImportTest
+{
+	/** Splines the importer should read before they are made uniform, in the order of the hierarchy. */
+	struct FExpectedSplines
+	{
+		TArray<int32> Index;
+		TArray<int32> Count;
+		TArray<FVector> Vertices;
+	};
+
+	Imath::M44d MakeMatrix(double Scale, const Imath::V3d& Translation)
+	{
+		// row vectors like FMatrix, translation in the last row
+		Imath::M44d Matrix;
+		Matrix.makeIdentity();
+		Matrix[0][0] = Matrix[1][1] = Matrix[2][2] = Scale;
+		Matrix[3][0] = Translation.x;
+		Matrix[3][1] = Translation.y;
+		Matrix[3][2] = Translation.z;
+		return Matrix;
+	}
+
+	/**
+	 * Writes curves of NumCurves splines under parent. ExpectedCurves of them fit the points, the rest are cut off like a
+	 * broken export. Points are transformed by Transform into the expected splines.
+	 */
+	void WriteCurves(Alembic::Abc::OObject Parent, const char* Name, int32 NumCurves, int32 ExpectedCurves, bool VaryingCounts, FRandomStream& Random,
+		TFunctionRef<FVector(const FVector&)> Transform, FExpectedSplines& OutExpected)
+	{
+		std::vector<Imath::V3f> Points;
+		std::vector<int32_t> NumVertices;
+		for (int32 Curve = 0; Curve < NumCurves; Curve++)
+		{
+			const int32 Count = VaryingCounts ? Random.RandRange(2, 9) : 6;
+			NumVertices.push_back(Count);
+			if (Curve >= ExpectedCurves)
+				continue;
+
+			OutExpected.Index.Add(OutExpected.Vertices.Num());
+			OutExpected.Count.Add(Count);
+			const FVector Root = FVector(Random.GetUnitVector()) * 10.0;
+			for (int32 Point = 0; Point < Count; Point++)
+			{
+				const FVector3f Position = FVector3f(Root + FVector(Random.GetUnitVector()) * 0.1 + FVector(0.0, 0.0, Point));
+				Points.push_back(Imath::V3f(Position.X, Position.Y, Position.Z));
+				OutExpected.Vertices.Add(Transform(FVector(Position)));
+			}
+		}
+		// the first cut off curve has a few of its points, the rest have none
+		if (ExpectedCurves < NumCurves)
+			Points.insert(Points.end(), NumVertices[ExpectedCurves] / 2, Imath::V3f(0.0f, 0.0f, 0.0f));
+
+		Alembic::AbcGeom::OCurves Curves(Parent, Name);
+		Curves.getSchema().set(Alembic::AbcGeom::OCurvesSchema::Sample(Alembic::Abc::P3fArraySample(Points), Alembic::Abc::Int32ArraySample(NumVertices)));
+	}
+
+	Alembic::AbcGeom::OXform WriteXform(Alembic::Abc::OObject Parent, const char* Name, const Imath::M44d& Matrix, bool bInherits)
+	{
+		Alembic::AbcGeom::OXform Xform(Parent, Name);
+		Alembic::AbcGeom::XformSample Sample;
+		Sample.setMatrix(Matrix);
+		Sample.setInheritsXforms(bInherits);
+		Xform.getSchema().set(Sample);
+		return Xform;
+	}
+
+	/** Writes a groom with nested, inheriting and detached transformations and a broken curves object. */
+	FExpectedSplines WriteArchive(const FString& Filename, bool VaryingCounts)
+	{
+		FRandomStream Random(VaryingCounts ? 11 : 7);
+		FExpectedSplines Expected;
+
+		Alembic::Abc::OArchive Archive(Alembic::AbcCoreOgawa::WriteArchive(), TCHAR_TO_UTF8(*Filename));
+		Alembic::Abc::OObject Top = Archive.getTop();
+
+		Alembic::AbcGeom::OXform Groom = WriteXform(Top, "Groom", MakeMatrix(2.0, Imath::V3d(1.0, 2.0, 3.0)), true);
+		Alembic::AbcGeom::OXform Child = WriteXform(Groom, "Child", MakeMatrix(1.0, Imath::V3d(0.0, 0.0, 5.0)), true);
+		WriteCurves(Child, "Strands", 200, 200, VaryingCounts, Random, [](const FVector& P) { return (P + FVector(0.0, 0.0, 5.0)) * 2.0 + FVector(1.0, 2.0, 3.0); }, Expected);
+		Alembic::AbcGeom::OXform Detached = WriteXform(Groom, "Detached", MakeMatrix(1.0, Imath::V3d(10.0, 0.0, 0.0)), false);
+		WriteCurves(Detached, "Strands", 80, 80, VaryingCounts, Random, [](const FVector& P) { return P + FVector(10.0, 0.0, 0.0); }, Expected);
+		WriteCurves(Top, "Broken", 30, 21, VaryingCounts, Random, [](const FVector& P) { return P; }, Expected);
+		return Expected;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurSplineAbcImportTest, "GFur.Editor.Import.AlembicRoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurSplineAbcImportTest::RunTest(const FString& Parameters)
+{
+	using namespace FurSplineAbcImportTest;
+
+	const FString Filename = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("FurSplinesRoundTrip.abc"));
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+
+	for (bool VaryingCounts : { false, true })
+	{
+		const FExpectedSplines Expected = WriteArchive(Filename, VaryingCounts);
+		for (int32 Conversion : { 0, 1 })
+		{
+			UFurSplines* Splines = NewObject<UFurSplines>();
+			if (!TestTrue(TEXT("Import succeeded"), ImportFurSplinesFromAlembicForTest(Filename, Splines, Conversion)))
+				return false;
+
+			// the reference goes through the same resampling to a uniform count, conversion 1 swaps Y and Z
+			UFurSplines* Reference = NewObject<UFurSplines>();
+			Reference->Index = Expected.Index;
+			Reference->Count = Expected.Count;
+			Reference->Vertices = Expected.Vertices;
+			if (Conversion == 1)
+			{
+				for (FVector& Vertex : Reference->Vertices)
+					Swap(Vertex.Y, Vertex.Z);
+			}
+			Reference->Version = 1;
+			Reference->UpdateSplines();
+
+			const FString What = FString::Printf(TEXT("%s counts, conversion %d"), VaryingCounts ? TEXT("varying") : TEXT("uniform"), Conversion);
+			TestEqual(What + TEXT(": control point count"), Splines->ControlPointCount, Reference->ControlPointCount);
+			TestTrue(What + TEXT(": spline indices"), Splines->Index == Reference->Index && Splines->Count == Reference->Count);
+			if (!TestEqual(What + TEXT(": number of control points"), Splines->Vertices.Num(), Reference->Vertices.Num()))
+				return false;
+			for (int32 i = 0; i < Splines->Vertices.Num(); i++)
+			{
+				if (!TestTrue(FString::Printf(TEXT("%s: control point %d"), *What, i), Splines->Vertices[i].Equals(Reference->Vertices[i], 1.0e-4)))
+					break;
+			}
+		}
+	}
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
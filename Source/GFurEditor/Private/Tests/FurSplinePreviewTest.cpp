@@ -0,0 +1,63 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurSplinePreviewComponent.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurSplinePreviewIndicesTest, "GFur.Editor.SplinePreview.DecimatedPrefixes", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurSplinePreviewIndicesTest::RunTest(const FString& Parameters)
+{
+	const int32 ChunkSize = UFurSplinePreviewComponent::ChunkSize;
+	const int32 ControlPointCount = 5;
+	const int32 SplineLines = ControlPointCount - 1;
+
+	// the last chunk is partial
+	for (int32 SplineCount : { 1, 100, ChunkSize, ChunkSize * 3 + 77 })
+	{
+		TArray<uint32> Indices;
+		UFurSplinePreviewComponent::BuildLineIndices(SplineCount, ControlPointCount, Indices);
+		if (!TestEqual(TEXT("Index count"), Indices.Num(), SplineCount * SplineLines * 2))
+			return false;
+
+		// every spline is drawn once as connected segments
+		TArray<int32> Drawn;
+		Drawn.SetNumZeroed(SplineCount);
+		for (int32 i = 0; i < Indices.Num(); i += 2)
+		{
+			const uint32 Spline = Indices[i] / ControlPointCount;
+			TestEqual(TEXT("Segment within a spline"), Indices[i + 1], Indices[i] + 1);
+			TestEqual(TEXT("Segment ends within the spline"), Indices[i + 1] / ControlPointCount, Spline);
+			if (Indices[i] % ControlPointCount == 0)
+				Drawn[Spline]++;
+		}
+		for (int32 Spline = 0; Spline < SplineCount; Spline++)
+			TestEqual(FString::Printf(TEXT("Spline %d of %d drawn once"), Spline, SplineCount), Drawn[Spline], 1);
+
+		// a prefix of a chunk's index range are exactly the splines with a chunk index divisible by the stride
+		for (int32 Begin = 0; Begin < SplineCount; Begin += ChunkSize)
+		{
+			const int32 ChunkSplines = FMath::Min(ChunkSize, SplineCount - Begin);
+			for (int32 Stride = 1; Stride <= ChunkSize; Stride *= 2)
+			{
+				const int32 ShownSplines = FMath::DivideAndRoundUp(ChunkSplines, Stride);
+				TSet<int32> Shown;
+				for (int32 i = 0; i < ShownSplines * SplineLines * 2; i++)
+					Shown.Add(Indices[Begin * SplineLines * 2 + i] / ControlPointCount - Begin);
+				bool Match = Shown.Num() == ShownSplines;
+				for (int32 k : Shown)
+					Match &= (k % Stride) == 0;
+				TestTrue(FString::Printf(TEXT("Chunk at %d of %d with stride %d"), Begin, SplineCount, Stride), Match);
+			}
+		}
+	}
+
+	TestEqual(TEXT("No decimation"), UFurSplinePreviewComponent::GetDecimationStride(1000.0f, 0.0f), 1);
+	TestEqual(TEXT("Near chunk"), UFurSplinePreviewComponent::GetDecimationStride(5.0f, 10.0f), 1);
+	TestEqual(TEXT("Rounded down to a power of two"), UFurSplinePreviewComponent::GetDecimationStride(70.0f, 10.0f), 4);
+	TestEqual(TEXT("Clamped to the chunk"), UFurSplinePreviewComponent::GetDecimationStride(1.0e12f, 1.0f), ChunkSize);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,112 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurComb.h"
+#include "FurSplinesCombChange.h"
+#include "FurEditorTestUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurSplinesCombChangeTest
+{
+	/** Combs splines with roots within Radius of the center in a few dabs, returns the undo record of the stroke. */
+	TUniquePtr<FFurSplinesCombChange> CombStroke(UFurSplines* Splines, const FVector& Center, float Radius, int32& OutNumCombed)
+	{
+		TArray<int32> BrushSplines;
+		for (int32 SplineIndex = 0; SplineIndex < Splines->SplineCount(); SplineIndex++)
+		{
+			if (FVector::Dist(Splines->GetFirstControlPoint(SplineIndex), Center) < Radius)
+				BrushSplines.Add(SplineIndex);
+		}
+		OutNumCombed = BrushSplines.Num();
+
+		FFurComb Comb;
+		for (int32 Dab = 0; Dab < 3; Dab++)
+		{
+			FFurComb::FTestDab TestDab;
+			TestDab.Location = Center + FVector(0.0f, 0.0f, 0.5f);
+			TestDab.OldLocation = Center + FVector(-0.2f * (Dab + 1), 0.0f, 0.5f);
+			TestDab.Normal = FVector::UpVector;
+			TestDab.Radius = Radius;
+			TestDab.Strength = 0.4f;
+			TestDab.Falloff = 0.5f;
+			TestDab.ApplyHeight = 0.5f;
+			TestDab.ApplySpread = 0.0f;
+			TestDab.TwistCount = 1.0f;
+			// the same splines combed again by every dab are recorded once
+			Comb.CombForTest(EFurCombMode::Bend, Splines, BrushSplines, TestDab);
+		}
+		return Comb.EndStrokeForTest(Splines);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurSplinesCombChangeMemoryTest, "GFur.Editor.Comb.UndoMemory", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** Undo memory of a stroke depends on the splines under the brush, not on all splines of the asset. */
+bool FFurSplinesCombChangeMemoryTest::RunTest(const FString& Parameters)
+{
+	using namespace FurEditorTest;
+	using namespace FurSplinesCombChangeTest;
+	constexpr int32 ControlPointCount = 8;
+	const FVector Center(5.0f, 5.0f, 0.0f);
+	const SIZE_T BytesPerSpline = sizeof(int32) + 2 * ControlPointCount * sizeof(FVector);
+
+	UFurSplines* SmallAsset = MakeSplines(100, 100, ControlPointCount, 0.1f);
+	UFurSplines* LargeAsset = MakeSplines(400, 400, ControlPointCount, 0.1f);
+
+	int32 NumSmall = 0, NumLarge = 0, NumWide = 0;
+	TUniquePtr<FFurSplinesCombChange> Small = CombStroke(SmallAsset, Center, 1.0f, NumSmall);
+	TUniquePtr<FFurSplinesCombChange> Large = CombStroke(LargeAsset, Center, 1.0f, NumLarge);
+	TUniquePtr<FFurSplinesCombChange> Wide = CombStroke(LargeAsset, Center, 3.0f, NumWide);
+	if (!TestTrue(TEXT("Strokes recorded"), Small.IsValid() && Large.IsValid() && Wide.IsValid()))
+		return false;
+
+	// allocations may be rounded up by the allocator policy, but never hold control points of untouched splines
+	TestTrue(TEXT("Small stroke on the small asset"), Small->GetAllocatedSize() >= NumSmall * BytesPerSpline && Small->GetAllocatedSize() <= NumSmall * BytesPerSpline * 3 / 2 + 256);
+	TestTrue(TEXT("Small stroke on the large asset"), Large->GetAllocatedSize() >= NumLarge * BytesPerSpline && Large->GetAllocatedSize() <= NumLarge * BytesPerSpline * 3 / 2 + 256);
+	TestTrue(TEXT("Wide stroke on the large asset"), Wide->GetAllocatedSize() >= NumWide * BytesPerSpline && Wide->GetAllocatedSize() <= NumWide * BytesPerSpline * 3 / 2 + 256);
+	TestTrue(TEXT("Far less than a copy of the asset"), Large->GetAllocatedSize() * 20 < (SIZE_T)LargeAsset->Vertices.GetAllocatedSize());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurSplinesCombChangeUndoTest, "GFur.Editor.Comb.UndoRedo", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** Revert and Apply restore control points, and a record applied without PostEditUndo doesn't skip later full rebuilds. */
+bool FFurSplinesCombChangeUndoTest::RunTest(const FString& Parameters)
+{
+	using namespace FurEditorTest;
+	using namespace FurSplinesCombChangeTest;
+
+	UFurSplines* Splines = MakeSplines(60, 60, 5, 0.1f);
+	const TArray<FVector> Before = Splines->Vertices;
+	int32 NumCombed = 0;
+	TUniquePtr<FFurSplinesCombChange> Change = CombStroke(Splines, FVector(3.0f, 3.0f, 0.0f), 1.0f, NumCombed);
+	const TArray<FVector> After = Splines->Vertices;
+	if (!TestTrue(TEXT("Stroke recorded"), Change.IsValid()) || !TestTrue(TEXT("Stroke combed"), Before != After))
+		return false;
+
+	int32 NumChanged = 0;
+	int32 NumCombedBroadcasts = 0;
+	FDelegateHandle ChangedHandle = Splines->OnSplinesChanged.AddLambda([&NumChanged]() { NumChanged++; });
+	FDelegateHandle CombedHandle = Splines->OnSplinesCombed.AddLambda([&NumCombedBroadcasts](const TArray<uint32>&) { NumCombedBroadcasts++; });
+
+	Change->Revert(Splines);
+	TestTrue(TEXT("Revert restores the control points"), Splines->Vertices == Before);
+	Splines->PostEditUndo();
+	TestEqual(TEXT("Undo rebuilds the combed vertices only"), NumChanged, 0);
+
+	Change->Apply(Splines);
+	TestTrue(TEXT("Apply restores the combed control points"), Splines->Vertices == After);
+	TestEqual(TEXT("Fur of combed vertices rebuilt"), NumCombedBroadcasts, 2);
+
+	// a record applied in an earlier frame without PostEditUndo doesn't stop undo of another transaction from rebuilding all fur
+	Splines->CombUndoFrame = GFrameCounter - 1;
+	Splines->PostEditUndo();
+	TestEqual(TEXT("Full rebuild after a record without PostEditUndo"), NumChanged, 1);
+
+	Splines->OnSplinesChanged.Remove(ChangedHandle);
+	Splines->OnSplinesCombed.Remove(CombedHandle);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
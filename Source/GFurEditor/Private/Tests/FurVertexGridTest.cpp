@@ -0,0 +1,78 @@
+// Copyright 2023 GiM s.r.o. All Rights Reserved.
+
+#include "FurComb.h"
+#include "FurVertexGrid.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Rendering/PositionVertexBuffer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FurVertexGridTest
+{
+	/** Brush vertices as gathered before the grid, every vertex is tested against the brush mirrored into its octant. */
+	TArray<uint32> GatherReference(const TArray<FVector3f>& Positions, const FVector& Location, float Radius, bool MirrorX, bool MirrorY, bool MirrorZ)
+	{
+		TArray<uint32> Result;
+		for (int32 VertexIndex = 0; VertexIndex < Positions.Num(); VertexIndex++)
+		{
+			const FVector Position = FVector(Positions[VertexIndex]);
+			FVector Mirrored;
+			Mirrored.X = MirrorX && ((Position.X >= 0.0f) != (Location.X >= 0.0f)) ? -Location.X : Location.X;
+			Mirrored.Y = MirrorY && ((Position.Y >= 0.0f) != (Location.Y >= 0.0f)) ? -Location.Y : Location.Y;
+			Mirrored.Z = MirrorZ && ((Position.Z >= 0.0f) != (Location.Z >= 0.0f)) ? -Location.Z : Location.Z;
+			if (FVector::DistSquared(Position, Mirrored) <= Radius * Radius)
+				Result.Add(VertexIndex);
+		}
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFurVertexGridTest, "GFur.Editor.Comb.BrushVerticesMatchFullScan", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFurVertexGridTest::RunTest(const FString& Parameters)
+{
+	using namespace FurVertexGridTest;
+
+	FRandomStream Random(77);
+	TArray<FVector3f> Positions;
+	// a dense shell and a sparse cloud, some vertices lie on the mirror planes
+	for (int32 i = 0; i < 20000; i++)
+		Positions.Add(FVector3f(Random.GetUnitVector()) * 10.0f);
+	for (int32 i = 0; i < 5000; i++)
+		Positions.Add(FVector3f(Random.FRandRange(-30.0f, 30.0f), Random.FRandRange(-30.0f, 30.0f), Random.FRandRange(-30.0f, 30.0f)));
+	for (int32 i = 0; i < 300; i++)
+		Positions[Random.RandHelper(Positions.Num())][i % 3] = 0.0f;
+
+	FPositionVertexBuffer PositionBuffer;
+	PositionBuffer.Init(Positions);
+	FFurVertexGrid VertexGrid;
+	VertexGrid.Build(PositionBuffer);
+	TestEqual(TEXT("Vertex count"), VertexGrid.GetNumVertices(), Positions.Num());
+
+	FFurComb Comb;
+	for (int32 Dab = 0; Dab < 400; Dab++)
+	{
+		FVector Location = FVector(Random.GetUnitVector()) * Random.FRandRange(0.0f, 35.0f);
+		if (Dab % 10 == 0)
+			Location[Dab % 3] = 0.0;
+		// brushes from a fraction of a cell to larger than the mesh
+		const float Radius = Dab % 50 == 0 ? 100.0f : Random.FRandRange(0.05f, 8.0f);
+		const bool MirrorX = (Dab & 1) != 0;
+		const bool MirrorY = (Dab & 2) != 0;
+		const bool MirrorZ = (Dab & 4) != 0;
+
+		const TArray<uint32> Reference = GatherReference(Positions, Location, Radius, MirrorX, MirrorY, MirrorZ);
+		const TArray<uint32>& Gathered = Comb.GatherBrushVerticesForTest(VertexGrid, PositionBuffer, Location, Radius, MirrorX, MirrorY, MirrorZ);
+		if (!TestTrue(FString::Printf(TEXT("Dab %d gathers the same vertices in the same order"), Dab), Gathered == Reference))
+			return false;
+
+		TArray<uint32> Candidates;
+		VertexGrid.GatherCandidates(Location, Radius, Candidates);
+		TSet<uint32> UniqueCandidates(Candidates);
+		TestEqual(FString::Printf(TEXT("Dab %d candidates are unique"), Dab), UniqueCandidates.Num(), Candidates.Num());
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -4,6 +4,7 @@
 #include "FurSplinesTypeActions.h"
 #include "FurCombEdMode.h"
 #include "FurComponentCustomization.h"
+#include "FurSplineImporterFactory.h"
 
 #include "Styling/SlateStyleRegistry.h"
 
@@ -65,6 +66,9 @@ void FGFurEditorModule::ShutdownModule()
 {
 	FEditorModeRegistry::Get().UnregisterMode(FEdModeFurComb::EM_FurComb);
 
+	// the FBX SDK objects of a checked but not imported file
+	UFurSplineImporterFactory::ReleaseSceneCache();
+
 	/** De-register detail/property customization */
 	FPropertyEditorModule* PropertyModule = FModuleManager::GetModulePtr<FPropertyEditorModule>("PropertyEditor");
 	if (PropertyModule)